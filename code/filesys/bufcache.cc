@@ -0,0 +1,456 @@
+// bufcache.cc
+//	Routines to cache disk sectors in memory.  See bufcache.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "bufcache.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// BufferFlusher
+// 	Body of the flusher thread.  Need this to be a C routine, because
+//	C++ can't handle pointers to member functions.
+//----------------------------------------------------------------------
+
+static void
+BufferFlusher(int arg)
+{
+    BufferCache *cache = (BufferCache *) arg;
+    cache->FlusherLoop();
+}
+
+//----------------------------------------------------------------------
+// BufferReadAhead
+// 	Body of the read-ahead thread.
+//----------------------------------------------------------------------
+
+static void
+BufferReadAhead(int arg)
+{
+    BufferCache *cache = (BufferCache *) arg;
+    cache->ReadAheadLoop();
+}
+
+//----------------------------------------------------------------------
+// BufferCache::BufferCache
+// 	Initialize an empty cache, and start the read-ahead thread, and
+//	the flusher thread if there is to be one.  Must be called after
+//	"synchDisk" has been initialized.
+//
+//	"howMany" -- how many sectors to cache; 0 turns the cache off
+//	"interval" -- ticks between write-backs of all dirty
+//		sectors, 0 to write them back only when evicted or when
+//		Nachos halts
+//----------------------------------------------------------------------
+
+BufferCache::BufferCache(int howMany, int interval)
+{
+    NachOSThread *flusher, *reader;
+
+    ASSERT(howMany >= 0 && interval >= 0);
+    numBuffers = howMany;
+    flushInterval = interval;
+    buffers = new CacheBuffer[numBuffers];
+    for (int i = 0; i < numBuffers; i++) {
+	buffers[i].sector = buffers[i].oldSector = -1;
+	buffers[i].valid = buffers[i].dirty = buffers[i].busy = FALSE;
+	buffers[i].lastUse = 0;
+    }
+    clock = 0;
+    untimed = FALSE;
+    lock = new Lock("buffer cache");
+    bufferFree = new Condition("buffer free");
+    flushDue = new Semaphore("buffer flush", 0);
+    flusherWaiting = FALSE;
+    nextFlush = stats->totalTicks + flushInterval;
+    maxPrefetches = numBuffers / 2;
+    prefetches = new int[maxPrefetches];
+    firstPrefetch = numPrefetches = 0;
+    prefetchesQueued = new Semaphore("buffer read-ahead", 0);
+
+    // Neither thread is a process; do not wait for them to exit.
+    if (numBuffers > 0 && flushInterval > 0) {
+	flusher = new NachOSThread("buffer flusher");
+	exitThreadArray[flusher->GetPID()] = TRUE;
+	flusher->ThreadFork(BufferFlusher, (int) this);
+    }
+    if (maxPrefetches > 0) {
+	reader = new NachOSThread("buffer read-ahead");
+	exitThreadArray[reader->GetPID()] = TRUE;
+	reader->ThreadFork(BufferReadAhead, (int) this);
+    }
+}
+
+//----------------------------------------------------------------------
+// BufferCache::~BufferCache
+// 	Called when Nachos halts.  Write every dirty sector back, without
+//	waiting for the simulated disk, and de-allocate the cache.  The
+//	flusher thread, if any, is never woken again.
+//----------------------------------------------------------------------
+
+BufferCache::~BufferCache()
+{
+    for (int i = 0; i < numBuffers; i++)
+	if (buffers[i].valid && buffers[i].dirty) {
+	    DEBUG('f', "Writing back sector %d at halt\n", buffers[i].sector);
+	    synchDisk->WriteSectorUntimed(buffers[i].sector, buffers[i].data);
+	}
+    delete [] buffers;
+    delete bufferFree;
+    delete lock;
+    delete flushDue;
+    delete [] prefetches;
+    delete prefetchesQueued;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::StopTiming
+// 	Called when Nachos halts, before the file system writes back what
+//	it still holds in memory.  From now on, sectors that are not
+//	cached are read, and evicted sectors written, at once, without
+//	simulating the disk, since no thread can wait for it any more.
+//----------------------------------------------------------------------
+
+void
+BufferCache::StopTiming()
+{
+    untimed = TRUE;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::FindBuffer
+// 	Return the buffer holding "sectorNumber", or being written back
+//	from it, or NULL if there is none.  The caller holds the lock.
+//----------------------------------------------------------------------
+
+CacheBuffer *
+BufferCache::FindBuffer(int sectorNumber)
+{
+    for (int i = 0; i < numBuffers; i++)
+	if (buffers[i].sector == sectorNumber ||
+	    buffers[i].oldSector == sectorNumber)
+	    return &buffers[i];
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::GetBuffer
+// 	Return the buffer for "sectorNumber", marked busy.  If the sector
+//	is not cached, take an unused buffer or, failing that, the least
+//	recently used one, writing it back first if it is dirty; the
+//	buffer returned is then not valid.
+//
+//	While a buffer is being written back, its old sector cannot be
+//	used either, or it could be read from disk before the write.
+//----------------------------------------------------------------------
+
+CacheBuffer *
+BufferCache::GetBuffer(int sectorNumber)
+{
+    CacheBuffer *buffer, *victim;
+    int i, oldSector = -1;
+
+    lock->Acquire();
+    for (;;) {
+	buffer = FindBuffer(sectorNumber);
+	if (buffer != NULL && !buffer->busy && buffer->sector == sectorNumber)
+	    break;				// cached, and free
+	victim = NULL;
+	for (i = 0; i < numBuffers; i++)
+	    if (!buffers[i].busy && (victim == NULL ||
+		    (victim->valid && (!buffers[i].valid ||
+				       buffers[i].lastUse < victim->lastUse))))
+		victim = &buffers[i];
+	if (buffer == NULL && victim != NULL) {	// not cached; replace victim
+	    buffer = victim;
+	    if (buffer->valid) {
+		stats->numBufferCacheEvictions++;
+		if (buffer->dirty)
+		    oldSector = buffer->sector;
+	    }
+	    buffer->sector = sectorNumber;
+	    buffer->oldSector = oldSector;
+	    buffer->valid = FALSE;
+	    break;
+	}
+	bufferFree->Wait(lock);			// busy; try again when freed
+    }
+    buffer->busy = TRUE;
+    lock->Release();
+
+    if (oldSector != -1) {
+	DEBUG('f', "Evicting dirty sector %d for sector %d\n", oldSector,
+	      sectorNumber);
+	if (untimed)
+	    synchDisk->WriteSectorUntimed(oldSector, buffer->data);
+	else
+	    synchDisk->WriteSector(oldSector, buffer->data);
+	stats->numBufferCacheWriteBacks++;
+	buffer->oldSector = -1;
+	buffer->dirty = FALSE;
+    }
+    return buffer;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::ReleaseBuffer
+// 	Mark "buffer" free again, and wake up every thread waiting for a
+//	buffer; each will look again for the one it wants.
+//----------------------------------------------------------------------
+
+void
+BufferCache::ReleaseBuffer(CacheBuffer *buffer)
+{
+    lock->Acquire();
+    buffer->busy = FALSE;
+    bufferFree->Broadcast(lock);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// BufferCache::ReadSector
+// 	Read the contents of a disk sector into "data", from the cache if
+//	it is there, and otherwise from disk into the cache.
+//
+//	"sectorNumber" -- the disk sector to read
+//	"data" -- the buffer to hold the contents of the disk sector
+//----------------------------------------------------------------------
+
+void
+BufferCache::ReadSector(int sectorNumber, char *data)
+{
+    CacheBuffer *buffer;
+
+    if (numBuffers == 0) {
+	if (untimed)
+	    synchDisk->ReadSectorUntimed(sectorNumber, data);
+	else
+	    synchDisk->ReadSector(sectorNumber, data);
+	return;
+    }
+    buffer = GetBuffer(sectorNumber);
+    if (buffer->valid)
+	stats->numBufferCacheHits++;
+    else {
+	stats->numBufferCacheMisses++;
+	if (untimed)
+	    synchDisk->ReadSectorUntimed(sectorNumber, buffer->data);
+	else
+	    synchDisk->ReadSector(sectorNumber, buffer->data);
+	buffer->valid = TRUE;
+    }
+    bcopy(buffer->data, data, SectorSize);
+    buffer->lastUse = ++clock;
+    ReleaseBuffer(buffer);
+}
+
+//----------------------------------------------------------------------
+// BufferCache::WriteSector
+// 	Write "data" into the cached copy of a disk sector.  It reaches
+//	the disk later, when written back.
+//
+//	"sectorNumber" -- the disk sector to write
+//	"data" -- the new contents of the disk sector
+//----------------------------------------------------------------------
+
+void
+BufferCache::WriteSector(int sectorNumber, char *data)
+{
+    CacheBuffer *buffer;
+
+    if (numBuffers == 0) {
+	if (untimed)
+	    synchDisk->WriteSectorUntimed(sectorNumber, data);
+	else
+	    synchDisk->WriteSector(sectorNumber, data);
+	return;
+    }
+    buffer = GetBuffer(sectorNumber);
+    bcopy(data, buffer->data, SectorSize);
+    buffer->valid = buffer->dirty = TRUE;
+    buffer->lastUse = ++clock;
+    ReleaseBuffer(buffer);
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Prefetch
+// 	Ask the read-ahead thread to read a sector into the cache, and
+//	return at once.  Nothing is done if the sector is cached already,
+//	or the read-ahead queue is full.
+//
+//	"sectorNumber" -- the disk sector to read ahead
+//----------------------------------------------------------------------
+
+void
+BufferCache::Prefetch(int sectorNumber)
+{
+    lock->Acquire();
+    if (numPrefetches == maxPrefetches || FindBuffer(sectorNumber) != NULL) {
+	lock->Release();
+	return;
+    }
+    prefetches[(firstPrefetch + numPrefetches) % maxPrefetches] =
+	sectorNumber;
+    numPrefetches++;
+    lock->Release();
+    prefetchesQueued->V();
+}
+
+//----------------------------------------------------------------------
+// BufferCache::ReadAheadLoop
+// 	Body of the read-ahead thread: read each queued sector into the
+//	cache, unless it got there in the meantime.  Never returns.
+//
+//	Sectors queued one after the other, as they are by a sequential
+//	read, are taken together and read in one disk request, up to the
+//	first one that is cached already.  At most "maxPrefetches" buffers
+//	are held at a time, so that other threads can still get one.
+//----------------------------------------------------------------------
+
+void
+BufferCache::ReadAheadLoop()
+{
+    CacheBuffer *run[MaxTransferSectors], *buffer;
+    char *data[MaxTransferSectors];
+    int firstSector, count, i;
+
+    for (;;) {
+	prefetchesQueued->P();
+	lock->Acquire();
+	firstSector = prefetches[firstPrefetch];
+	firstPrefetch = (firstPrefetch + 1) % maxPrefetches;
+	numPrefetches--;
+	lock->Release();
+
+	buffer = GetBuffer(firstSector);
+	if (buffer->valid) {
+	    ReleaseBuffer(buffer);
+	    continue;
+	}
+	run[0] = buffer;
+	for (count = 1; count < MaxTransferSectors && count < maxPrefetches;
+								count++) {
+	    lock->Acquire();
+	    if (numPrefetches == 0 ||
+		prefetches[firstPrefetch] != firstSector + count) {
+		lock->Release();
+		break;
+	    }
+	    firstPrefetch = (firstPrefetch + 1) % maxPrefetches;
+	    numPrefetches--;
+	    lock->Release();
+	    prefetchesQueued->P();		// for the sector just taken
+
+	    buffer = GetBuffer(firstSector + count);
+	    if (buffer->valid) {
+		ReleaseBuffer(buffer);
+		break;
+	    }
+	    run[count] = buffer;
+	}
+
+	DEBUG('f', "Reading ahead sectors %d to %d\n", firstSector,
+	      firstSector + count - 1);
+	for (i = 0; i < count; i++)
+	    data[i] = run[i]->data;
+	synchDisk->ReadSectors(firstSector, count, data);
+	for (i = 0; i < count; i++) {
+	    run[i]->valid = TRUE;
+	    run[i]->lastUse = ++clock;
+	    stats->numBufferCacheReadAheads++;
+	    ReleaseBuffer(run[i]);
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Flush
+// 	Write every dirty sector back to disk, and on to the UNIX file if
+//	the disk maps it.  Buffers that are busy are
+//	skipped; they are dirty because of a write that is still going on,
+//	and will be written back by the next flush.
+//
+//	The dirty buffers are all taken at once and sorted by sector, so
+//	that each run of consecutive sectors goes to disk in one request.
+//	Each run's buffers are freed as soon as it is written.
+//----------------------------------------------------------------------
+
+void
+BufferCache::Flush()
+{
+    CacheBuffer **dirty = new CacheBuffer *[numBuffers];
+    CacheBuffer *buffer;
+    char *data[MaxTransferSectors];
+    int numDirty = 0, first, count, i, j;
+
+    lock->Acquire();
+    for (i = 0; i < numBuffers; i++) {
+	buffer = &buffers[i];
+	if (buffer->busy || !buffer->valid || !buffer->dirty)
+	    continue;
+	buffer->busy = TRUE;
+	buffer->dirty = FALSE;		// a write from now on dirties it again
+	for (j = numDirty; j > 0 && dirty[j - 1]->sector > buffer->sector; j--)
+	    dirty[j] = dirty[j - 1];
+	dirty[j] = buffer;
+	numDirty++;
+    }
+    lock->Release();
+
+    for (first = 0; first < numDirty; first += count) {
+	for (count = 1; first + count < numDirty &&
+		 count < MaxTransferSectors &&
+		 dirty[first + count]->sector == dirty[first]->sector + count;
+	     count++)
+	    ;
+	for (i = 0; i < count; i++)
+	    data[i] = dirty[first + i]->data;
+	synchDisk->WriteSectors(dirty[first]->sector, count, data);
+	stats->numBufferCacheWriteBacks += count;
+	for (i = 0; i < count; i++)
+	    ReleaseBuffer(dirty[first + i]);
+    }
+    if (numDirty > 0)
+	synchDisk->Flush();		// in case the disk image is mapped
+    DEBUG('f', "Flushed %d dirty sectors at tick %d\n", numDirty,
+	  stats->totalTicks);
+    delete [] dirty;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::TimerTick
+// 	Called by the timer interrupt handler, with interrupts off.  Once
+//	"flushInterval" ticks have passed since the last flush, wake the
+//	flusher up, unless it is still busy with the last one.
+//----------------------------------------------------------------------
+
+void
+BufferCache::TimerTick()
+{
+    if (flushInterval == 0 || stats->totalTicks < nextFlush)
+	return;
+    nextFlush = stats->totalTicks + flushInterval;
+    if (flusherWaiting) {
+	flusherWaiting = FALSE;
+	flushDue->V();
+    }
+}
+
+//----------------------------------------------------------------------
+// BufferCache::FlusherLoop
+// 	Body of the flusher thread: write back every dirty sector each
+//	time a flush is due.  Never returns.
+//----------------------------------------------------------------------
+
+void
+BufferCache::FlusherLoop()
+{
+    for (;;) {
+	flusherWaiting = TRUE;
+	flushDue->P();
+	Flush();
+    }
+}
@@ -0,0 +1,114 @@
+// bufcache.h
+//	Data structures for a cache of disk sectors, kept in memory in
+//	front of the synchronous disk.
+//
+//	The file system reads and writes whole sectors through the cache
+//	rather than through "synchDisk".  A read of a cached sector, and
+//	any write, cost no disk access: a write just marks the cached copy
+//	dirty.  Dirty sectors go to disk when their buffer is reused for
+//	another sector (least recently used first), when the flusher
+//	thread wakes up (every "flushInterval" ticks, if not 0), and when
+//	Nachos halts.
+//
+//	Sectors can also be read into the cache ahead of time, by a
+//	read-ahead thread, so that a thread reading a file sequentially
+//	finds the next sectors there.  At most half the buffers can be
+//	waiting to be read ahead at any time, so that read-ahead does not
+//	push everything else out of the cache.
+//
+//	Both the flusher and the read-ahead thread move runs of
+//	consecutive sectors in a single disk request where they can,
+//	which costs one seek and rotational delay rather than one each.
+//
+//	A buffer is "busy" while a thread copies into or out of it, or
+//	while it is being read or written back, which may mean waiting for
+//	the disk; other threads that want it wait until it is free again.
+//	The lock protects the buffers' fields other than "data", and is
+//	not held while waiting for the disk.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef BUFCACHE_H
+#define BUFCACHE_H
+
+#include "copyright.h"
+#include "disk.h"
+#include "synch.h"
+
+#define BufferCacheSize		64	// default number of buffers
+#define BufferFlushInterval	100000	// default ticks between flushes
+
+// The following class defines one buffer of the cache.  Kept public so
+// that BufferCache can access the fields directly.
+
+class CacheBuffer {
+  public:
+    int sector;			// the sector held, -1 if none
+    int oldSector;		// the sector being written back to make
+				// room for "sector", -1 if none
+    bool valid;			// "data" holds the contents of "sector"
+    bool dirty;			// ... which are newer than those on disk
+    bool busy;			// in use; wait until it is free
+    int lastUse;		// when it was last used, for LRU
+    char data[SectorSize];
+};
+
+// The following class defines the cache.
+
+class BufferCache {
+  public:
+    BufferCache(int howMany, int interval);
+				// Initialize an empty cache of "howMany"
+				// sectors; if "interval" > 0, start
+				// a thread to write dirty sectors back
+				// that often
+    ~BufferCache();		// Write back every dirty sector, and
+				// de-allocate the cache
+
+    void ReadSector(int sectorNumber, char *data);
+    void WriteSector(int sectorNumber, char *data);
+				// Same as SynchDisk::ReadSector and
+				// WriteSector, but through the cache
+
+    void Prefetch(int sectorNumber);
+				// Read a sector into the cache in the
+				// background, if it is not there yet
+
+    void Flush();		// Write back every dirty sector
+    void StopTiming();		// Called when Nachos halts: from now on,
+				// go to the disk at once, without waiting
+    void TimerTick();		// Called on timer interrupts; wake the
+				// flusher when a flush is due
+    void FlusherLoop();		// Body of the flusher thread
+    void ReadAheadLoop();	// Body of the read-ahead thread
+
+  private:
+    CacheBuffer *buffers;	// the buffers
+    int numBuffers;
+    int flushInterval;		// ticks between flushes, 0 if none
+    int nextFlush;		// when the next flush is due
+    int clock;			// counts uses, for LRU
+    bool untimed;		// halting; no thread may wait for the disk
+    Lock *lock;			// protects the buffers
+    Condition *bufferFree;	// signalled when a buffer stops being busy
+    Semaphore *flushDue;	// the flusher waits on this
+    bool flusherWaiting;	// ... and is waiting now
+    int *prefetches;		// circular queue of sectors to read ahead
+    int maxPrefetches;		// its size
+    int firstPrefetch;		// index of the oldest sector in it
+    int numPrefetches;		// number of sectors in it
+    Semaphore *prefetchesQueued;	// the read-ahead thread waits on this
+
+    CacheBuffer *FindBuffer(int sectorNumber);
+				// The buffer holding "sectorNumber", or
+				// being written back from it; NULL if none
+    CacheBuffer *GetBuffer(int sectorNumber);
+				// Find the buffer holding "sectorNumber",
+				// or make one, and mark it busy
+    void ReleaseBuffer(CacheBuffer *buffer);
+				// Mark "buffer" free, and wake the waiters
+};
+
+#endif // BUFCACHE_H
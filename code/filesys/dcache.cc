@@ -0,0 +1,125 @@
+// dcache.cc
+//	Routines to cache path name lookups.  See dcache.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "dcache.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// DirectoryCache::DirectoryCache
+// 	Initialize an empty cache.
+//
+//	"size" -- the number of paths to cache
+//----------------------------------------------------------------------
+
+DirectoryCache::DirectoryCache(int size)
+{
+    numEntries = size;
+    entries = new DirCacheEntry[size];
+    for (int i = 0; i < numEntries; i++) {
+	entries[i].valid = FALSE;
+	entries[i].lastUse = 0;
+    }
+    clock = 0;
+}
+
+//----------------------------------------------------------------------
+// DirectoryCache::~DirectoryCache
+// 	De-allocate the cache.
+//----------------------------------------------------------------------
+
+DirectoryCache::~DirectoryCache()
+{
+    delete [] entries;
+}
+
+//----------------------------------------------------------------------
+// DirectoryCache::FindIndex
+// 	Return the entry holding "path", or -1 if it is not cached.
+//----------------------------------------------------------------------
+
+int
+DirectoryCache::FindIndex(char *path)
+{
+    for (int i = 0; i < numEntries; i++)
+	if (entries[i].valid && !strcmp(entries[i].path, path))
+	    return i;
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// DirectoryCache::Find
+// 	Look "path" up in the cache.  Return FALSE if it is not there.
+//	Otherwise return TRUE, with the sector of its file header in
+//	"sector" -- -1 if there is no such file -- and whether it is a
+//	directory in "isDirectory".
+//----------------------------------------------------------------------
+
+bool
+DirectoryCache::Find(char *path, int *sector, bool *isDirectory)
+{
+    int i = FindIndex(path);
+
+    if (i == -1)
+	return FALSE;
+    entries[i].lastUse = ++clock;
+    *sector = entries[i].sector;
+    *isDirectory = entries[i].isDirectory;
+    DEBUG('f', "Path %s is cached, sector %d\n", path, *sector);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// DirectoryCache::Enter
+// 	Remember where the file header of "path" is, or that there is no
+//	such file, replacing what was known about it.  If "path" is not
+//	cached yet, it takes a free entry or, failing that, the least
+//	recently used one.
+//
+//	"path" -- the path looked up
+//	"sector" -- the sector of its file header, or -1 if not found
+//	"isDirectory" -- whether it is a directory
+//----------------------------------------------------------------------
+
+void
+DirectoryCache::Enter(char *path, int sector, bool isDirectory)
+{
+    int i = FindIndex(path), victim;
+
+    ASSERT(strlen(path) <= PathNameMaxLen);
+    if (i == -1) {
+	victim = 0;
+	for (i = 0; i < numEntries; i++)
+	    if (!entries[i].valid ||
+		(entries[victim].valid &&
+		 entries[i].lastUse < entries[victim].lastUse))
+		victim = i;
+	i = victim;
+	entries[i].valid = TRUE;
+	strcpy(entries[i].path, path);
+    }
+    entries[i].sector = sector;
+    entries[i].isDirectory = isDirectory;
+    entries[i].lastUse = ++clock;
+}
+
+//----------------------------------------------------------------------
+// DirectoryCache::Invalidate
+// 	Forget "path", and every path below it; called when it is
+//	removed.
+//----------------------------------------------------------------------
+
+void
+DirectoryCache::Invalidate(char *path)
+{
+    int length = strlen(path);
+
+    for (int i = 0; i < numEntries; i++)
+	if (entries[i].valid && !strncmp(entries[i].path, path, length) &&
+	    (entries[i].path[length] == '\0' || entries[i].path[length] == '/'))
+	    entries[i].valid = FALSE;
+}
@@ -0,0 +1,73 @@
+// dcache.h
+//	Data structures for a cache of path name lookups, kept in memory
+//	in front of the directories.
+//
+//	Finding the file header of "a/b/c" means reading the root
+//	directory, then "a", then "a/b".  The cache remembers, for each
+//	path looked up recently, the sector of its file header, and
+//	whether it is a directory.  It also remembers paths that were not
+//	found, so that looking for a missing file again costs no
+//	directory reads either.  Since the parent of a path is looked up
+//	(and cached) on the way, a miss on "a/b/c" usually only has to
+//	read "a/b".
+//
+//	The file system keeps the cache up to date: creating a path
+//	replaces whatever the cache says about it, and removing one
+//	forgets it, and every path below it.
+//
+//	Paths are cached as given to the cache, without leading or
+//	doubled slashes, and no longer than PathNameMaxLen.  When the
+//	cache is full, the least recently used entry is replaced.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef DCACHE_H
+#define DCACHE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+#define DirCacheSize	64		// number of paths cached
+#define PathNameMaxLen	127		// longest path
+
+// The following class defines one entry of the cache.  Kept public so
+// that DirectoryCache can access the fields directly.
+
+class DirCacheEntry {
+  public:
+    bool valid;				// Does the entry hold a path?
+    int sector;				// Sector of its file header, or -1
+					// if there is no such file
+    bool isDirectory;			// Is it a directory?
+    int lastUse;			// When it was last used, for LRU
+    char path[PathNameMaxLen + 1];
+};
+
+// The following class defines the cache.
+
+class DirectoryCache {
+  public:
+    DirectoryCache(int size);		// Initialize an empty cache of
+					// "size" paths
+    ~DirectoryCache();
+
+    bool Find(char *path, int *sector, bool *isDirectory);
+					// If "path" is cached, return TRUE,
+					// with where its header is (-1 if it
+					// does not exist), and its kind
+    void Enter(char *path, int sector, bool isDirectory);
+					// Remember what "path" is
+    void Invalidate(char *path);	// Forget "path", and every path
+					// below it
+
+  private:
+    DirCacheEntry *entries;
+    int numEntries;
+    int clock;				// counts uses, for LRU
+
+    int FindIndex(char *path);		// The entry for "path", or -1
+};
+
+#endif // DCACHE_H
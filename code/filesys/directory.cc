@@ -11,10 +11,11 @@
 //	we use ReadFrom/WriteBack to fetch the contents of the directory
 //	from disk, and to write back any modifications back to disk.
 //
-//	Also, this implementation has the restriction that the size
-//	of the directory cannot expand.  In other words, once all the
-//	entries in the directory are used, no more files can be created.
-//	Fixing this is one of the parts to the assignment.
+//	The table is a hash table with linear probing.  A removed entry
+//	is marked deleted rather than free, so that lookups carry on past
+//	it; deleted entries are reused by Add, and cleared out when the
+//	table is re-hashed.  Once the table is three quarters full, Add
+//	fails until Grow has made it bigger.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -38,9 +39,14 @@
 Directory::Directory(int size)
 {
     table = new DirectoryEntry[size];
+    dirty = new bool[size];
     tableSize = size;
-    for (int i = 0; i < tableSize; i++)
-	table[i].inUse = FALSE;
+    for (int i = 0; i < tableSize; i++) {
+	table[i].inUse = table[i].deleted = FALSE;
+	dirty[i] = TRUE;
+    }
+    sizeChanged = TRUE;
+    numInUse = numDeleted = 0;
 }
 
 //----------------------------------------------------------------------
@@ -51,6 +57,7 @@ Directory::Directory(int size)
 Directory::~Directory()
 { 
     delete [] table;
+    delete [] dirty;
 } 
 
 //----------------------------------------------------------------------
@@ -63,12 +70,33 @@ Directory::~Directory()
 void
 Directory::FetchFrom(OpenFile *file)
 {
-    (void) file->ReadAt((char *)table, tableSize * sizeof(DirectoryEntry), 0);
+    int size;
+
+    (void) file->ReadAt((char *) &size, sizeof(int), 0);
+    if (size != tableSize) {
+	delete [] table;
+	delete [] dirty;
+	table = new DirectoryEntry[size];
+	dirty = new bool[size];
+	tableSize = size;
+    }
+    (void) file->ReadAt((char *)table, tableSize * sizeof(DirectoryEntry),
+			DirectoryTableOffset);
+    numInUse = numDeleted = 0;
+    for (int i = 0; i < tableSize; i++) {
+	dirty[i] = FALSE;
+	if (table[i].inUse)
+	    numInUse++;
+	else if (table[i].deleted)
+	    numDeleted++;
+    }
+    sizeChanged = FALSE;
 }
 
 //----------------------------------------------------------------------
 // Directory::WriteBack
-// 	Write any modifications to the directory back to disk
+// 	Write any modifications to the directory back to disk.  Only the
+//	entries that have changed are written, each run of them at once.
 //
 //	"file" -- file to contain the new directory contents
 //----------------------------------------------------------------------
@@ -76,7 +104,40 @@ Directory::FetchFrom(OpenFile *file)
 void
 Directory::WriteBack(OpenFile *file)
 {
-    (void) file->WriteAt((char *)table, tableSize * sizeof(DirectoryEntry), 0);
+    int i, j;
+
+    if (sizeChanged)
+	(void) file->WriteAt((char *) &tableSize, sizeof(int), 0);
+    for (i = 0; i < tableSize; i = j) {
+	if (!dirty[i]) {
+	    j = i + 1;
+	    continue;
+	}
+	for (j = i; j < tableSize && dirty[j]; j++)
+	    dirty[j] = FALSE;
+	(void) file->WriteAt((char *) &table[i],
+			     (j - i) * sizeof(DirectoryEntry),
+			     DirectoryTableOffset + i * sizeof(DirectoryEntry));
+    }
+    sizeChanged = FALSE;
+}
+
+//----------------------------------------------------------------------
+// Directory::Hash
+// 	Return the entry of the table at which to start looking for a
+//	file name.
+//
+//	"name" -- the file name
+//----------------------------------------------------------------------
+
+int
+Directory::Hash(char *name)
+{
+    unsigned int hash = 0;
+
+    for (int i = 0; i < FileNameMaxLen && name[i] != '\0'; i++)
+	hash = 31 * hash + (unsigned char) name[i];
+    return hash % tableSize;
 }
 
 //----------------------------------------------------------------------
@@ -90,9 +151,15 @@ Directory::WriteBack(OpenFile *file)
 int
 Directory::FindIndex(char *name)
 {
-    for (int i = 0; i < tableSize; i++)
+    int i = Hash(name);
+
+    for (int probes = 0; probes < tableSize; probes++) {
+	if (!table[i].inUse && !table[i].deleted)
+	    break;		// never used; the name would be before it
         if (table[i].inUse && !strncmp(table[i].name, name, FileNameMaxLen))
 	    return i;
+	i = (i + 1) % tableSize;
+    }
     return -1;		// name not in directory
 }
 
@@ -119,27 +186,142 @@ Directory::Find(char *name)
 // Directory::Add
 // 	Add a file into the directory.  Return TRUE if successful;
 //	return FALSE if the file name is already in the directory, or if
-//	the directory is completely full, and has no more space for
-//	additional file names.
+//	the directory is too full; see IsFull and Grow.
 //
 //	"name" -- the name of the file being added
 //	"newSector" -- the disk sector containing the added file's header
+//	"isDirectory" -- whether the file is a directory
 //----------------------------------------------------------------------
 
 bool
-Directory::Add(char *name, int newSector)
+Directory::Add(char *name, int newSector, bool isDirectory)
 { 
-    if (FindIndex(name) != -1)
+    int i;
+
+    if (FindIndex(name) != -1 || IsFull())
 	return FALSE;
 
-    for (int i = 0; i < tableSize; i++)
-        if (!table[i].inUse) {
-            table[i].inUse = TRUE;
-            strncpy(table[i].name, name, FileNameMaxLen); 
-            table[i].sector = newSector;
-        return TRUE;
+    for (i = Hash(name); table[i].inUse; i = (i + 1) % tableSize)
+	;
+    if (table[i].deleted)
+	numDeleted--;
+    table[i].inUse = TRUE;
+    table[i].deleted = FALSE;
+    strncpy(table[i].name, name, FileNameMaxLen);
+    table[i].sector = newSector;
+    table[i].isDirectory = isDirectory;
+    dirty[i] = TRUE;
+    numInUse++;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Directory::IsDirectory
+// 	Return TRUE if file "name" is in the directory, and is itself a
+//	directory.
+//
+//	"name" -- the file name to look up
+//----------------------------------------------------------------------
+
+bool
+Directory::IsDirectory(char *name)
+{
+    int i = FindIndex(name);
+
+    return (i != -1 && table[i].isDirectory);
+}
+
+//----------------------------------------------------------------------
+// Directory::IsEmpty
+// 	Return TRUE if there are no files in the directory.
+//----------------------------------------------------------------------
+
+bool
+Directory::IsEmpty()
+{
+    return (numInUse == 0);
+}
+
+//----------------------------------------------------------------------
+// Directory::IsFull
+// 	Return TRUE if adding another name would make the table more than
+//	three quarters full, counting deleted entries, which also make
+//	lookups longer.
+//----------------------------------------------------------------------
+
+bool
+Directory::IsFull()
+{
+    return 4 * (numInUse + numDeleted + 1) > 3 * tableSize;
+}
+
+//----------------------------------------------------------------------
+// Directory::Grow
+// 	Re-hash the table, doubling its size until it is no more than half
+//	full, and write it back to "file".  Return FALSE, leaving the
+//	directory as it was, if the disk has no room for the bigger table.
+//
+//	The file is grown first, and its new length written back, so that
+//	the directory on disk is never left half re-hashed.
+//
+//	"file" -- file containing the directory contents
+//----------------------------------------------------------------------
+
+bool
+Directory::Grow(OpenFile *file)
+{
+    int newSize = tableSize, oldLength = file->Length(), newLength, written;
+    char *zeros;
+
+    while (4 * (numInUse + 1) > 2 * newSize)
+	newSize *= 2;
+    newLength = DirectoryTableOffset + newSize * sizeof(DirectoryEntry);
+    if (newLength > oldLength) {
+	zeros = new char[newLength - oldLength];
+	bzero(zeros, newLength - oldLength);
+	written = file->WriteAt(zeros, newLength - oldLength, oldLength);
+	delete [] zeros;
+	if (written != newLength - oldLength)
+	    return FALSE;
+	file->Flush();
+    }
+    Resize(newSize);
+    WriteBack(file);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Directory::Resize
+// 	Move every name in use into a fresh table of "newSize" entries,
+//	leaving out the deleted ones.
+//----------------------------------------------------------------------
+
+void
+Directory::Resize(int newSize)
+{
+    DirectoryEntry *oldTable = table;
+    int oldSize = tableSize, i, j;
+
+    DEBUG('f', "Re-hashing the directory, %d files, into %d entries\n",
+	  numInUse, newSize);
+    table = new DirectoryEntry[newSize];
+    delete [] dirty;
+    dirty = new bool[newSize];
+    tableSize = newSize;
+    for (i = 0; i < tableSize; i++) {
+	table[i].inUse = table[i].deleted = FALSE;
+	dirty[i] = TRUE;
+    }
+    for (i = 0; i < oldSize; i++)
+	if (oldTable[i].inUse) {
+	    for (j = Hash(oldTable[i].name); table[j].inUse;
+		 j = (j + 1) % tableSize)
+		;
+	    table[j] = oldTable[i];
 	}
-    return FALSE;	// no space.  Fix when we have extensible files.
+    delete [] oldTable;
+    sizeChanged = TRUE;
+    numDeleted = 0;
 }
 
 //----------------------------------------------------------------------
@@ -158,6 +340,10 @@ Directory::Remove(char *name)
     if (i == -1)
 	return FALSE; 		// name not in directory
     table[i].inUse = FALSE;
+    table[i].deleted = TRUE;
+    dirty[i] = TRUE;
+    numInUse--;
+    numDeleted++;
     return TRUE;	
 }
 
@@ -171,7 +357,7 @@ Directory::List()
 {
    for (int i = 0; i < tableSize; i++)
 	if (table[i].inUse)
-	    printf("%s\n", table[i].name);
+	    printf("%s%s\n", table[i].name, table[i].isDirectory ? "/" : "");
 }
 
 //----------------------------------------------------------------------
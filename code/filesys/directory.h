@@ -6,6 +6,11 @@
 //	where to find its file header (the data structure describing
 //	where to find the file's data blocks) on disk.
 //
+//	The table is a hash table, with open addressing: a name is kept
+//	in the first free entry at or after the one its hash picks, so
+//	that a lookup only looks at a few entries, however many files
+//	there are.  When the table gets three quarters full, it grows.
+//
 //      We assume mutual exclusion is provided by the caller.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
@@ -19,8 +24,11 @@
 
 #include "openfile.h"
 
-#define FileNameMaxLen 		9	// for simplicity, we assume 
-					// file names are <= 9 characters long
+#define FileNameMaxLen 		31	// for simplicity, we assume
+					// file names are <= 31 characters long
+#define DirectoryTableOffset	sizeof(int)
+					// where the table starts in the
+					// file, after its size
 
 // The following class defines a "directory entry", representing a file
 // in the directory.  Each entry gives the name of the file, and where
@@ -32,6 +40,10 @@
 class DirectoryEntry {
   public:
     bool inUse;				// Is this directory entry in use?
+    bool deleted;			// Was it in use?  If so, names that
+					// hashed to an earlier entry may
+					// come after it
+    bool isDirectory;			// Is the file itself a directory?
     int sector;				// Location on disk to find the 
 					//   FileHeader for this file 
     char name[FileNameMaxLen + 1];	// Text name for file, with +1 for 
@@ -39,14 +51,17 @@ class DirectoryEntry {
 };
 
 // The following class defines a UNIX-like "directory".  Each entry in
-// the directory describes a file, and where to find it on disk.
+// the directory describes a file, and where to find it on disk.  The
+// file may be a directory in turn, so that directories form a tree.
 //
 // The directory data structure can be stored in memory, or on disk.
-// When it is on disk, it is stored as a regular Nachos file.
+// When it is on disk, it is stored as a regular Nachos file: the number
+// of entries in the table, then the table.
 //
 // The constructor initializes a directory structure in memory; the
 // FetchFrom/WriteBack operations shuffle the directory information
-// from/to disk. 
+// from/to disk.  WriteBack only writes the entries changed since
+// the last FetchFrom or WriteBack.
 
 class Directory {
   public:
@@ -61,7 +76,12 @@ class Directory {
     int Find(char *name);		// Find the sector number of the 
 					// FileHeader for file: "name"
 
-    bool Add(char *name, int newSector);  // Add a file name into the directory
+    bool Add(char *name, int newSector, bool isDirectory);
+					// Add a file name into the directory
+    bool IsDirectory(char *name);	// Is file "name" a directory?
+    bool IsEmpty();			// Are there no files in it?
+    bool IsFull();			// Is the table too full to Add to?
+    bool Grow(OpenFile *file);		// Make the table, and "file", bigger
 
     bool Remove(char *name);		// Remove a file from the directory
 
@@ -75,9 +95,16 @@ class Directory {
     int tableSize;			// Number of directory entries
     DirectoryEntry *table;		// Table of pairs: 
 					// <file name, file header location> 
+    bool *dirty;			// Which entries have changed
+    bool sizeChanged;			// Has "tableSize" changed?
+    int numInUse;			// Entries in use
+    int numDeleted;			// Entries deleted, and not reused
 
     int FindIndex(char *name);		// Find the index into the directory 
 					//  table corresponding to "name"
+    int Hash(char *name);		// Where to start looking for "name"
+    void Resize(int newSize);		// Re-hash into a table of "newSize"
+					//  entries
 };
 
 #endif // DIRECTORY_H
@@ -3,12 +3,16 @@
 //	would be called the i-node).
 //
 //	The file header is used to locate where on disk the 
-//	file's data is stored.  We implement this as a fixed size
-//	table of pointers -- each entry in the table points to the 
-//	disk sector containing that portion of the file data
-//	(in other words, there are no indirect or doubly indirect 
-//	blocks). The table size is chosen so that the file header
-//	will be just big enough to fit in one disk sector, 
+//	file's data is stored.  We implement this as a list of extents --
+//	each extent is a run of consecutive sectors holding the next
+//	portion of the file data.  The first extents are kept in the
+//	header sector itself, the next ones in an indirect block, and the
+//	rest in indirect blocks listed by a doubly indirect block.
+//
+//	Data sectors are allocated in runs that are as long as possible,
+//	each carrying on from the last if the sectors after it are free,
+//	so that a file is usually contiguous on disk, and needs only a
+//	few extents.
 //
 //      Unlike in a real system, we do not keep track of file permissions, 
 //	ownership, last modification date, etc., in the file header. 
@@ -27,33 +31,249 @@
 #include "system.h"
 #include "filehdr.h"
 
+//----------------------------------------------------------------------
+// FileHeader::FileHeader
+// 	Initialize an empty file header, of a file with no data.
+//----------------------------------------------------------------------
+
+FileHeader::FileHeader()
+{
+    ASSERT(sizeof(RawFileHeader) <= SectorSize);
+    numBytes = numSectors = numExtents = maxExtents = 0;
+    extents = NULL;
+    indirect = doubleIndirect = -1;
+    for (unsigned i = 0; i < NumIndirectBlocks; i++)
+	indirectBlocks[i] = -1;
+}
+
+//----------------------------------------------------------------------
+// FileHeader::~FileHeader
+// 	De-allocate the in-memory file header.
+//----------------------------------------------------------------------
+
+FileHeader::~FileHeader()
+{
+    delete [] extents;
+}
+
 //----------------------------------------------------------------------
 // FileHeader::Allocate
 // 	Initialize a fresh file header for a newly created file.
 //	Allocate data blocks for the file out of the map of free disk blocks.
 //	Return FALSE if there are not enough free blocks to accomodate
-//	the new file.
+//	the new file, or the free blocks are too scattered.
 //
 //	"freeMap" is the bit map of free disk sectors
-//	"fileSize" is the bit map of free disk sectors
+//	"fileSize" is the size of the new file, in bytes
 //----------------------------------------------------------------------
 
 bool
 FileHeader::Allocate(BitMap *freeMap, int fileSize)
 { 
     numBytes = fileSize;
-    numSectors  = divRoundUp(fileSize, SectorSize);
-    if (freeMap->NumClear() < numSectors)
+    if (freeMap->NumClear() < divRoundUp(fileSize, SectorSize))
 	return FALSE;		// not enough space
 
-    for (int i = 0; i < numSectors; i++)
-	dataSectors[i] = freeMap->Find();
+    if (!AddSectors(freeMap, divRoundUp(fileSize, SectorSize))) {
+	Deallocate(freeMap);	// too scattered; give back what we got
+	return FALSE;
+    }
     return TRUE;
 }
 
+//----------------------------------------------------------------------
+// FileHeader::AddSectors
+// 	Allocate "count" data sectors at the end of the file, in as few
+//	runs as possible, starting right after the last sector if it can.
+//	Then allocate any indirect blocks needed for the new extents.
+//	Return FALSE if the disk is full, or the file has run out of
+//	extents.
+//
+//	"freeMap" is the bit map of free disk sectors
+//	"count" is the number of sectors to add
+//----------------------------------------------------------------------
+
+bool
+FileHeader::AddSectors(BitMap *freeMap, int count)
+{
+    int goal, start, length;
+
+    while (count > 0) {
+	goal = -1;
+	if (numExtents > 0)
+	    goal = extents[numExtents - 1].start +
+		   extents[numExtents - 1].length;
+	start = freeMap->FindRun(goal, count, &length);
+	if (start == -1)
+	    return FALSE;		// disk full
+	if (start != goal && numExtents == (int) MaxExtents) {
+	    for (int i = 0; i < length; i++)
+		freeMap->Clear(start + i);
+	    return FALSE;		// no extent left to describe it
+	}
+	DEBUG('f', "Allocated sectors %d to %d\n", start, start + length - 1);
+	AddExtent(start, length);
+	numSectors += length;
+	count -= length;
+    }
+    return AllocateIndirect(freeMap);
+}
+
+//----------------------------------------------------------------------
+// FileHeader::AddExtent
+// 	Append the run of "length" sectors starting at "start" to the
+//	file, growing the last extent if the run carries on from it.
+//----------------------------------------------------------------------
+
+void
+FileHeader::AddExtent(int start, int length)
+{
+    Extent *old;
+
+    if (numExtents > 0 &&
+	extents[numExtents - 1].start + extents[numExtents - 1].length == start) {
+	extents[numExtents - 1].length += length;
+	return;
+    }
+    if (numExtents == maxExtents) {	// make room for more
+	old = extents;
+	maxExtents = min(max(2 * maxExtents, (int) NumDirectExtents),
+			 (int) MaxExtents);
+	extents = new Extent[maxExtents];
+	for (int i = 0; i < numExtents; i++)
+	    extents[i] = old[i];
+	delete [] old;
+    }
+    extents[numExtents].start = start;
+    extents[numExtents].length = length;
+    numExtents++;
+}
+
+//----------------------------------------------------------------------
+// FileHeader::AllocateIndirect
+// 	Allocate whichever indirect blocks the file does not have yet, but
+//	needs to hold "numExtents" extents.  Return FALSE if the disk is
+//	full.
+//----------------------------------------------------------------------
+
+bool
+FileHeader::AllocateIndirect(BitMap *freeMap)
+{
+    int numBlocks;
+
+    if (numExtents > (int) NumDirectExtents && indirect == -1 &&
+	    (indirect = freeMap->Find()) == -1)
+	return FALSE;
+    if (numExtents <= (int) (NumDirectExtents + ExtentsPerBlock))
+	return TRUE;
+    if (doubleIndirect == -1 && (doubleIndirect = freeMap->Find()) == -1)
+	return FALSE;
+    numBlocks = divRoundUp(numExtents - NumDirectExtents - ExtentsPerBlock,
+			   ExtentsPerBlock);
+    for (int i = 0; i < numBlocks; i++)
+	if (indirectBlocks[i] == -1 &&
+		(indirectBlocks[i] = freeMap->Find()) == -1)
+	    return FALSE;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// FileHeader::Extend
+// 	Allocate data sectors for the file to grow to "newSize" bytes,
+//	plus a batch more, so that a file growing by small writes gets
+//	its sectors in long runs.  If the disk is too full for the batch,
+//	allocate just what is needed.  The length of the file is not
+//	changed; see SetLength.
+//
+//	Return FALSE, having allocated nothing, if there is not enough
+//	room on disk.
+//
+//	"freeMap" is the bit map of free disk sectors
+//	"newSize" is the length the file is to have, in bytes
+//----------------------------------------------------------------------
+
+bool
+FileHeader::Extend(BitMap *freeMap, int newSize)
+{
+    int oldSectors = numSectors;
+    int wanted = divRoundUp(newSize, SectorSize) - numSectors;
+    int batch = max(wanted, min(max(numSectors, MinGrowSectors),
+				MaxGrowSectors));
+
+    if (wanted <= 0)
+	return TRUE;
+    if (AddSectors(freeMap, batch))
+	return TRUE;
+    ReleaseSectors(freeMap, oldSectors);
+    if (batch > wanted && AddSectors(freeMap, wanted))
+	return TRUE;
+    ReleaseSectors(freeMap, oldSectors);
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// FileHeader::Trim
+// 	De-allocate the sectors allocated beyond the end of the file, as
+//	it grew.
+//
+//	"freeMap" is the bit map of free disk sectors
+//----------------------------------------------------------------------
+
+void
+FileHeader::Trim(BitMap *freeMap)
+{
+    ReleaseSectors(freeMap, divRoundUp(numBytes, SectorSize));
+}
+
+//----------------------------------------------------------------------
+// FileHeader::ReleaseSectors
+// 	De-allocate the data sectors of the file after the first "keep",
+//	from the last one back, and then the indirect blocks that are no
+//	longer needed to hold its extents.
+//
+//	"freeMap" is the bit map of free disk sectors
+//	"keep" is the number of data sectors to keep
+//----------------------------------------------------------------------
+
+void
+FileHeader::ReleaseSectors(BitMap *freeMap, int keep)
+{
+    Extent *last;
+    int count, numBlocks = 0, i;
+
+    while (numSectors > keep) {
+	last = &extents[numExtents - 1];
+	count = min(numSectors - keep, last->length);
+	last->length -= count;
+	numSectors -= count;
+	for (i = 0; i < count; i++)
+	    freeMap->Clear(last->start + last->length + i);
+	if (last->length == 0)
+	    numExtents--;
+    }
+
+    if (numExtents > (int) (NumDirectExtents + ExtentsPerBlock))
+	numBlocks = divRoundUp(numExtents - NumDirectExtents - ExtentsPerBlock,
+			       ExtentsPerBlock);
+    for (i = numBlocks; i < (int) NumIndirectBlocks; i++)
+	if (indirectBlocks[i] != -1) {
+	    freeMap->Clear(indirectBlocks[i]);
+	    indirectBlocks[i] = -1;
+	}
+    if (numBlocks == 0 && doubleIndirect != -1) {
+	freeMap->Clear(doubleIndirect);
+	doubleIndirect = -1;
+    }
+    if (numExtents <= (int) NumDirectExtents && indirect != -1) {
+	freeMap->Clear(indirect);
+	indirect = -1;
+    }
+}
+
 //----------------------------------------------------------------------
 // FileHeader::Deallocate
-// 	De-allocate all the space allocated for data blocks for this file.
+// 	De-allocate all the space allocated for data blocks for this file,
+//	and for its indirect blocks.
 //
 //	"freeMap" is the bit map of free disk sectors
 //----------------------------------------------------------------------
@@ -61,15 +281,26 @@ FileHeader::Allocate(BitMap *freeMap, int fileSize)
 void 
 FileHeader::Deallocate(BitMap *freeMap)
 {
-    for (int i = 0; i < numSectors; i++) {
-	ASSERT(freeMap->Test((int) dataSectors[i]));  // ought to be marked!
-	freeMap->Clear((int) dataSectors[i]);
-    }
+    int i, j;
+
+    for (i = 0; i < numExtents; i++)
+	for (j = 0; j < extents[i].length; j++) {
+	    ASSERT(freeMap->Test(extents[i].start + j));  // ought to be marked!
+	    freeMap->Clear(extents[i].start + j);
+	}
+    if (indirect != -1)
+	freeMap->Clear(indirect);
+    if (doubleIndirect != -1)
+	freeMap->Clear(doubleIndirect);
+    for (i = 0; i < (int) NumIndirectBlocks; i++)
+	if (indirectBlocks[i] != -1)
+	    freeMap->Clear(indirectBlocks[i]);
 }
 
 //----------------------------------------------------------------------
 // FileHeader::FetchFrom
-// 	Fetch contents of file header from disk. 
+// 	Fetch contents of file header from disk, along with the extents
+//	kept in its indirect blocks.
 //
 //	"sector" is the disk sector containing the file header
 //----------------------------------------------------------------------
@@ -77,12 +308,38 @@ FileHeader::Deallocate(BitMap *freeMap)
 void
 FileHeader::FetchFrom(int sector)
 {
-    synchDisk->ReadSector(sector, (char *)this);
+    int buffer[SectorSize / sizeof(int)];
+    RawFileHeader *raw = (RawFileHeader *) buffer;
+    int i, first;
+
+    bufferCache->ReadSector(sector, (char *) buffer);
+    numBytes = raw->numBytes;
+    numSectors = raw->numSectors;
+    numExtents = maxExtents = raw->numExtents;
+    indirect = raw->indirect;
+    doubleIndirect = raw->doubleIndirect;
+    delete [] extents;
+    extents = new Extent[maxExtents];
+    for (i = 0; i < numExtents && i < (int) NumDirectExtents; i++)
+	extents[i] = raw->direct[i];
+
+    if (indirect != -1)
+	FetchExtents(indirect, NumDirectExtents);
+    if (doubleIndirect == -1) {
+	for (i = 0; i < (int) NumIndirectBlocks; i++)
+	    indirectBlocks[i] = -1;
+	return;
+    }
+    bufferCache->ReadSector(doubleIndirect, (char *) indirectBlocks);
+    first = NumDirectExtents + ExtentsPerBlock;
+    for (i = 0; first < numExtents; i++, first += ExtentsPerBlock)
+	FetchExtents(indirectBlocks[i], first);
 }
 
 //----------------------------------------------------------------------
 // FileHeader::WriteBack
-// 	Write the modified contents of the file header back to disk. 
+// 	Write the modified contents of the file header back to disk,
+//	along with its indirect blocks.
 //
 //	"sector" is the disk sector to contain the file header
 //----------------------------------------------------------------------
@@ -90,7 +347,61 @@ FileHeader::FetchFrom(int sector)
 void
 FileHeader::WriteBack(int sector)
 {
-    synchDisk->WriteSector(sector, (char *)this); 
+    int buffer[SectorSize / sizeof(int)];
+    RawFileHeader *raw = (RawFileHeader *) buffer;
+    int i, first;
+
+    bzero((char *) buffer, SectorSize);
+    raw->numBytes = numBytes;
+    raw->numSectors = numSectors;
+    raw->numExtents = numExtents;
+    raw->indirect = indirect;
+    raw->doubleIndirect = doubleIndirect;
+    for (i = 0; i < numExtents && i < (int) NumDirectExtents; i++)
+	raw->direct[i] = extents[i];
+    bufferCache->WriteSector(sector, (char *) buffer);
+
+    if (indirect != -1)
+	WriteBackExtents(indirect, NumDirectExtents);
+    if (doubleIndirect == -1)
+	return;
+    bufferCache->WriteSector(doubleIndirect, (char *) indirectBlocks);
+    first = NumDirectExtents + ExtentsPerBlock;
+    for (i = 0; first < numExtents; i++, first += ExtentsPerBlock)
+	WriteBackExtents(indirectBlocks[i], first);
+}
+
+//----------------------------------------------------------------------
+// FileHeader::FetchExtents
+// 	Read the indirect block at "sector" into the extents from "first"
+//	on, up to the end of the block or of the file.
+//----------------------------------------------------------------------
+
+void
+FileHeader::FetchExtents(int sector, int first)
+{
+    Extent block[ExtentsPerBlock];
+
+    bufferCache->ReadSector(sector, (char *) block);
+    for (int i = 0; i < (int) ExtentsPerBlock && first + i < numExtents; i++)
+	extents[first + i] = block[i];
+}
+
+//----------------------------------------------------------------------
+// FileHeader::WriteBackExtents
+// 	Write the extents from "first" on, up to the end of the file or as
+//	many as fit, to the indirect block at "sector".
+//----------------------------------------------------------------------
+
+void
+FileHeader::WriteBackExtents(int sector, int first)
+{
+    Extent block[ExtentsPerBlock];
+
+    bzero((char *) block, SectorSize);
+    for (int i = 0; i < (int) ExtentsPerBlock && first + i < numExtents; i++)
+	block[i] = extents[first + i];
+    bufferCache->WriteSector(sector, (char *) block);
 }
 
 //----------------------------------------------------------------------
@@ -98,7 +409,8 @@ FileHeader::WriteBack(int sector)
 // 	Return which disk sector is storing a particular byte within the file.
 //      This is essentially a translation from a virtual address (the
 //	offset in the file) to a physical address (the sector where the
-//	data at the offset is stored).
+//	data at the offset is stored): we walk the extents until we reach
+//	the one holding it.
 //
 //	"offset" is the location within the file of the byte in question
 //----------------------------------------------------------------------
@@ -106,7 +418,15 @@ FileHeader::WriteBack(int sector)
 int
 FileHeader::ByteToSector(int offset)
 {
-    return(dataSectors[offset / SectorSize]);
+    int sector = offset / SectorSize;
+
+    for (int i = 0; i < numExtents; i++) {
+	if (sector < extents[i].length)
+	    return extents[i].start + sector;
+	sector -= extents[i].length;
+    }
+    ASSERT(FALSE);			// beyond the end of the file
+    return -1;
 }
 
 //----------------------------------------------------------------------
@@ -120,6 +440,31 @@ FileHeader::FileLength()
     return numBytes;
 }
 
+//----------------------------------------------------------------------
+// FileHeader::SetLength
+// 	Change the number of bytes in the file.  The sectors for them must
+//	have been allocated already.
+//----------------------------------------------------------------------
+
+void
+FileHeader::SetLength(int newLength)
+{
+    ASSERT(newLength >= 0 && newLength <= Capacity());
+    numBytes = newLength;
+}
+
+//----------------------------------------------------------------------
+// FileHeader::Capacity
+// 	Return the number of bytes the file can hold in the sectors
+//	allocated to it.
+//----------------------------------------------------------------------
+
+int
+FileHeader::Capacity()
+{
+    return numSectors * SectorSize;
+}
+
 //----------------------------------------------------------------------
 // FileHeader::Print
 // 	Print the contents of the file header, and the contents of all
@@ -133,11 +478,19 @@ FileHeader::Print()
     char *data = new char[SectorSize];
 
     printf("FileHeader contents.  File size: %d.  File blocks:\n", numBytes);
-    for (i = 0; i < numSectors; i++)
-	printf("%d ", dataSectors[i]);
+    for (i = 0; i < numExtents; i++)
+	printf("%d-%d ", extents[i].start,
+	       extents[i].start + extents[i].length - 1);
+    if (indirect != -1)
+	printf("\nIndirect blocks: %d", indirect);
+    if (doubleIndirect != -1) {
+	printf(", doubly indirect %d:", doubleIndirect);
+	for (i = 0; i < (int) NumIndirectBlocks && indirectBlocks[i] != -1; i++)
+	    printf(" %d", indirectBlocks[i]);
+    }
     printf("\nFile contents:\n");
     for (i = k = 0; i < numSectors; i++) {
-	synchDisk->ReadSector(dataSectors[i], data);
+	bufferCache->ReadSector(ByteToSector(i * SectorSize), data);
         for (j = 0; (j < SectorSize) && (k < numBytes); j++, k++) {
 	    if ('\040' <= data[j] && data[j] <= '\176')   // isprint(data[j])
 		printf("%c", data[j]);
@@ -17,31 +17,76 @@
 #include "disk.h"
 #include "bitmap.h"
 
-#define NumDirect 	((SectorSize - 2 * sizeof(int)) / sizeof(int))
-#define MaxFileSize 	(NumDirect * SectorSize)
+// An extent is a run of consecutive sectors holding consecutive data
+// of a file.  Kept public so that FileHeader can access the fields
+// directly.
+
+class Extent {
+  public:
+    int start;				// First sector of the run
+    int length;				// Number of sectors in it
+};
+
+#define NumDirectExtents ((SectorSize - 5 * sizeof(int)) / sizeof(Extent))
+					// extents in the header sector
+#define ExtentsPerBlock	(SectorSize / sizeof(Extent))
+					// extents in an indirect block
+#define NumIndirectBlocks (SectorSize / sizeof(int))
+					// indirect blocks under the doubly
+					// indirect block
+#define MaxExtents	(NumDirectExtents + ExtentsPerBlock + \
+			 NumIndirectBlocks * ExtentsPerBlock)
+#define MaxFileSize 	(NumSectors * SectorSize)
+					// no bigger than the disk, and
+					// no more than MaxExtents extents
+
+// A file that grows is given sectors in batches, to keep it in few
+// extents: as many sectors again as it has, but at least MinGrowSectors
+// and at most MaxGrowSectors (one track).  The sectors beyond the end
+// of the file are given back when it is closed.
+
+#define MinGrowSectors	4
+#define MaxGrowSectors	SectorsPerTrack
 
 // The following class defines the Nachos "file header" (in UNIX terms,  
 // the "i-node"), describing where on disk to find all of the data in the file.
-// The file header is organized as a simple table of pointers to
-// data blocks. 
+// The file header is organized as a list of extents, in file order.
+// The first few are kept in the header itself; the next ones in an
+// indirect block, a sector full of extents; and the rest in indirect
+// blocks listed by a doubly indirect block, a sector full of sector
+// numbers.  Indirect blocks are only allocated once a file needs them.
+//
+// A file whose data is contiguous on disk needs just one extent, so
+// files can be as large as the disk; only a badly fragmented one can
+// run out of extents.
 //
-// The file header data structure can be stored in memory or on disk.
-// When it is on disk, it is stored in a single sector -- this means
-// that we assume the size of this data structure to be the same
-// as one disk sector.  Without indirect addressing, this
-// limits the maximum file length to just under 4K bytes.
+// A file can grow after it is created.  It may then have more sectors
+// allocated than its length needs, until it is trimmed.
 //
-// There is no constructor; rather the file header can be initialized
-// by allocating blocks for the file (if it is a new file), or by
-// reading it from disk.
+// On disk, the header proper is stored in a single sector, laid out
+// as a RawFileHeader.  In memory, we keep all of the extents in one
+// array, read in from the indirect blocks by FetchFrom, and written
+// out to them by WriteBack.
+//
+// The file header can be initialized by allocating blocks for the file
+// (if it is a new file), or by reading it from disk.
 
 class FileHeader {
   public:
+    FileHeader();			// An empty header; call Allocate
+					//  or FetchFrom before using it
+    ~FileHeader();			// De-allocate the in-memory header
+
     bool Allocate(BitMap *bitMap, int fileSize);// Initialize a file header, 
 						//  including allocating space 
 						//  on disk for the file data
     void Deallocate(BitMap *bitMap);  		// De-allocate this file's 
-						//  data blocks
+						//  data and indirect blocks
+    bool Extend(BitMap *freeMap, int newSize);	// Allocate sectors for the
+						//  file to grow to "newSize"
+						//  bytes, and a batch more
+    void Trim(BitMap *freeMap);			// De-allocate the sectors
+						//  beyond the end of the file
 
     void FetchFrom(int sectorNumber); 	// Initialize file header from disk
     void WriteBack(int sectorNumber); 	// Write modifications to file header
@@ -53,14 +98,55 @@ class FileHeader {
 
     int FileLength();			// Return the length of the file 
 					// in bytes
+    void SetLength(int newLength);	// Change the length of the file,
+					// within the sectors allocated
+    int Capacity();			// How long the file can get without
+					// allocating more sectors
 
     void Print();			// Print the contents of the file.
 
   private:
     int numBytes;			// Number of bytes in the file
     int numSectors;			// Number of data sectors in the file
-    int dataSectors[NumDirect];		// Disk sector numbers for each data 
-					// block in the file
+    int numExtents;			// Number of extents in "extents"
+    Extent *extents;			// The file's data sectors, in order
+    int maxExtents;			// Room in "extents"
+    int indirect;			// Sector of the indirect block, or -1
+    int doubleIndirect;			// Sector of the doubly indirect
+					// block, or -1
+    int indirectBlocks[NumIndirectBlocks];
+					// The indirect blocks it lists
+
+    bool AddSectors(BitMap *freeMap, int count);
+					// Allocate "count" more data sectors
+					// at the end of the file
+    void AddExtent(int start, int length);
+					// Append a run of sectors, merging it
+					// into the last extent if it follows
+    bool AllocateIndirect(BitMap *freeMap);
+					// Allocate the indirect blocks needed
+					// to hold "numExtents" extents
+    void ReleaseSectors(BitMap *freeMap, int keep);
+					// De-allocate the data sectors after
+					// the first "keep", and the indirect
+					// blocks no longer needed
+    void FetchExtents(int sector, int first);
+    void WriteBackExtents(int sector, int first);
+					// Read/write the indirect block at
+					// "sector", holding the extents from
+					// "first" on
+};
+
+// The part of a file header stored in its sector on disk.
+
+class RawFileHeader {
+  public:
+    int numBytes;
+    int numSectors;
+    int numExtents;
+    int indirect;
+    int doubleIndirect;
+    Extent direct[NumDirectExtents];	// The first extents
 };
 
 #endif // FILEHDR_H
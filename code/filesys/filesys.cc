@@ -21,20 +21,30 @@
 //	The file system assumes that the bitmap and directory files are
 //	kept "open" continuously while Nachos is running.
 //
+//	The directory is also kept in memory, so that it is read from
+//	disk only once, on bootup.
+//
+//	Directories can hold other directories, so that files are named
+//	by paths, such as "a/b/c", from the root directory.  The sectors
+//	that paths lead to are kept in a cache (cf. dcache.h), so that
+//	opening a file deep down does not read every directory on the way.
+//
 //	For those operations (such as Create, Remove) that modify the
 //	directory and/or bitmap, if the operation succeeds, the changes
 //	are written immediately back to disk (the two files are kept
 //	open during all this time).  If the operation fails, and we have
-//	modified part of the directory and/or bitmap, we simply discard
-//	the changed version, without writing it back to disk.
+//	modified part of the bitmap, we simply discard the changed
+//	version, without writing it back to disk; the directory is only
+//	changed once nothing else can fail.
 //
 // 	Our implementation at this point has the following restrictions:
 //
 //	   there is no synchronization for concurrent accesses
-//	   files have a fixed size, set when the file is created
-//	   files cannot be bigger than about 3KB in size
-//	   there is no hierarchical directory structure, and only a limited
-//	     number of files can be added to the system
+//	   files grow when written past their end, but never shrink
+//	   a file made of many scattered runs of sectors can run out of
+//	     extents to describe them (see filehdr.h)
+//	   file names are at most FileNameMaxLen characters long, and
+//	     paths at most PathNameMaxLen
 //	   there is no attempt to make the system robust to failures
 //	    (if Nachos exits in the middle of an operation that modifies
 //	    the file system, it may corrupt the disk)
@@ -48,8 +58,10 @@
 #include "disk.h"
 #include "bitmap.h"
 #include "directory.h"
+#include "dcache.h"
 #include "filehdr.h"
 #include "filesys.h"
+#include "system.h"
 
 // Sectors containing the file headers for the bitmap of free sectors,
 // and the directory of files.  These file headers are placed in well-known 
@@ -57,12 +69,12 @@
 #define FreeMapSector 		0
 #define DirectorySector 	1
 
-// Initial file sizes for the bitmap and directory; until the file system
-// supports extensible files, the directory size sets the maximum number 
-// of files that can be loaded onto the disk.
+// Initial file sizes for the bitmap and directory; the directory grows
+// as files are added to it.
 #define FreeMapFileSize 	(NumSectors / BitsInByte)
-#define NumDirEntries 		10
-#define DirectoryFileSize 	(sizeof(DirectoryEntry) * NumDirEntries)
+#define NumDirEntries 		16
+#define DirectoryFileSize 	(DirectoryTableOffset + \
+				 sizeof(DirectoryEntry) * NumDirEntries)
 
 //----------------------------------------------------------------------
 // FileSystem::FileSystem
@@ -72,7 +84,8 @@
 //	not all of the sectors marked as free).  
 //
 //	If format = FALSE, we just have to open the files
-//	representing the bitmap and the directory.
+//	representing the bitmap and the directory, and read the
+//	directory into memory.
 //
 //	"format" -- should we initialize the disk?
 //----------------------------------------------------------------------
@@ -80,9 +93,10 @@
 FileSystem::FileSystem(bool format)
 { 
     DEBUG('f', "Initializing the file system.\n");
+    directory = new Directory(NumDirEntries);
+    dcache = new DirectoryCache(DirCacheSize);
     if (format) {
         BitMap *freeMap = new BitMap(NumSectors);
-        Directory *directory = new Directory(NumDirEntries);
 	FileHeader *mapHdr = new FileHeader;
 	FileHeader *dirHdr = new FileHeader;
 
@@ -128,89 +142,271 @@ FileSystem::FileSystem(bool format)
 	if (DebugIsEnabled('f')) {
 	    freeMap->Print();
 	    directory->Print();
-
+	}
         delete freeMap; 
-	delete directory; 
 	delete mapHdr; 
 	delete dirHdr;
-	}
     } else {
     // if we are not formatting the disk, just open the files representing
     // the bitmap and directory; these are left open while Nachos is running
         freeMapFile = new OpenFile(FreeMapSector);
         directoryFile = new OpenFile(DirectorySector);
+	directory->FetchFrom(directoryFile);
+    }
+}
+
+//----------------------------------------------------------------------
+// FileSystem::NormalizePath
+// 	Copy "path" into "normal", leaving out leading, doubled and
+//	trailing slashes, so that each path has only one spelling; the
+//	root directory becomes "".  Return FALSE if the path is longer
+//	than PathNameMaxLen, or has a name longer than FileNameMaxLen.
+//----------------------------------------------------------------------
+
+bool
+FileSystem::NormalizePath(char *path, char *normal)
+{
+    int length = 0, nameLength = 0;
+
+    for (; *path != '\0'; path++) {
+	if (*path == '/') {
+	    if (nameLength == 0)
+		continue;		// leading or doubled slash
+	    nameLength = 0;
+	} else if (++nameLength > FileNameMaxLen)
+	    return FALSE;
+	if (length == PathNameMaxLen)
+	    return FALSE;
+	normal[length++] = *path;
+    }
+    if (length > 0 && normal[length - 1] == '/')
+	length--;			// trailing slash
+    normal[length] = '\0';
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::Lookup
+// 	Return the sector of the file header of "path", or -1 if there is
+//	no such file, and set "isDirectory" to tell whether it is a
+//	directory.
+//
+//	The answer comes from the path cache if it is there.  Otherwise
+//	we look up the parent directory, which is likely to be cached,
+//	and then read it to find the last name in the path; the answer is
+//	cached, whether the file was found or not.
+//
+//	"path" -- a normalized path
+//----------------------------------------------------------------------
+
+int
+FileSystem::Lookup(char *path, bool *isDirectory)
+{
+    OpenFile *dirFile;
+    Directory *dir;
+    char *name;
+    int parent, sector = -1;
+
+    if (path[0] == '\0') {
+	*isDirectory = TRUE;
+	return DirectorySector;		// the root
+    }
+    if (dcache->Find(path, &sector, isDirectory))
+	return sector;
+
+    *isDirectory = FALSE;
+    parent = LookupParent(path, &name);
+    if (parent != -1) {
+	OpenDirectory(parent, &dirFile, &dir);
+	sector = dir->Find(name);
+	*isDirectory = dir->IsDirectory(name);
+	CloseDirectory(dirFile, dir);
+    }
+    dcache->Enter(path, sector, *isDirectory);
+    return sector;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::LookupParent
+// 	Return the sector of the file header of the directory that holds
+//	"path", or -1 if there is no such directory, and set "name" to
+//	point to the last name in "path".
+//
+//	"path" -- a normalized path, other than the root
+//----------------------------------------------------------------------
+
+int
+FileSystem::LookupParent(char *path, char **name)
+{
+    char parentPath[PathNameMaxLen + 1];
+    char *slash = strrchr(path, '/');
+    bool isDirectory;
+    int sector;
+
+    if (slash == NULL) {
+	*name = path;
+	return DirectorySector;		// in the root
+    }
+    *name = slash + 1;
+    strncpy(parentPath, path, slash - path);
+    parentPath[slash - path] = '\0';
+    sector = Lookup(parentPath, &isDirectory);
+    return isDirectory ? sector : -1;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::OpenDirectory
+// 	Open the directory whose file header is at "sector", and read it
+//	in, unless it is the root, which is always open, and in memory.
+//----------------------------------------------------------------------
+
+void
+FileSystem::OpenDirectory(int sector, OpenFile **dirFile, Directory **dir)
+{
+    if (sector == DirectorySector) {
+	*dirFile = directoryFile;
+	*dir = directory;
+	return;
+    }
+    *dirFile = new OpenFile(sector);
+    *dir = new Directory(NumDirEntries);
+    (*dir)->FetchFrom(*dirFile);
+}
+
+//----------------------------------------------------------------------
+// FileSystem::CloseDirectory
+// 	Close a directory opened by OpenDirectory.  Any changes must have
+//	been written back.
+//----------------------------------------------------------------------
+
+void
+FileSystem::CloseDirectory(OpenFile *dirFile, Directory *dir)
+{
+    if (dir != directory) {
+	delete dir;
+	delete dirFile;
     }
 }
 
 //----------------------------------------------------------------------
 // FileSystem::Create
 // 	Create a file in the Nachos file system (similar to UNIX create).
-//	Since we can't increase the size of files dynamically, we have
-//	to give Create the initial size of the file.
+//	Files grow as they are written, but Create can be given an
+//	initial size, to allocate the file's sectors up front.
+//
+//	Return TRUE if everything goes ok, otherwise, return FALSE.
+//
+//	"name" -- path of file to be created
+//	"initialSize" -- size of file to be created
+//----------------------------------------------------------------------
+
+bool
+FileSystem::Create(char *name, int initialSize)
+{
+    DEBUG('f', "Creating file %s, size %d\n", name, initialSize);
+    return CreateFile(name, initialSize, FALSE);
+}
+
+//----------------------------------------------------------------------
+// FileSystem::MakeDirectory
+// 	Create an empty directory in the Nachos file system (similar to
+//	UNIX mkdir).  Return TRUE if everything goes ok, otherwise,
+//	return FALSE.
+//
+//	"name" -- path of directory to be created
+//----------------------------------------------------------------------
+
+bool
+FileSystem::MakeDirectory(char *name)
+{
+    DEBUG('f', "Making directory %s\n", name);
+    return CreateFile(name, DirectoryFileSize, TRUE);
+}
+
+//----------------------------------------------------------------------
+// FileSystem::CreateFile
+// 	Create a file or a directory.
 //
 //	The steps to create a file are:
 //	  Make sure the file doesn't already exist
+//	  Find the directory that is to hold it
+//	  Make sure the directory has room for it, growing it if not
 //        Allocate a sector for the file header
 // 	  Allocate space on disk for the data blocks for the file
 //	  Add the name to the directory
 //	  Store the new file header on disk 
 //	  Flush the changes to the bitmap and the directory back to disk
-//
-//	Return TRUE if everything goes ok, otherwise, return FALSE.
+//	  If the file is a directory, write an empty directory into it
 //
 // 	Create fails if:
 //   		file is already in directory
+//		the directory to hold it does not exist
+//	 	no free space to grow the directory
 //	 	no free space for file header
-//	 	no free entry for file in directory
 //	 	no free space for data blocks for the file 
 //
 // 	Note that this implementation assumes there is no concurrent access
 //	to the file system!
 //
-//	"name" -- name of file to be created
+//	"path" -- path of file to be created
 //	"initialSize" -- size of file to be created
+//	"isDirectory" -- whether to create a directory
 //----------------------------------------------------------------------
 
 bool
-FileSystem::Create(char *name, int initialSize)
+FileSystem::CreateFile(char *path, int initialSize, bool isDirectory)
 {
-    Directory *directory;
+    char normal[PathNameMaxLen + 1], *name;
+    OpenFile *dirFile, *newFile;
+    Directory *dir, *newDir;
     BitMap *freeMap;
     FileHeader *hdr;
-    int sector;
-    bool success;
-
-    DEBUG('f', "Creating file %s, size %d\n", name, initialSize);
-
-    directory = new Directory(NumDirEntries);
-    directory->FetchFrom(directoryFile);
-
-    if (directory->Find(name) != -1)
-      success = FALSE;			// file is already in directory
+    int sector, parent;
+    bool exists, success;
+
+    if (!NormalizePath(path, normal) || normal[0] == '\0')
+	return FALSE;			// bad path, or the root
+    if (Lookup(normal, &exists) != -1)
+	return FALSE;			// file is already in directory
+    parent = LookupParent(normal, &name);
+    if (parent == -1)
+	return FALSE;			// no directory to hold it
+
+    OpenDirectory(parent, &dirFile, &dir);
+    if (dir->IsFull() && !dir->Grow(dirFile))
+      success = FALSE;			// no space to grow the directory
     else {	
         freeMap = new BitMap(NumSectors);
         freeMap->FetchFrom(freeMapFile);
         sector = freeMap->Find();	// find a sector to hold the file header
     	if (sector == -1) 		
             success = FALSE;		// no free block for file header 
-        else if (!directory->Add(name, sector))
-            success = FALSE;	// no space in directory
 	else {
     	    hdr = new FileHeader;
 	    if (!hdr->Allocate(freeMap, initialSize))
             	success = FALSE;	// no space on disk for data
 	    else {	
-	    	success = TRUE;
-		// everthing worked, flush all changes back to disk
-    	    	hdr->WriteBack(sector); 		
-    	    	directory->WriteBack(directoryFile);
-    	    	freeMap->WriteBack(freeMapFile);
+	    	success = dir->Add(name, sector, isDirectory);	// there is room
+		if (success) {
+		    // everthing worked, flush all changes back to disk
+    	    	    hdr->WriteBack(sector); 		
+    	    	    freeMap->WriteBack(freeMapFile);
+    	    	    dir->WriteBack(dirFile);
+		    if (isDirectory) {
+			newFile = new OpenFile(sector);
+			newDir = new Directory(NumDirEntries);
+			newDir->WriteBack(newFile);
+			delete newDir;
+			delete newFile;
+		    }
+		    dcache->Enter(normal, sector, isDirectory);
+		}			// else the bitmap changes are dropped
 	    }
             delete hdr;
 	}
         delete freeMap;
     }
-    delete directory;
+    CloseDirectory(dirFile, dir);
     return success;
 }
 
@@ -218,75 +414,153 @@ FileSystem::Create(char *name, int initialSize)
 // FileSystem::Open
 // 	Open a file for reading and writing.  
 //	To open a file:
-//	  Find the location of the file's header, using the directory 
+//	  Find the location of the file's header, using the path cache
+//	    or the directories
 //	  Bring the header into memory
 //
-//	"name" -- the text name of the file to be opened
+//	A directory cannot be opened as a file.
+//
+//	"name" -- the path of the file to be opened
 //----------------------------------------------------------------------
 
 OpenFile *
 FileSystem::Open(char *name)
 { 
-    Directory *directory = new Directory(NumDirEntries);
+    char normal[PathNameMaxLen + 1];
     OpenFile *openFile = NULL;
     int sector;
+    bool isDirectory;
 
     DEBUG('f', "Opening file %s\n", name);
-    directory->FetchFrom(directoryFile);
-    sector = directory->Find(name); 
-    if (sector >= 0) 		
+    if (!NormalizePath(name, normal))
+	return NULL;
+    sector = Lookup(normal, &isDirectory);
+    if (sector >= 0 && !isDirectory)
 	openFile = new OpenFile(sector);	// name was found in directory 
-    delete directory;
     return openFile;				// return NULL if not found
 }
 
 //----------------------------------------------------------------------
 // FileSystem::Remove
-// 	Delete a file from the file system.  This requires:
-//	    Remove it from the directory
+// 	Delete a file, or an empty directory, from the file system.
+//	This requires:
+//	    Remove it from its directory
 //	    Delete the space for its header
 //	    Delete the space for its data blocks
 //	    Write changes to directory, bitmap back to disk
+//	    Forget the path, and any below it, in the path cache
 //
 //	Return TRUE if the file was deleted, FALSE if the file wasn't
-//	in the file system.
+//	in the file system, is open, or is a directory with files in it.
 //
-//	"name" -- the text name of the file to be removed
+//	"name" -- the path of the file to be removed
 //----------------------------------------------------------------------
 
 bool
 FileSystem::Remove(char *name)
 { 
-    Directory *directory;
+    char normal[PathNameMaxLen + 1], *last;
+    OpenFile *dirFile;
+    Directory *dir;
     BitMap *freeMap;
     FileHeader *fileHdr;
     int sector;
+    bool isDirectory, empty;
     
-    directory = new Directory(NumDirEntries);
-    directory->FetchFrom(directoryFile);
-    sector = directory->Find(name);
+    if (!NormalizePath(name, normal) || normal[0] == '\0')
+	return FALSE;			// bad path, or the root
+    sector = Lookup(normal, &isDirectory);
     if (sector == -1) {
-       delete directory;
        return FALSE;			 // file not found 
     }
-    fileHdr = new FileHeader;
-    fileHdr->FetchFrom(sector);
+    if (headerCache->IsOpen(sector))
+	return FALSE;			// file is in use
+    if (isDirectory) {
+	OpenDirectory(sector, &dirFile, &dir);
+	empty = dir->IsEmpty();
+	CloseDirectory(dirFile, dir);
+	if (!empty)
+	    return FALSE;		// directory still has files
+    }
+    fileHdr = headerCache->Acquire(sector);
 
     freeMap = new BitMap(NumSectors);
     freeMap->FetchFrom(freeMapFile);
 
     fileHdr->Deallocate(freeMap);  		// remove data blocks
     freeMap->Clear(sector);			// remove header block
-    directory->Remove(name);
+    headerCache->Release(sector);
+    headerCache->Forget(sector);		// the sector may be reused
+    OpenDirectory(LookupParent(normal, &last), &dirFile, &dir);
+    dir->Remove(last);
 
     freeMap->WriteBack(freeMapFile);		// flush to disk
-    directory->WriteBack(directoryFile);        // flush to disk
-    delete fileHdr;
-    delete directory;
+    dir->WriteBack(dirFile);			// flush to disk
+    CloseDirectory(dirFile, dir);
+    dcache->Invalidate(normal);
+    dcache->Enter(normal, -1, FALSE);
     delete freeMap;
     return TRUE;
 } 
 
+//----------------------------------------------------------------------
+// FileSystem::ExtendFile
+// 	Grow an open file to "newSize" bytes, or, if the disk is too full,
+//	to as many bytes as fit in the sectors it has.
+//
+//	Sectors are allocated in batches (see FileHeader::Extend), so most
+//	writes past the end of a file only change its length in memory.
+//	When a batch is allocated, the file header and the bitmap are
+//	written back together, so that the disk never shows a sector in
+//	use by the file as free.  The new length is written back when
+//	the file is closed.
+//
+//	"hdr" -- the in-memory header of the file
+//	"sector" -- where the header is kept on disk
+//	"newSize" -- the length the file is to have, in bytes
+//----------------------------------------------------------------------
+
+void
+FileSystem::ExtendFile(FileHeader *hdr, int sector, int newSize)
+{
+    BitMap *freeMap;
+
+    if (newSize > hdr->Capacity()) {
+	freeMap = new BitMap(NumSectors);
+	freeMap->FetchFrom(freeMapFile);
+	if (hdr->Extend(freeMap, newSize)) {
+	    DEBUG('f', "Extended the file at sector %d to %d bytes\n", sector,
+		  hdr->Capacity());
+	    hdr->WriteBack(sector);
+	    freeMap->WriteBack(freeMapFile);
+	}
+	delete freeMap;
+    }
+    hdr->SetLength(min(newSize, hdr->Capacity()));
+}
+
+//----------------------------------------------------------------------
+// FileSystem::TrimFile
+// 	Called when a file that grew is closed.  Give back the sectors
+//	allocated beyond its end, and write its header and the bitmap
+//	back to disk.
+//
+//	"hdr" -- the in-memory header of the file
+//	"sector" -- where the header is kept on disk
+//----------------------------------------------------------------------
+
+void
+FileSystem::TrimFile(FileHeader *hdr, int sector)
+{
+    BitMap *freeMap = new BitMap(NumSectors);
+
+    freeMap->FetchFrom(freeMapFile);
+    hdr->Trim(freeMap);
+    hdr->WriteBack(sector);
+    freeMap->WriteBack(freeMapFile);
+    delete freeMap;
+}
+
 //----------------------------------------------------------------------
 // FileSystem::List
 // 	List all the files in the file system directory.
@@ -295,11 +569,7 @@ FileSystem::Remove(char *name)
 void
 FileSystem::List()
 {
-    Directory *directory = new Directory(NumDirEntries);
-
-    directory->FetchFrom(directoryFile);
     directory->List();
-    delete directory;
 }
 
 //----------------------------------------------------------------------
@@ -318,7 +588,6 @@ FileSystem::Print()
     FileHeader *bitHdr = new FileHeader;
     FileHeader *dirHdr = new FileHeader;
     BitMap *freeMap = new BitMap(NumSectors);
-    Directory *directory = new Directory(NumDirEntries);
 
     printf("Bit map file header:\n");
     bitHdr->FetchFrom(FreeMapSector);
@@ -331,11 +600,9 @@ FileSystem::Print()
     freeMap->FetchFrom(freeMapFile);
     freeMap->Print();
 
-    directory->FetchFrom(directoryFile);
     directory->Print();
 
     delete bitHdr;
     delete dirHdr;
     delete freeMap;
-    delete directory;
 } 
@@ -65,6 +65,9 @@ class FileSystem {
 };
 
 #else // FILESYS
+class Directory;
+class DirectoryCache;
+
 class FileSystem {
   public:
     FileSystem(bool format);		// Initialize the file system.
@@ -76,10 +79,19 @@ class FileSystem {
 
     bool Create(char *name, int initialSize);  	
 					// Create a file (UNIX creat)
+    bool MakeDirectory(char *name);	// Create a directory (UNIX mkdir)
 
     OpenFile* Open(char *name); 	// Open a file (UNIX open)
 
-    bool Remove(char *name);  		// Delete a file (UNIX unlink)
+    bool Remove(char *name);  		// Delete a file, or an empty
+					// directory (UNIX unlink, rmdir)
+
+    void ExtendFile(FileHeader *hdr, int sector, int newSize);
+					// Grow an open file to "newSize"
+					// bytes, or as far as the disk allows
+    void TrimFile(FileHeader *hdr, int sector);
+					// Give back the sectors a file that
+					// grew has beyond its end
 
     void List();			// List all the files in the file system
 
@@ -90,6 +102,22 @@ class FileSystem {
 					// represented as a file
    OpenFile* directoryFile;		// "Root" directory -- list of 
 					// file names, represented as a file
+   Directory* directory;		// The root directory, cached in
+					// memory
+   DirectoryCache* dcache;		// Where paths lead
+
+   bool NormalizePath(char *path, char *normal);
+					// Copy "path" without extra slashes
+   int Lookup(char *path, bool *isDirectory);
+					// Find the header sector of "path"
+   int LookupParent(char *path, char **name);
+					// Find the header sector of the
+					// directory holding "path"
+   void OpenDirectory(int sector, OpenFile **dirFile, Directory **dir);
+   void CloseDirectory(OpenFile *dirFile, Directory *dir);
+					// Read in/let go of a directory
+   bool CreateFile(char *path, int initialSize, bool isDirectory);
+					// Create a file or directory
 };
 
 #endif // FILESYS
@@ -0,0 +1,231 @@
+// hdrcache.cc
+//	Routines to share file headers between open files.  See
+//	hdrcache.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "hdrcache.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// HeaderCache::HeaderCache
+// 	Initialize an empty table.
+//
+//	"size" -- the number of headers to keep at first
+//----------------------------------------------------------------------
+
+HeaderCache::HeaderCache(int size)
+{
+    ASSERT(size > 0);
+    numEntries = size;
+    entries = new HeaderCacheEntry[size];
+    for (int i = 0; i < numEntries; i++) {
+	entries[i].hdr = NULL;
+	entries[i].refCount = 0;
+	entries[i].dirty = FALSE;
+	entries[i].lastUse = 0;
+    }
+    clock = 0;
+}
+
+//----------------------------------------------------------------------
+// HeaderCache::~HeaderCache
+// 	De-allocate the table, and the headers in it.  Any dirty headers
+//	must have been written back, by Flush.
+//----------------------------------------------------------------------
+
+HeaderCache::~HeaderCache()
+{
+    for (int i = 0; i < numEntries; i++) {
+	ASSERT(!entries[i].dirty);
+	delete entries[i].hdr;
+    }
+    delete [] entries;
+}
+
+//----------------------------------------------------------------------
+// HeaderCache::FindIndex
+// 	Return the entry holding the header at "sector", or -1 if it is
+//	not in the table.
+//----------------------------------------------------------------------
+
+int
+HeaderCache::FindIndex(int sector)
+{
+    for (int i = 0; i < numEntries; i++)
+	if (entries[i].hdr != NULL && entries[i].sector == sector)
+	    return i;
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// HeaderCache::FindFree
+// 	Return an entry that no open file uses, and empty it: a free one
+//	if there is one, otherwise the least recently used.  If every
+//	entry is in use, double the size of the table.
+//----------------------------------------------------------------------
+
+int
+HeaderCache::FindFree()
+{
+    HeaderCacheEntry *oldEntries;
+    int victim = -1, i;
+
+    for (i = 0; i < numEntries; i++) {
+	if (entries[i].refCount > 0)
+	    continue;
+	if (entries[i].hdr == NULL)
+	    return i;
+	if (victim == -1 || entries[i].lastUse < entries[victim].lastUse)
+	    victim = i;
+    }
+    if (victim != -1) {
+	ASSERT(!entries[victim].dirty);	// written back when released
+	delete entries[victim].hdr;
+	entries[victim].hdr = NULL;
+	return victim;
+    }
+
+    DEBUG('f', "Growing the header table to %d entries\n", 2 * numEntries);
+    oldEntries = entries;
+    entries = new HeaderCacheEntry[2 * numEntries];
+    for (i = 0; i < numEntries; i++)
+	entries[i] = oldEntries[i];
+    for (; i < 2 * numEntries; i++) {
+	entries[i].hdr = NULL;
+	entries[i].refCount = 0;
+	entries[i].dirty = FALSE;
+	entries[i].lastUse = 0;
+    }
+    delete [] oldEntries;
+    victim = numEntries;
+    numEntries *= 2;
+    return victim;
+}
+
+//----------------------------------------------------------------------
+// HeaderCache::Acquire
+// 	Return the in-memory header of the file whose header is at
+//	"sector", reading it from disk unless it is already in the table,
+//	and count one more user of it.  Each Acquire must be matched by a
+//	Release.
+//----------------------------------------------------------------------
+
+FileHeader *
+HeaderCache::Acquire(int sector)
+{
+    int i = FindIndex(sector);
+
+    if (i == -1) {
+	i = FindFree();
+	entries[i].hdr = new FileHeader;
+	entries[i].hdr->FetchFrom(sector);
+	entries[i].sector = sector;
+	entries[i].refCount = 0;
+	entries[i].dirty = FALSE;
+    } else
+	DEBUG('f', "Header at sector %d is in memory\n", sector);
+    entries[i].refCount++;
+    entries[i].lastUse = ++clock;
+    return entries[i].hdr;
+}
+
+//----------------------------------------------------------------------
+// HeaderCache::Release
+// 	Count one user less of the header at "sector".  If it was the
+//	last, write the header back if it is dirty; it stays in the table
+//	in case the file is opened again.
+//----------------------------------------------------------------------
+
+void
+HeaderCache::Release(int sector)
+{
+    int i = FindIndex(sector);
+
+    ASSERT(i != -1 && entries[i].refCount > 0);
+    if (--entries[i].refCount == 0)
+	WriteBack(sector);
+}
+
+//----------------------------------------------------------------------
+// HeaderCache::IsOpen
+// 	Return TRUE if some open file uses the header at "sector".
+//----------------------------------------------------------------------
+
+bool
+HeaderCache::IsOpen(int sector)
+{
+    int i = FindIndex(sector);
+
+    return i != -1 && entries[i].refCount > 0;
+}
+
+//----------------------------------------------------------------------
+// HeaderCache::Forget
+// 	Drop the header at "sector" from the table, without writing it
+//	back: its file is being removed, and the sector may be reused for
+//	another header.  No open file may be using it.
+//----------------------------------------------------------------------
+
+void
+HeaderCache::Forget(int sector)
+{
+    int i = FindIndex(sector);
+
+    if (i == -1)
+	return;
+    ASSERT(entries[i].refCount == 0);
+    delete entries[i].hdr;
+    entries[i].hdr = NULL;
+    entries[i].dirty = FALSE;
+}
+
+//----------------------------------------------------------------------
+// HeaderCache::MarkDirty
+// 	Note that the file whose header is at "sector" has grown, so that
+//	its header must be written back.
+//----------------------------------------------------------------------
+
+void
+HeaderCache::MarkDirty(int sector)
+{
+    int i = FindIndex(sector);
+
+    ASSERT(i != -1);
+    entries[i].dirty = TRUE;
+}
+
+//----------------------------------------------------------------------
+// HeaderCache::WriteBack
+// 	If the header at "sector" is dirty, give back the sectors
+//	allocated beyond the end of its file, and write it back.
+//----------------------------------------------------------------------
+
+void
+HeaderCache::WriteBack(int sector)
+{
+    int i = FindIndex(sector);
+
+    if (i != -1 && entries[i].dirty) {
+	fileSystem->TrimFile(entries[i].hdr, sector);
+	entries[i].dirty = FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// HeaderCache::Flush
+// 	Write back every dirty header, of files still open; called when
+//	Nachos halts, before the statistics are printed, with the buffer
+//	cache no longer timing the disk.
+//----------------------------------------------------------------------
+
+void
+HeaderCache::Flush()
+{
+    for (int i = 0; i < numEntries; i++)
+	if (entries[i].hdr != NULL && entries[i].dirty)
+	    WriteBack(entries[i].sector);
+}
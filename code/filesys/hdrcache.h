@@ -0,0 +1,81 @@
+// hdrcache.h
+//	Data structures for a table of file headers (in UNIX terms,
+//	"i-nodes") kept in memory, shared by the open files.
+//
+//	Each open file used to read its own copy of its header from disk,
+//	so a file opened twice was read twice, and a write that grew the
+//	file through one open was not seen through the other.  Instead,
+//	the header of a file is read once, into the table, and every
+//	OpenFile on the file uses that one copy; the table counts how
+//	many there are.
+//
+//	A header is "dirty" once the file has grown, and its length in
+//	memory is newer than on disk.  It is written back (with the
+//	sectors allocated beyond the end of the file given back, see
+//	FileSystem::TrimFile) when the last open of the file is closed,
+//	when an open file is flushed, and when Nachos halts.
+//
+//	Headers of files no longer open stay in the table, so that opening
+//	the file again costs no disk access, until their entry is needed
+//	for another file (least recently used first).  If every entry is
+//	in use by an open file, the table grows.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef HDRCACHE_H
+#define HDRCACHE_H
+
+#include "copyright.h"
+#include "filehdr.h"
+
+#define HeaderCacheSize		32	// headers kept at first
+
+// The following class defines one entry of the table.  Kept public so
+// that HeaderCache can access the fields directly.
+
+class HeaderCacheEntry {
+  public:
+    FileHeader *hdr;			// The header, NULL if the entry is
+					// free
+    int sector;				// Where it is kept on disk
+    int refCount;			// Number of OpenFiles using it
+    bool dirty;				// Has the file grown since the header
+					// was last written back?
+    int lastUse;			// When it was last used, for LRU
+};
+
+// The following class defines the table.
+
+class HeaderCache {
+  public:
+    HeaderCache(int size);		// Initialize an empty table of
+					// "size" entries
+    ~HeaderCache();			// De-allocate the headers; they must
+					// have been written back
+
+    FileHeader *Acquire(int sector);	// Return the header at "sector",
+					// reading it in if need be, and
+					// count one more user
+    void Release(int sector);		// Count one user less, writing the
+					// header back if it was the last
+    bool IsOpen(int sector);		// Is the header in use?
+    void Forget(int sector);		// Drop the header at "sector", whose
+					// file is being removed
+
+    void MarkDirty(int sector);		// Note that the file has grown
+    void WriteBack(int sector);		// Write the header back, if dirty
+    void Flush();			// Write back every dirty header
+
+  private:
+    HeaderCacheEntry *entries;
+    int numEntries;
+    int clock;				// counts uses, for LRU
+
+    int FindIndex(int sector);		// The entry for "sector", or -1
+    int FindFree();			// An entry to reuse, growing the
+					// table if need be
+};
+
+#endif // HDRCACHE_H
@@ -5,7 +5,8 @@
 //	the OpenFile data structure).
 //
 //	Also as in UNIX, for convenience, we keep the file header in
-//	memory while the file is open.
+//	memory while the file is open.  All the opens of a file share
+//	one copy of its header (cf. hdrcache.h).
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -19,26 +20,44 @@
 //----------------------------------------------------------------------
 // OpenFile::OpenFile
 // 	Open a Nachos file for reading and writing.  Bring the file header
-//	into memory while the file is open.
+//	into memory while the file is open, unless it is there already.
 //
 //	"sector" -- the location on disk of the file header for this file
 //----------------------------------------------------------------------
 
 OpenFile::OpenFile(int sector)
 { 
-    hdr = new FileHeader;
-    hdr->FetchFrom(sector);
+    hdr = headerCache->Acquire(sector);
+    hdrSector = sector;
     seekPosition = 0;
+    lastSectorRead = readAheadUpTo = -1;
+    readAhead = 0;
 }
 
 //----------------------------------------------------------------------
 // OpenFile::~OpenFile
 // 	Close a Nachos file, de-allocating any in-memory data structures.
+//	If this was the last open of the file, and the file grew, its new
+//	length is written back; see Flush.
 //----------------------------------------------------------------------
 
 OpenFile::~OpenFile()
 {
-    delete hdr;
+    headerCache->Release(hdrSector);
+}
+
+//----------------------------------------------------------------------
+// OpenFile::Flush
+// 	If the file has grown since its header was last written back,
+//	give back the sectors allocated beyond its end, and write its
+//	header back.  For files that stay open, but whose length matters
+//	on disk.
+//----------------------------------------------------------------------
+
+void
+OpenFile::Flush()
+{
+    headerCache->WriteBack(hdrSector);
 }
 
 //----------------------------------------------------------------------
@@ -102,6 +121,9 @@ OpenFile::Write(char *into, int numBytes)
 //	   so that we don't overwrite the unmodified portion.  We then copy
 //	   in the data that will be modified, and write back all the full
 //	   or partial sectors that are part of the request.
+//	   If the request goes past the end of the file, the file first
+//	   grows to hold it, as far as there is room on disk; if it
+//	   starts past the end, the gap is filled with zeros.
 //
 //	"into" -- the buffer to contain the data to be read from disk 
 //	"from" -- the buffer containing the data to be written to disk 
@@ -131,12 +153,14 @@ OpenFile::ReadAt(char *into, int numBytes, int position)
     // read in all the full and partial sectors that we need
     buf = new char[numSectors * SectorSize];
     for (i = firstSector; i <= lastSector; i++)	
-        synchDisk->ReadSector(hdr->ByteToSector(i * SectorSize), 
+        bufferCache->ReadSector(hdr->ByteToSector(i * SectorSize), 
 					&buf[(i - firstSector) * SectorSize]);
 
     // copy the part we want
     bcopy(&buf[position - (firstSector * SectorSize)], into, numBytes);
     delete [] buf;
+
+    ReadAhead(firstSector, lastSector);
     return numBytes;
 }
 
@@ -148,8 +172,22 @@ OpenFile::WriteAt(char *from, int numBytes, int position)
     bool firstAligned, lastAligned;
     char *buf;
 
-    if ((numBytes <= 0) || (position >= fileLength))
+    if ((numBytes <= 0) || (position < 0))
 	return 0;				// check request
+    if ((position + numBytes) > fileLength) {
+	fileSystem->ExtendFile(hdr, hdrSector, position + numBytes);
+	headerCache->MarkDirty(hdrSector);
+	if (position > fileLength && hdr->FileLength() > fileLength) {
+	    buf = new char[hdr->FileLength() - fileLength];
+	    bzero(buf, hdr->FileLength() - fileLength);
+	    WriteAt(buf, min(position, hdr->FileLength()) - fileLength,
+		    fileLength);
+	    delete [] buf;
+	}
+	fileLength = hdr->FileLength();
+    }
+    if (position >= fileLength)
+	return 0;				// disk full
     if ((position + numBytes) > fileLength)
 	numBytes = fileLength - position;
     DEBUG('f', "Writing %d bytes at %d, from file of length %d.\n", 	
@@ -165,23 +203,61 @@ OpenFile::WriteAt(char *from, int numBytes, int position)
     lastAligned = ((position + numBytes) == ((lastSector + 1) * SectorSize));
 
 // read in first and last sector, if they are to be partially modified
+// (directly, as this is not a read of the file by the caller)
     if (!firstAligned)
-        ReadAt(buf, SectorSize, firstSector * SectorSize);	
+        bufferCache->ReadSector(hdr->ByteToSector(firstSector * SectorSize),
+				buf);
     if (!lastAligned && ((firstSector != lastSector) || firstAligned))
-        ReadAt(&buf[(lastSector - firstSector) * SectorSize], 
-				SectorSize, lastSector * SectorSize);	
+        bufferCache->ReadSector(hdr->ByteToSector(lastSector * SectorSize),
+				&buf[(lastSector - firstSector) * SectorSize]);
 
 // copy in the bytes we want to change 
     bcopy(from, &buf[position - (firstSector * SectorSize)], numBytes);
 
 // write modified sectors back
     for (i = firstSector; i <= lastSector; i++)	
-        synchDisk->WriteSector(hdr->ByteToSector(i * SectorSize), 
+        bufferCache->WriteSector(hdr->ByteToSector(i * SectorSize), 
 					&buf[(i - firstSector) * SectorSize]);
     delete [] buf;
     return numBytes;
 }
 
+//----------------------------------------------------------------------
+// OpenFile::ReadAhead
+// 	Called by ReadAt after reading sectors "firstSector" through
+//	"lastSector" of the file.  A read is sequential if it starts in
+//	or just after the last sector read before.  While reads are
+//	sequential, ask the buffer cache to fetch the next "readAhead"
+//	sectors of the file in the background, doubling "readAhead" each
+//	time a read moves on to new sectors.  Any other read starts over.
+//----------------------------------------------------------------------
+
+void
+OpenFile::ReadAhead(int firstSector, int lastSector)
+{
+    int fileSectors = divRoundUp(hdr->FileLength(), SectorSize);
+    int last, i;
+
+    if (firstSector != lastSectorRead && firstSector != lastSectorRead + 1) {
+	readAhead = 0;				// not sequential
+	readAheadUpTo = lastSector;
+    } else if (lastSector > lastSectorRead) {
+	if (readAhead == 0)
+	    readAhead = MinReadAhead;
+	else
+	    readAhead = min(2 * readAhead, MaxReadAhead);
+    }
+    lastSectorRead = lastSector;
+    if (readAhead == 0)
+	return;
+
+    last = min(lastSector + readAhead, fileSectors - 1);
+    for (i = max(readAheadUpTo, lastSector) + 1; i <= last; i++)
+	bufferCache->Prefetch(hdr->ByteToSector(i * SectorSize));
+    if (last > readAheadUpTo)
+	readAheadUpTo = last;
+}
+
 //----------------------------------------------------------------------
 // OpenFile::Length
 // 	Return the number of bytes in the file.
@@ -61,6 +61,14 @@ class OpenFile {
 #else // FILESYS
 class FileHeader;
 
+// While a file is read sequentially, the sectors after those read are
+// read ahead into the buffer cache, in the background.  The number read
+// ahead starts at MinReadAhead, and doubles with each further sequential
+// read, up to MaxReadAhead.
+
+#define MinReadAhead	2
+#define MaxReadAhead	16
+
 class OpenFile {
   public:
     OpenFile(int sector);		// Open a file whose header is located
@@ -80,15 +88,32 @@ class OpenFile {
     					// Read/write bytes from the file,
 					// bypassing the implicit position.
     int WriteAt(char *from, int numBytes, int position);
+					// Writing past the end of the file
+					// makes it grow.
 
     int Length(); 			// Return the number of bytes in the
 					// file (this interface is simpler 
 					// than the UNIX idiom -- lseek to 
 					// end of file, tell, lseek back 
     
+    void Flush();			// If the file has grown, write back
+					// its new length now, as closing its
+					// last open would
+
   private:
-    FileHeader *hdr;			// Header for this file 
+    FileHeader *hdr;			// Header for this file, shared with
+					// other opens of it
+    int hdrSector;			// ... and where it is on disk
     int seekPosition;			// Current position within the file
+    int lastSectorRead;			// Last sector of the file read, to
+					// detect sequential reads
+    int readAhead;			// Sectors to read ahead, 0 unless
+					// reading sequentially
+    int readAheadUpTo;			// Last sector of the file read ahead
+
+    void ReadAhead(int firstSector, int lastSector);
+					// Note a read of these sectors of the
+					// file, and read ahead if sequential
 };
 
 #endif // FILESYS
@@ -5,10 +5,12 @@
 //	the disk providing a synchronous interface (requests wait until
 //	the request completes).
 //
-//	Use a semaphore to synchronize the interrupt handlers with the
-//	pending requests.  And, because the physical disk can only
-//	handle one operation at a time, use a lock to enforce mutual
-//	exclusion.
+//	Use a semaphore for each request to synchronize the interrupt
+//	handler with the thread waiting for it.  Because the physical disk
+//	can only handle one operation at a time, requests made while it is
+//	busy are queued; the interrupt handler starts the next one.  The
+//	queue is shared with the interrupt handler, so it is protected by
+//	turning interrupts off.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -16,6 +18,7 @@
 
 #include "copyright.h"
 #include "synchdisk.h"
+#include "system.h"
 
 //----------------------------------------------------------------------
 // DiskRequestDone
@@ -38,13 +41,19 @@ DiskRequestDone (int arg)
 //
 //	"name" -- UNIX file name to be used as storage for the disk data
 //	   (usually, "DISK")
+//	"algo" -- the order in which to serve queued requests
+//	"mapped" -- whether to map the UNIX file into memory
 //----------------------------------------------------------------------
 
-SynchDisk::SynchDisk(char* name)
+SynchDisk::SynchDisk(char* name, DiskSchedAlgo algo, bool mapped)
 {
-    semaphore = new Semaphore("synch disk", 0);
-    lock = new Lock("synch disk lock");
-    disk = new Disk(name, DiskRequestDone, (int) this);
+    schedAlgo = algo;
+    active = NULL;
+    queue = new List;
+    queueLength = 0;
+    headTrack = 0;			// where the Disk starts
+    sweepingUp = TRUE;
+    disk = new Disk(name, DiskRequestDone, (int) this, mapped);
 }
 
 //----------------------------------------------------------------------
@@ -56,8 +65,7 @@ SynchDisk::SynchDisk(char* name)
 SynchDisk::~SynchDisk()
 {
     delete disk;
-    delete lock;
-    delete semaphore;
+    delete queue;
 }
 
 //----------------------------------------------------------------------
@@ -72,10 +80,7 @@ SynchDisk::~SynchDisk()
 void
 SynchDisk::ReadSector(int sectorNumber, char* data)
 {
-    lock->Acquire();			// only one disk I/O at a time
-    disk->ReadRequest(sectorNumber, data);
-    semaphore->P();			// wait for interrupt
-    lock->Release();
+    ReadSectors(sectorNumber, 1, &data);
 }
 
 //----------------------------------------------------------------------
@@ -90,20 +95,224 @@ SynchDisk::ReadSector(int sectorNumber, char* data)
 void
 SynchDisk::WriteSector(int sectorNumber, char* data)
 {
-    lock->Acquire();			// only one disk I/O at a time
-    disk->WriteRequest(sectorNumber, data);
-    semaphore->P();			// wait for interrupt
-    lock->Release();
+    WriteSectors(sectorNumber, 1, &data);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::ReadSectors
+// 	Read a run of consecutive disk sectors, each into its own buffer,
+//	as a single disk request.  Return only after the data has been
+//	read.
+//
+//	"firstSector" -- the first disk sector to read
+//	"numSectors" -- how many sectors to read, at most
+//		MaxTransferSectors
+//	"data" -- the buffers to hold the contents of the disk sectors
+//----------------------------------------------------------------------
+
+void
+SynchDisk::ReadSectors(int firstSector, int numSectors, char** data)
+{
+    DiskRequest request;
+
+    request.sector = firstSector;
+    request.numSectors = numSectors;
+    request.data = data;
+    request.writing = FALSE;
+    Request(&request);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::WriteSectors
+// 	Write a run of consecutive disk sectors, each from its own
+//	buffer, as a single disk request.  Return only after the data has
+//	been written.
+//
+//	"firstSector" -- the first disk sector to write
+//	"numSectors" -- how many sectors to write, at most
+//		MaxTransferSectors
+//	"data" -- the new contents of the disk sectors
+//----------------------------------------------------------------------
+
+void
+SynchDisk::WriteSectors(int firstSector, int numSectors, char** data)
+{
+    DiskRequest request;
+
+    request.sector = firstSector;
+    request.numSectors = numSectors;
+    request.data = data;
+    request.writing = TRUE;
+    Request(&request);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Request
+// 	Send "request" to the disk if it is free, or else queue it, and
+//	wait until the interrupt handler says it is done.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::Request(DiskRequest *request)
+{
+    int startTime = stats->totalTicks;
+    IntStatus oldLevel;
+
+    request->done = new Semaphore("disk request", 0);
+    oldLevel = interrupt->SetLevel(IntOff);
+    if (active == NULL)
+	StartRequest(request);
+    else {
+	queue->Append((void *) request);
+	queueLength++;
+	if (queueLength > stats->maxDiskQueue)
+	    stats->maxDiskQueue = queueLength;
+    }
+    (void) interrupt->SetLevel(oldLevel);
+    request->done->P();			// wait for interrupt
+    delete request->done;
+    stats->diskLatencies->Record(stats->totalTicks - startTime);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::StartRequest
+// 	Send "request" to the disk, and note where it leaves the head.
+//	Interrupts are off.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::StartRequest(DiskRequest *request)
+{
+    int track = request->sector / SectorsPerTrack;
+    int lastTrack = (request->sector + request->numSectors - 1) /
+		    SectorsPerTrack;
+
+    active = request;
+    stats->numDiskSeekTracks += abs(track - headTrack) + (lastTrack - track);
+    if (track != headTrack)
+	sweepingUp = (track > headTrack);
+    headTrack = lastTrack;
+    if (request->writing)
+	disk->WriteSectors(request->sector, request->numSectors,
+			   request->data);
+    else
+	disk->ReadSectors(request->sector, request->numSectors, request->data);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::NextRequest
+// 	Remove the request to serve next from the queue, and return it;
+//	NULL if there is none.  Each request is given a distance from
+//	the head, in tracks, according to "schedAlgo", and the nearest is
+//	chosen; among requests equally near, the one that came first.
+//
+//	SSTF goes to the nearest track either way.  SCAN goes on in the
+//	direction the head is moving, and turns around when there is
+//	nothing more ahead.  C-LOOK only moves up; when there is nothing
+//	more ahead, it goes back to the lowest track requested.
+//
+//	Interrupts are off.
+//----------------------------------------------------------------------
+
+DiskRequest *
+SynchDisk::NextRequest()
+{
+    DiskRequest *request, *best = NULL;
+    int i, track, distance, bestDistance = 0;
+
+    if (queueLength == 0)
+	return NULL;
+    if (schedAlgo == DiskFCFS) {
+	queueLength--;
+	return (DiskRequest *) queue->Remove();
+    }
+
+    for (i = 0; i < queueLength; i++) {		// rotate through the queue
+	request = (DiskRequest *) queue->Remove();
+	track = request->sector / SectorsPerTrack;
+	switch (schedAlgo) {
+	  case DiskSSTF:
+	    distance = abs(track - headTrack);
+	    break;
+	  case DiskSCAN:
+	    if (sweepingUp)
+		distance = (track >= headTrack) ? track - headTrack
+					: NumTracks + headTrack - track;
+	    else
+		distance = (track <= headTrack) ? headTrack - track
+					: NumTracks + track - headTrack;
+	    break;
+	  case DiskCLOOK:
+	  default:
+	    distance = (track >= headTrack) ? track - headTrack
+					: NumTracks + track;
+	    break;
+	}
+	if (best == NULL || distance < bestDistance) {
+	    best = request;
+	    bestDistance = distance;
+	}
+	queue->Append((void *) request);
+    }
+
+    for (i = 0; i < queueLength; i++) {		// and take "best" out
+	request = (DiskRequest *) queue->Remove();
+	if (request != best)
+	    queue->Append((void *) request);
+    }
+    queueLength--;
+    return best;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::ReadSectorUntimed/WriteSectorUntimed
+// 	Read/write a disk sector at once, without simulating the disk.
+//	Used by the buffer cache when Nachos halts, when no thread can
+//	wait for the disk.
+//
+//	"sectorNumber" -- the disk sector to be read/written
+//	"data" -- the buffer to hold the contents/the new contents
+//----------------------------------------------------------------------
+
+void
+SynchDisk::ReadSectorUntimed(int sectorNumber, char* data)
+{
+    disk->ReadUntimed(sectorNumber, data);
+}
+
+void
+SynchDisk::WriteSectorUntimed(int sectorNumber, char* data)
+{
+    disk->WriteUntimed(sectorNumber, data);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Flush
+// 	Make sure that the sectors written so far have reached the UNIX
+//	file, if it is mapped into memory.  Takes no simulated time.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::Flush()
+{
+    disk->Flush();
 }
 
 //----------------------------------------------------------------------
 // SynchDisk::RequestDone
-// 	Disk interrupt handler.  Wake up any thread waiting for the disk
-//	request to finish.
+// 	Disk interrupt handler.  Start the next queued request, if any,
+//	and wake up the thread waiting for the one that finished.
 //----------------------------------------------------------------------
 
 void
 SynchDisk::RequestDone()
 { 
-    semaphore->V();
+    DiskRequest *finished = active;
+    DiskRequest *next;
+
+    active = NULL;
+    next = NextRequest();
+    if (next != NULL)
+	StartRequest(next);
+    finished->done->V();
 }
@@ -14,6 +14,27 @@
 #include "disk.h"
 #include "synch.h"
 
+// The order in which queued disk requests are served
+enum DiskSchedAlgo {
+    DiskFCFS,		// in order of arrival
+    DiskSSTF,		// nearest track to the head first
+    DiskSCAN,		// elevator: sweep up, then down, and so on
+    DiskCLOOK		// sweep up only, then jump back to the lowest
+};
+
+// The following class defines a request waiting for, or being served
+// by, the disk.  Kept public so that SynchDisk can access the fields
+// directly.
+
+class DiskRequest {
+  public:
+    int sector;			// the first sector to read or write
+    int numSectors;		// how many consecutive sectors
+    char **data;		// the buffer for each sector
+    bool writing;		// TRUE for a write
+    Semaphore *done;		// the requester waits on this
+};
+
 // The following class defines a "synchronous" disk abstraction.
 // As with other I/O devices, the raw physical disk is an asynchronous device --
 // requests to read or write portions of the disk return immediately,
@@ -23,20 +44,38 @@
 //
 // This class provides the abstraction that for any individual thread
 // making a request, it waits around until the operation finishes before
-// returning.
+// returning.  Requests made while the disk is busy are queued, and
+// when it finishes one, the next is picked by "schedAlgo", based on
+// the track the head is on (cf. Disk::TimeToSeek).
+
 class SynchDisk {
   public:
-    SynchDisk(char* name);    		// Initialize a synchronous disk,
+    SynchDisk(char* name, DiskSchedAlgo algo, bool mapped);
+					// Initialize a synchronous disk,
 					// by initializing the raw Disk.
     ~SynchDisk();			// De-allocate the synch disk data
     
     void ReadSector(int sectorNumber, char* data);
     					// Read/write a disk sector, returning
     					// only once the data is actually read 
-					// or written.  These call
-    					// Disk::ReadRequest/WriteRequest and
-					// then wait until the request is done.
+					// or written.  These queue a request,
+					// or call Disk::ReadRequest/WriteRequest
+					// if the disk is free, and then wait
+					// until the request is done.
     void WriteSector(int sectorNumber, char* data);
+    void ReadSectors(int firstSector, int numSectors, char** data);
+    void WriteSectors(int firstSector, int numSectors, char** data);
+					// Read/write a run of consecutive
+					// sectors as one request, returning
+					// once it is done.  Sector
+					// "firstSector + i" is read into, or
+					// written from, "data[i]".
+    void ReadSectorUntimed(int sectorNumber, char* data);
+    void WriteSectorUntimed(int sectorNumber, char* data);
+					// Read/write a sector without waiting
+					// for the disk; only when Nachos halts
+    void Flush();			// Make sure the sectors written so
+					// far are in the UNIX file
     
     void RequestDone();			// Called by the disk device interrupt
 					// handler, to signal that the
@@ -44,10 +83,18 @@ class SynchDisk {
 
   private:
     Disk *disk;		  		// Raw disk device
-    Semaphore *semaphore; 		// To synchronize requesting thread 
-					// with the interrupt handler
-    Lock *lock;		  		// Only one read/write request
-					// can be sent to the disk at a time
+    DiskSchedAlgo schedAlgo;		// How to pick the next request
+    DiskRequest *active;		// The request being served, or NULL
+    List *queue;			// Requests waiting for the disk
+    int queueLength;			// ... and how many there are
+    int headTrack;			// Where the last request left the head
+    bool sweepingUp;			// Direction of the head, for SCAN
+
+    void Request(DiskRequest *request);	// Serve "request", and wait for it
+    void StartRequest(DiskRequest *request);
+					// Send "request" to the disk
+    DiskRequest *NextRequest();		// Remove the request to serve next
+					// from the queue
 };
 
 #endif // SYNCHDISK_H
@@ -0,0 +1,220 @@
+// cache.cc
+//	Routines to simulate a cache hierarchy.  See cache.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "cache.h"
+#include "system.h"
+
+static char *levelNames[NumCacheLevels] = { "L1 instruction", "L1 data",
+					    "L2" };
+
+//----------------------------------------------------------------------
+// Cache::Cache
+// 	Initialize an empty cache.  All sizes must be powers of two.
+//
+//	"sizeInBytes" -- the total capacity
+//	"associativity" -- the number of lines in a set
+//	"lineSizeInBytes" -- the unit of transfer from the next level
+//	"missPenalty" -- ticks to get a line from the next level
+//----------------------------------------------------------------------
+
+Cache::Cache(int sizeInBytes, int associativity, int lineSizeInBytes,
+	     int missPenalty)
+{
+    size = sizeInBytes;
+    assoc = associativity;
+    lineSize = lineSizeInBytes;
+    penalty = missPenalty;
+
+    ASSERT(lineSize >= 4 && (lineSize & (lineSize - 1)) == 0);
+    ASSERT(assoc >= 1 && size >= assoc * lineSize);
+    numSets = size / (assoc * lineSize);
+    ASSERT((numSets & (numSets - 1)) == 0);
+    ASSERT(penalty >= 0);
+    for (lineShift = 0; (1 << lineShift) < lineSize; lineShift++)
+	;
+
+    tags = new unsigned[numSets * assoc];
+    valid = new bool[numSets * assoc];
+    lastUse = new int[numSets * assoc];
+    for (int i = 0; i < numSets * assoc; i++) {
+	valid[i] = FALSE;
+	lastUse[i] = 0;
+    }
+    clock = 0;
+}
+
+//----------------------------------------------------------------------
+// Cache::~Cache
+// 	De-allocate the cache.
+//----------------------------------------------------------------------
+
+Cache::~Cache()
+{
+    delete [] tags;
+    delete [] valid;
+    delete [] lastUse;
+}
+
+//----------------------------------------------------------------------
+// Cache::Access
+// 	Look up the line holding "physAddr" in its set.  On a miss, load
+//	it in place of an invalid line or, failing that, the least
+//	recently used one.  Return TRUE on a hit.
+//----------------------------------------------------------------------
+
+bool
+Cache::Access(unsigned physAddr)
+{
+    unsigned line = physAddr >> lineShift;
+    int first = (line & (numSets - 1)) * assoc;	// the set's first line
+    int victim = first;
+
+    clock++;
+    for (int i = first; i < first + assoc; i++) {
+	if (valid[i] && tags[i] == line) {
+	    lastUse[i] = clock;
+	    return TRUE;
+	}
+	if (!valid[i] || (valid[victim] && lastUse[i] < lastUse[victim]))
+	    victim = i;
+    }
+    tags[victim] = line;
+    valid[victim] = TRUE;
+    lastUse[victim] = clock;
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// MemoryHierarchy::MemoryHierarchy
+// 	Initialize a hierarchy with no caches; add them with AddCache.
+//----------------------------------------------------------------------
+
+MemoryHierarchy::MemoryHierarchy()
+{
+    for (int level = 0; level < NumCacheLevels; level++) {
+	caches[level] = NULL;
+	hits[level] = misses[level] = 0;
+	processHits[level] = new int[MAX_THREAD_COUNT];
+	processMisses[level] = new int[MAX_THREAD_COUNT];
+	for (int pid = 0; pid < MAX_THREAD_COUNT; pid++)
+	    processHits[level][pid] = processMisses[level][pid] = 0;
+    }
+    stallTicks = 0;
+}
+
+//----------------------------------------------------------------------
+// MemoryHierarchy::~MemoryHierarchy
+// 	De-allocate the hierarchy and its caches.
+//----------------------------------------------------------------------
+
+MemoryHierarchy::~MemoryHierarchy()
+{
+    for (int level = 0; level < NumCacheLevels; level++) {
+	delete caches[level];
+	delete [] processHits[level];
+	delete [] processMisses[level];
+    }
+}
+
+//----------------------------------------------------------------------
+// MemoryHierarchy::AddCache
+// 	Put "cache" at "level" of the hierarchy.
+//----------------------------------------------------------------------
+
+void
+MemoryHierarchy::AddCache(CacheLevel level, Cache *cache)
+{
+    delete caches[level];
+    caches[level] = cache;
+}
+
+//----------------------------------------------------------------------
+// MemoryHierarchy::Lookup
+// 	Access the cache at "level", and on a miss, the levels behind it.
+//	Return the ticks spent on misses.
+//----------------------------------------------------------------------
+
+int
+MemoryHierarchy::Lookup(CacheLevel level, int pid, unsigned physAddr)
+{
+    Cache *cache = caches[level];
+    int ticks;
+
+    if (cache == NULL)			// not there; try the next level
+	return (level == L2Cache) ? 0 : Lookup(L2Cache, pid, physAddr);
+
+    if (cache->Access(physAddr)) {
+	hits[level]++;
+	processHits[level][pid]++;
+	return 0;
+    }
+    misses[level]++;
+    processMisses[level][pid]++;
+    ticks = cache->penalty;
+    if (level != L2Cache)
+	ticks += Lookup(L2Cache, pid, physAddr);
+    return ticks;
+}
+
+//----------------------------------------------------------------------
+// MemoryHierarchy::Access
+// 	Called by Machine::CacheAccess for every instruction fetch, load
+//	and store of a user program.  Charge the time spent on cache
+//	misses to the simulated clock.
+//
+//	"pid" -- the process making the access
+//	"physAddr" -- the address being accessed
+//	"fetch" -- TRUE for an instruction fetch, FALSE for data
+//----------------------------------------------------------------------
+
+void
+MemoryHierarchy::Access(int pid, unsigned physAddr, bool fetch)
+{
+    int ticks = Lookup(fetch ? L1InstructionCache : L1DataCache, pid,
+		       physAddr);
+
+    if (ticks > 0) {
+	stallTicks += ticks;
+	stats->userTicks += ticks;
+	stats->totalTicks += ticks;
+    }
+}
+
+//----------------------------------------------------------------------
+// MemoryHierarchy::Print
+// 	Print the configuration and the hit and miss counts of each
+//	cache, in total and for each process that used it.
+//----------------------------------------------------------------------
+
+void
+MemoryHierarchy::Print()
+{
+    Cache *cache;
+    int accesses;
+
+    printf("\nCaches: %d ticks spent on misses\n", stallTicks);
+    for (int level = 0; level < NumCacheLevels; level++) {
+	cache = caches[level];
+	if (cache == NULL)
+	    continue;
+	accesses = hits[level] + misses[level];
+	printf("%s: %d bytes, %d-way, %d-byte lines, %d ticks per miss\n",
+	       levelNames[level], cache->size, cache->assoc, cache->lineSize,
+	       cache->penalty);
+	printf("    hits %d, misses %d, miss rate %f\n", hits[level],
+	       misses[level], (accesses > 0) ? (float) misses[level] / accesses
+					     : 0.0);
+	for (unsigned pid = 0; pid < thread_index; pid++) {
+	    accesses = processHits[level][pid] + processMisses[level][pid];
+	    if (accesses > 0)
+		printf("    pid %d: hits %d, misses %d, miss rate %f\n", pid,
+		       processHits[level][pid], processMisses[level][pid],
+		       (float) processMisses[level][pid] / accesses);
+	}
+    }
+}
@@ -0,0 +1,87 @@
+// cache.h
+//	Data structures to simulate a cache hierarchy between the CPU and
+//	main memory.
+//
+//	The hierarchy has up to three caches: a first-level instruction
+//	cache, a first-level data cache, and a unified second-level cache
+//	behind them ("-l1i", "-l1d", "-l2").  Each is set-associative with
+//	LRU replacement and allocates a line on every miss, read or write;
+//	write-backs are not charged.  The caches are indexed and tagged by
+//	physical address; Machine::CacheAccess translates each instruction
+//	fetch, load and store of a user program and hands it to us.  Kernel
+//	accesses to user memory (ReadMem/WriteMem in system calls) are not
+//	simulated.
+//
+//	A miss in a cache costs its miss penalty, the time to get the line
+//	from the next level; that time is added to the simulated clock as
+//	user time.  Without a cache at some level, accesses go straight to
+//	the next one, so an L1-less configuration only models the L2.
+//
+//	All CPUs share the hierarchy; with "-ncpu", think of the L1 caches
+//	as shared too.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "copyright.h"
+
+// The levels of the hierarchy
+enum CacheLevel { L1InstructionCache, L1DataCache, L2Cache };
+#define NumCacheLevels	3
+
+// The following class defines one cache.  Only tags are kept; the data
+// always comes from main memory.
+
+class Cache {
+  public:
+    Cache(int sizeInBytes, int associativity, int lineSizeInBytes,
+	  int missPenalty);	// Initialize an empty cache
+    ~Cache();
+
+    bool Access(unsigned physAddr);	// Look up the line holding
+				// "physAddr", loading it on a miss; return
+				// TRUE on a hit
+
+    int size, assoc, lineSize, penalty;	// the configuration
+
+  private:
+    int numSets;
+    int lineShift;		// log2(lineSize)
+    unsigned *tags;		// numSets * assoc line tags
+    bool *valid;		// ... which lines hold data
+    int *lastUse;		// ... and when they were last used
+    int clock;			// counts accesses, for LRU
+};
+
+// The following class defines the hierarchy, and counts hits and
+// misses at each level, globally and per process.
+
+class MemoryHierarchy {
+  public:
+    MemoryHierarchy();		// Initialize, with no caches
+    ~MemoryHierarchy();
+
+    void AddCache(CacheLevel level, Cache *cache);
+    void Access(int pid, unsigned physAddr, bool fetch);
+				// A user memory access by process "pid";
+				// charge the time it takes
+    void Print();		// Print hit and miss counts
+
+  private:
+    Cache *caches[NumCacheLevels];	// NULL for a missing level
+    int hits[NumCacheLevels];
+    int misses[NumCacheLevels];
+    int *processHits[NumCacheLevels];	// ... by pid
+    int *processMisses[NumCacheLevels];
+    int stallTicks;		// total time spent on misses
+
+    int Lookup(CacheLevel level, int pid, unsigned physAddr);
+				// Access "level" and the levels behind it;
+				// return the time it takes
+};
+
+#endif // CACHE_H
@@ -81,6 +81,9 @@ Console::~Console()
 //	character has been grabbed out of the buffer by the Nachos kernel).
 //	Invoke the "read" interrupt handler, once the character has been 
 //	put into the buffer. 
+//
+//	When replaying an input log, the character comes from the log
+//	rather than from the keyboard.
 //----------------------------------------------------------------------
 
 void
@@ -93,11 +96,20 @@ Console::CheckCharAvail()
 			ConsoleReadInt);
 
     // do nothing if character is already buffered, or none to be read
-    if ((incoming != EOF) || !PollFile(readFileNo))
-	return;	  
-
-    // otherwise, read character and tell user about it
-    Read(readFileNo, &c, sizeof(char));
+    if (incoming != EOF)
+	return;
+    if (inputLog != NULL && inputLog->IsReplaying()) {
+	if (inputLog->Replay(ConsoleInput, &c) < 0)
+	    return;
+    } else {
+	if (!PollFile(readFileNo))
+	    return;
+	Read(readFileNo, &c, sizeof(char));
+	if (inputLog != NULL)
+	    inputLog->Record(ConsoleInput, &c, sizeof(char));
+    }
+
+    // otherwise, tell user about the character
     incoming = c ;
     stats->numConsoleCharsRead++;
     (*readHandler)(handlerArg);	
@@ -38,9 +38,12 @@ static void DiskDone(int arg) { ((Disk *)arg)->HandleInterrupt(); }
 //	"callWhenDone" -- interrupt handler to be called when disk read/write
 //	   request completes
 //	"callArg" -- argument to pass the interrupt handler
+//	"mapped" -- if TRUE, map the UNIX file into memory, and copy
+//	   sectors in and out of the mapping
 //----------------------------------------------------------------------
 
-Disk::Disk(char* name, VoidFunctionPtr callWhenDone, int callArg)
+Disk::Disk(char* name, VoidFunctionPtr callWhenDone, int callArg,
+	   bool mapped)
 {
     int magicNum;
     int tmp = 0;
@@ -64,17 +67,26 @@ Disk::Disk(char* name, VoidFunctionPtr callWhenDone, int callArg)
         Lseek(fileno, DiskSize - sizeof(int), 0);	
 	WriteFile(fileno, (char *)&tmp, sizeof(int));  
     }
+    image = NULL;
+    if (mapped) {
+	image = MapFile(fileno, DiskSize);
+	DEBUG('d', "Mapped the disk at 0x%x\n", image);
+    }
     active = FALSE;
 }
 
 //----------------------------------------------------------------------
 // Disk::~Disk()
-// 	Clean up disk simulation, by closing the UNIX file representing the
-//	disk.
+// 	Clean up disk simulation, by syncing and unmapping the UNIX file
+//	representing the disk, if it is mapped, and closing it.
 //----------------------------------------------------------------------
 
 Disk::~Disk()
 {
+    if (image != NULL) {
+	Flush();
+	UnmapFile(image, DiskSize);
+    }
     Close(fileno);
 }
 
@@ -99,11 +111,8 @@ PrintSector (bool writing, int sector, char *data)
 
 //----------------------------------------------------------------------
 // Disk::ReadRequest/WriteRequest
-// 	Simulate a request to read/write a single disk sector
-//	   Do the read/write immediately to the UNIX file
-//	   Set up an interrupt handler to be called later,
-//	      that will notify the caller when the simulator says
-//	      the operation has completed.
+// 	Simulate a request to read/write a single disk sector; a run of
+//	one sector.
 //
 //	Note that a disk only allows an entire sector to be read/written,
 //	not part of a sector.
@@ -115,43 +124,152 @@ PrintSector (bool writing, int sector, char *data)
 void
 Disk::ReadRequest(int sectorNumber, char* data)
 {
-    int ticks = ComputeLatency(sectorNumber, FALSE);
+    ReadSectors(sectorNumber, 1, &data);
+}
+
+void
+Disk::WriteRequest(int sectorNumber, char* data)
+{
+    WriteSectors(sectorNumber, 1, &data);
+}
+
+//----------------------------------------------------------------------
+// Disk::ReadSectors/WriteSectors
+// 	Simulate a request to read/write a run of consecutive sectors
+//	   Do the read/write immediately to the UNIX file, in one call
+//	   Set up an interrupt handler to be called later,
+//	      that will notify the caller when the simulator says
+//	      the operation has completed.
+//
+//	"firstSector" -- the first disk sector to read/write
+//	"numSectors" -- how many sectors are in the run
+//	"data" -- one buffer per sector, holding the bytes to be written,
+//		or to hold the incoming bytes
+//----------------------------------------------------------------------
+
+void
+Disk::ReadSectors(int firstSector, int numSectors, char** data)
+{
+    int ticks = ComputeLatency(firstSector, FALSE) +
+		RunTime(firstSector, numSectors);
 
     ASSERT(!active);				// only one request at a time
-    ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
+    ASSERT((numSectors >= 1) && (numSectors <= MaxTransferSectors));
+    ASSERT((firstSector >= 0) && (firstSector + numSectors <= NumSectors));
     
-    DEBUG('d', "Reading from sector %d\n", sectorNumber);
-    Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
-    Read(fileno, data, SectorSize);
+    DEBUG('d', "Reading %d sectors from sector %d\n", numSectors,
+	  firstSector);
+    ReadImage(firstSector, numSectors, data);
     if (DebugIsEnabled('d'))
-	PrintSector(FALSE, sectorNumber, data);
+	for (int i = 0; i < numSectors; i++)
+	    PrintSector(FALSE, firstSector + i, data[i]);
     
     active = TRUE;
-    UpdateLast(sectorNumber);
+    UpdateLast(firstSector + numSectors - 1);
     stats->numDiskReads++;
     interrupt->Schedule(DiskDone, (int) this, ticks, DiskInt);
 }
 
 void
-Disk::WriteRequest(int sectorNumber, char* data)
+Disk::WriteSectors(int firstSector, int numSectors, char** data)
 {
-    int ticks = ComputeLatency(sectorNumber, TRUE);
+    int ticks = ComputeLatency(firstSector, TRUE) +
+		RunTime(firstSector, numSectors);
 
     ASSERT(!active);
-    ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
+    ASSERT((numSectors >= 1) && (numSectors <= MaxTransferSectors));
+    ASSERT((firstSector >= 0) && (firstSector + numSectors <= NumSectors));
     
-    DEBUG('d', "Writing to sector %d\n", sectorNumber);
-    Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
-    WriteFile(fileno, data, SectorSize);
+    DEBUG('d', "Writing %d sectors to sector %d\n", numSectors,
+	  firstSector);
+    WriteImage(firstSector, numSectors, data);
     if (DebugIsEnabled('d'))
-	PrintSector(TRUE, sectorNumber, data);
+	for (int i = 0; i < numSectors; i++)
+	    PrintSector(TRUE, firstSector + i, data[i]);
     
     active = TRUE;
-    UpdateLast(sectorNumber);
+    UpdateLast(firstSector + numSectors - 1);
     stats->numDiskWrites++;
     interrupt->Schedule(DiskDone, (int) this, ticks, DiskInt);
 }
 
+//----------------------------------------------------------------------
+// Disk::ReadUntimed/WriteUntimed
+// 	Read/write a single disk sector from/to the UNIX file straight
+//	away.  No time passes and no interrupt follows, so these can be
+//	called while Nachos halts, when no thread may wait for the disk;
+//	they are not counted in the statistics.
+//
+//	"sectorNumber" -- the disk sector to read/write
+//	"data" -- the bytes read/to be written
+//----------------------------------------------------------------------
+
+void
+Disk::ReadUntimed(int sectorNumber, char* data)
+{
+    ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
+
+    DEBUG('d', "Reading from sector %d, untimed\n", sectorNumber);
+    ReadImage(sectorNumber, 1, &data);
+}
+
+void
+Disk::WriteUntimed(int sectorNumber, char* data)
+{
+    ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
+
+    DEBUG('d', "Writing to sector %d, untimed\n", sectorNumber);
+    WriteImage(sectorNumber, 1, &data);
+}
+
+//----------------------------------------------------------------------
+// Disk::Flush
+// 	If the UNIX file is mapped, write the sectors changed in the
+//	mapping out to it, and wait until they are there.  Otherwise each
+//	write has gone to the file already.  No simulated time passes.
+//----------------------------------------------------------------------
+
+void
+Disk::Flush()
+{
+    if (image != NULL) {
+	DEBUG('d', "Syncing the disk\n");
+	SyncMappedFile(image, DiskSize);
+    }
+}
+
+//----------------------------------------------------------------------
+// Disk::ReadImage/WriteImage
+// 	Copy a run of sectors from/to the UNIX file: with one copy per
+//	sector if the file is mapped, otherwise with a single system call.
+//----------------------------------------------------------------------
+
+void
+Disk::ReadImage(int firstSector, int numSectors, char** data)
+{
+    if (image == NULL) {
+	ReadVector(fileno, data, numSectors, SectorSize,
+		   SectorSize * firstSector + MagicSize);
+	return;
+    }
+    for (int i = 0; i < numSectors; i++)
+	bcopy(image + MagicSize + SectorSize * (firstSector + i), data[i],
+	      SectorSize);
+}
+
+void
+Disk::WriteImage(int firstSector, int numSectors, char** data)
+{
+    if (image == NULL) {
+	WriteVector(fileno, data, numSectors, SectorSize,
+		    SectorSize * firstSector + MagicSize);
+	return;
+    }
+    for (int i = 0; i < numSectors; i++)
+	bcopy(data[i], image + MagicSize + SectorSize * (firstSector + i),
+	      SectorSize);
+}
+
 //----------------------------------------------------------------------
 // Disk::HandleInterrupt()
 // 	Called when it is time to invoke the disk interrupt handler,
@@ -252,6 +370,22 @@ Disk::ComputeLatency(int newSector, bool writing)
     return(seek + rotation + RotationTime);
 }
 
+//----------------------------------------------------------------------
+// Disk::RunTime
+// 	Return how much longer a request takes for the sectors after the
+//	first in a run: one sector's rotation each, plus a track-to-track
+//	seek each time the run goes on to the next track.
+//----------------------------------------------------------------------
+
+int
+Disk::RunTime(int firstSector, int numSectors)
+{
+    int last = firstSector + numSectors - 1;
+    int tracks = last / SectorsPerTrack - firstSector / SectorsPerTrack;
+
+    return (numSectors - 1) * RotationTime + tracks * SeekTime;
+}
+
 //----------------------------------------------------------------------
 // Disk::UpdateLast
 //   	Keep track of the most recently requested sector.  So we can know
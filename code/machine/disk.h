@@ -45,19 +45,35 @@
 // disks these days now come with a track buffer.
 //
 // The track buffer simulation can be disabled by compiling with -DNOTRACKBUF
+//
+// A request can also move a run of consecutive sectors.  After the
+// first, each takes one more sector's rotation; moving on to the next
+// track costs a track-to-track seek, the tracks being skewed so that
+// no further rotation is needed.  The UNIX file is read or written
+// with a single call for the whole run.
+//
+// Optionally, the UNIX file is mapped into memory instead, so that
+// reading or writing a sector is just a copy, with no system call.
+// The changes are synced to the file when asked, and when the disk
+// is deallocated.  The simulated timing is the same either way.
 
 #define SectorSize 		128	// number of bytes per disk sector
 #define SectorsPerTrack 	32	// number of sectors per disk track 
 #define NumTracks 		32	// number of tracks per disk
 #define NumSectors 		(SectorsPerTrack * NumTracks)
 					// total # of sectors per disk
+#define MaxTransferSectors	SectorsPerTrack
+					// most sectors in one request
 
 class Disk {
   public:
-    Disk(char* name, VoidFunctionPtr callWhenDone, int callArg);
+    Disk(char* name, VoidFunctionPtr callWhenDone, int callArg,
+	 bool mapped);
     					// Create a simulated disk.  
 					// Invoke (*callWhenDone)(callArg) 
 					// every time a request completes.
+					// If "mapped", map the UNIX file
+					// into memory.
     ~Disk();				// Deallocate the disk.
     
     void ReadRequest(int sectorNumber, char* data);
@@ -66,6 +82,19 @@ class Disk {
     					// the disk and return immediately.
     					// Only one request allowed at a time!
     void WriteRequest(int sectorNumber, char* data);
+    void ReadSectors(int firstSector, int numSectors, char** data);
+    void WriteSectors(int firstSector, int numSectors, char** data);
+					// Read/write a run of consecutive
+					// sectors as one request.  Sector
+					// "firstSector + i" is read into, or
+					// written from, "data[i]".
+    void ReadUntimed(int sectorNumber, char* data);
+    void WriteUntimed(int sectorNumber, char* data);
+					// Read/write a sector at once, taking
+					// no simulated time; only for saving
+					// cached data when Nachos halts
+    void Flush();			// Make sure everything written so
+					// far is in the UNIX file
 
     void HandleInterrupt();		// Interrupt handler, invoked when
 					// disk request finishes.
@@ -77,6 +106,8 @@ class Disk {
 
   private:
     int fileno;				// UNIX file number for simulated disk 
+    char *image;			// The UNIX file mapped into memory,
+					// or NULL if it is not mapped
     VoidFunctionPtr handler;		// Interrupt handler, to be invoked 
 					// when any disk request finishes
     int handlerArg;			// Argument to interrupt handler 
@@ -88,6 +119,12 @@ class Disk {
     int TimeToSeek(int newSector, int *rotate); // time to get to the new track
     int ModuloDiff(int to, int from);        // # sectors between to and from
     void UpdateLast(int newSector);
+    int RunTime(int firstSector, int numSectors);
+					// extra time for the sectors after
+					// the first in a run
+    void ReadImage(int firstSector, int numSectors, char** data);
+    void WriteImage(int firstSector, int numSectors, char** data);
+					// copy sectors from/to the UNIX file
 };
 
 #endif // DISK_H
@@ -168,6 +168,10 @@ Interrupt::OneTick()
 					// interrupts disabled)
     while (CheckIfDue(FALSE))		// check for pending interrupts
 	;
+#ifdef USER_PROGRAM
+    if (multiprocessor != NULL)		// give the other simulated CPUs
+	multiprocessor->MaybeSwitch();	// a turn, if we are ahead of them
+#endif
     ChangeLevel(IntOff, IntOn);		// re-enable interrupts
     if (yieldOnReturn) {		// if the timer device handler asked 
 					// for a context switch, ok to do it now
@@ -241,7 +245,21 @@ void
 Interrupt::Halt()
 {
     printf("Machine halting!\n\n");
+#ifdef FILESYS
+    bufferCache->StopTiming();		// no thread may wait for the disk
+    headerCache->Flush();		// lengths of files still open
+#endif
+#ifdef USER_PROGRAM
+    if (multiprocessor != NULL)
+	multiprocessor->Print();
+    PrintSysCallStats();
+    if (tracer != NULL)
+	tracer->Print();
+    if (caches != NULL)
+	caches->Print();
+#endif
     stats->Print();
+    stats->Export();
     Cleanup();     // Never returns.
 }
 
@@ -274,6 +292,51 @@ Interrupt::Schedule(VoidFunctionPtr handler, int arg, int fromNow, IntType type)
     pending->SortedInsert(toOccur, when);
 }
 
+//----------------------------------------------------------------------
+// Interrupt::NextPending
+// 	Return when the next interrupt of kind "type" is scheduled to
+//	occur, or -1 if there is none.  Used to checkpoint the simulation.
+//----------------------------------------------------------------------
+
+int
+Interrupt::NextPending(IntType type)
+{
+    List *others = new List;
+    PendingInterrupt *pend;
+    int when, next = -1;
+
+    while ((pend = (PendingInterrupt *) pending->SortedRemove(&when)) != NULL) {
+	if (pend->type == type && next == -1)
+	    next = when;
+	others->SortedInsert(pend, when);
+    }
+    delete pending;
+    pending = others;
+    return next;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Reschedule
+// 	Move all the pending interrupts of kind "type" to time "when".
+//	Used to restore a checkpoint, where the clock jumps forward.
+//----------------------------------------------------------------------
+
+void
+Interrupt::Reschedule(IntType type, int when)
+{
+    List *others = new List;
+    PendingInterrupt *pend;
+    int key;
+
+    while ((pend = (PendingInterrupt *) pending->SortedRemove(&key)) != NULL) {
+	if (pend->type == type)
+	    pend->when = key = when;
+	others->SortedInsert(pend, key);
+    }
+    delete pending;
+    pending = others;
+}
+
 //----------------------------------------------------------------------
 // Interrupt::CheckIfDue
 // 	Check if an interrupt is scheduled to occur, and if so, fire it off.
@@ -94,6 +94,10 @@ class Interrupt {
     
     void YieldOnReturn();		// cause a context switch on return 
 					// from an interrupt handler
+    bool getYieldOnReturn() { return yieldOnReturn; }
+    void setYieldOnReturn(bool yield) { yieldOnReturn = yield; }
+					// save/restore a pending context
+					// switch, when changing CPUs
 
     MachineStatus getStatus() { return status; } // idle, kernel, user
     void setStatus(MachineStatus st) { status = st; }
@@ -112,6 +116,12 @@ class Interrupt {
     
     void OneTick();       		// Advance simulated time
 
+    int NextPending(IntType type);	// when the next interrupt of "type"
+					// will occur, -1 if none
+    void Reschedule(IntType type, int when);
+					// make the pending interrupts of
+					// "type" occur at ``when'' instead
+
   private:
     IntStatus level;		// are interrupts enabled or disabled?
     List *pending;		// the list of interrupts scheduled
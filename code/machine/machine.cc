@@ -50,17 +50,23 @@ void CheckEndian()
 //
 //	"debug" -- if TRUE, drop into the debugger after each user instruction
 //		is executed.
+//	"sharedMemory" -- if non-NULL, the physical memory of another CPU,
+//		to be used instead of allocating our own.
 //----------------------------------------------------------------------
 
-Machine::Machine(bool debug)
+Machine::Machine(bool debug, char *sharedMemory)
 {
     int i;
 
     for (i = 0; i < NumTotalRegs; i++)
         registers[i] = 0;
-    mainMemory = new char[MemorySize];
-    for (i = 0; i < MemorySize; i++)
-      	mainMemory[i] = 0;
+    ownsMemory = (sharedMemory == NULL);
+    if (ownsMemory) {
+	mainMemory = new char[MemorySize];
+	for (i = 0; i < MemorySize; i++)
+	    mainMemory[i] = 0;
+    } else
+	mainMemory = sharedMemory;
 #ifdef USE_TLB
     tlb = new TranslationEntry[TLBSize];
     for (i = 0; i < TLBSize; i++)
@@ -72,6 +78,8 @@ Machine::Machine(bool debug)
 #endif
 
     singleStep = debug;
+    deferExceptions = FALSE;
+    deferredException = NoException;
     CheckEndian();
 }
 
@@ -82,7 +90,8 @@ Machine::Machine(bool debug)
 
 Machine::~Machine()
 {
-    delete [] mainMemory;
+    if (ownsMemory)
+	delete [] mainMemory;
     if (tlb != NULL)
         delete [] tlb;
 }
@@ -93,6 +102,10 @@ Machine::~Machine()
 //	the user program either invoked a system call, or some exception
 //	occured (such as the address translation failed).
 //
+//	If "deferExceptions" is set, the kernel may not be entered now
+//	(another host thread may be in it); the exception is recorded,
+//	to be raised later by RaiseDeferredException.
+//
 //	"which" -- the cause of the kernel trap
 //	"badVaddr" -- the virtual address causing the trap, if appropriate
 //----------------------------------------------------------------------
@@ -105,6 +118,29 @@ Machine::RaiseException(ExceptionType which, int badVAddr)
 //  ASSERT(interrupt->getStatus() == UserMode);
     registers[BadVAddrReg] = badVAddr;
     DelayedLoad(0, 0);			// finish anything in progress
+    if (deferExceptions) {
+	deferredException = which;
+	return;
+    }
+    interrupt->setStatus(SystemMode);
+    ExceptionHandler(which);		// interrupts are enabled at this point
+    interrupt->setStatus(UserMode);
+}
+
+//----------------------------------------------------------------------
+// Machine::RaiseDeferredException
+// 	Transfer control to the Nachos kernel for an exception that was
+//	recorded by RaiseException while exceptions were deferred.  The
+//	user registers are exactly as RaiseException left them.
+//----------------------------------------------------------------------
+
+void
+Machine::RaiseDeferredException()
+{
+    ExceptionType which = deferredException;
+
+    ASSERT(which != NoException);
+    deferredException = NoException;
     interrupt->setStatus(SystemMode);
     ExceptionHandler(which);		// interrupts are enabled at this point
     interrupt->setStatus(UserMode);
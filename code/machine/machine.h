@@ -106,8 +106,11 @@ class Instruction {
 
 class Machine {
   public:
-    Machine(bool debug);	// Initialize the simulation of the hardware
-				// for running user programs
+    Machine(bool debug, char *sharedMemory = NULL);
+				// Initialize the simulation of the hardware
+				// for running user programs.  Additional
+				// CPUs of a multiprocessor share the
+				// physical memory of the first one.
     ~Machine();			// De-allocate the data structures
 
 // Routines callable by the Nachos kernel
@@ -138,6 +141,9 @@ class Machine {
 				// the translation entry appropriately,
     				// and return an exception code if the 
 				// translation couldn't be completed.
+    void CacheAccess(int virtAddr, bool fetch);
+				// Simulate a user memory access in the
+				// caches, if any
 
     int GetPA (unsigned vaddr); // Returns the physical address corresponding
                                 // to the passed virtual address.
@@ -146,6 +152,14 @@ class Machine {
 				// Trap to the Nachos kernel, because of a
 				// system call or other exception.  
 
+    bool deferExceptions;	// TRUE while running user code in parallel
+				// with other CPUs; RaiseException then
+				// only records the exception
+    bool HasDeferredException() { return (deferredException != NoException); }
+    void RaiseDeferredException();
+				// Trap to the kernel for the recorded
+				// exception, once it is safe to do so
+
     void Debugger();		// invoke the user program debugger
     void DumpState();		// print the user CPU and memory state 
 
@@ -190,12 +204,17 @@ class Machine {
 				// simulated instruction
     int runUntilTime;		// drop back into the debugger when simulated
 				// time reaches this value
+    bool ownsMemory;		// FALSE if mainMemory belongs to another CPU
+    ExceptionType deferredException; // see deferExceptions
 };
 
 extern void ExceptionHandler(ExceptionType which);
 				// Entry point into Nachos for handling
 				// user system calls and exceptions
 				// Defined in exception.cc
+extern void PrintSysCallStats();
+				// Print system call counts and latencies;
+				// also defined in exception.cc
 
 
 // Routines for converting Words and Short Words to and from the
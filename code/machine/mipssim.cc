@@ -25,6 +25,10 @@ static void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
 //
 //	This routine is re-entrant, in that it can be called multiple
 //	times concurrently -- one for each thread executing user code.
+//
+//	On a multiprocessor, a thread may resume on a different CPU after
+//	a context switch, so each instruction is run on whichever Machine
+//	is current (the global "machine"), rather than on "this".
 //----------------------------------------------------------------------
 
 void
@@ -37,11 +41,13 @@ Machine::Run()
 	       currentThread->getName(), stats->totalTicks);
     interrupt->setStatus(UserMode);
     for (;;) {
+	if (machine->HasDeferredException())	// trapped during a parallel
+	    machine->RaiseDeferredException();	// epoch (see cpu.cc)
         currentThread->IncInstructionCount();
-        OneInstruction(instr);
+        machine->OneInstruction(instr);
 	interrupt->OneTick();
-	if (singleStep && (runUntilTime <= stats->totalTicks))
-	  Debugger();
+	if (machine->singleStep && (machine->runUntilTime <= stats->totalTicks))
+	  machine->Debugger();
     }
 }
 
@@ -98,10 +104,12 @@ Machine::OneInstruction(Instruction *instr)
     int nextLoadReg = 0; 	
     int nextLoadValue = 0; 	// record delayed load operation, to apply
 				// in the future
+    int address = 0;		// effective address, for the tracer
 
     // Fetch instruction 
-    if (!machine->ReadMem(registers[PCReg], 4, &raw))
+    if (!ReadMem(registers[PCReg], 4, &raw))
 	return;			// exception occurred
+    CacheAccess(registers[PCReg], TRUE);
     instr->value = raw;
     instr->Decode();
 
@@ -232,8 +240,9 @@ Machine::OneInstruction(Instruction *instr)
       case OP_LB:
       case OP_LBU:
 	tmp = registers[instr->rs] + instr->extra;
-	if (!machine->ReadMem(tmp, 1, &value))
+	if (!ReadMem(tmp, 1, &value))
 	    return;
+	CacheAccess(tmp, FALSE);
 
 	if ((value & 0x80) && (instr->opCode == OP_LB))
 	    value |= 0xffffff00;
@@ -250,8 +259,9 @@ Machine::OneInstruction(Instruction *instr)
 	    RaiseException(AddressErrorException, tmp);
 	    return;
 	}
-	if (!machine->ReadMem(tmp, 2, &value))
+	if (!ReadMem(tmp, 2, &value))
 	    return;
+	CacheAccess(tmp, FALSE);
 
 	if ((value & 0x8000) && (instr->opCode == OP_LH))
 	    value |= 0xffff0000;
@@ -272,8 +282,9 @@ Machine::OneInstruction(Instruction *instr)
 	    RaiseException(AddressErrorException, tmp);
 	    return;
 	}
-	if (!machine->ReadMem(tmp, 4, &value))
+	if (!ReadMem(tmp, 4, &value))
 	    return;
+	CacheAccess(tmp, FALSE);
 	nextLoadReg = instr->rt;
 	nextLoadValue = value;
 	break;
@@ -286,8 +297,9 @@ Machine::OneInstruction(Instruction *instr)
         // fail (I think) if the other cases are ever exercised.
 	ASSERT((tmp & 0x3) == 0);  
 
-	if (!machine->ReadMem(tmp, 4, &value))
+	if (!ReadMem(tmp, 4, &value))
 	    return;
+	CacheAccess(tmp, FALSE);
 	if (registers[LoadReg] == instr->rt)
 	    nextLoadValue = registers[LoadValueReg];
 	else
@@ -317,8 +329,9 @@ Machine::OneInstruction(Instruction *instr)
         // fail (I think) if the other cases are ever exercised.
 	ASSERT((tmp & 0x3) == 0);  
 
-	if (!machine->ReadMem(tmp, 4, &value))
+	if (!ReadMem(tmp, 4, &value))
 	    return;
+	CacheAccess(tmp, FALSE);
 	if (registers[LoadReg] == instr->rt)
 	    nextLoadValue = registers[LoadValueReg];
 	else
@@ -382,15 +395,17 @@ Machine::OneInstruction(Instruction *instr)
 	break;
 	
       case OP_SB:
-	if (!machine->WriteMem((unsigned) 
+	if (!WriteMem((unsigned) 
 		(registers[instr->rs] + instr->extra), 1, registers[instr->rt]))
 	    return;
+	CacheAccess(registers[instr->rs] + instr->extra, FALSE);
 	break;
 	
       case OP_SH:
-	if (!machine->WriteMem((unsigned) 
+	if (!WriteMem((unsigned) 
 		(registers[instr->rs] + instr->extra), 2, registers[instr->rt]))
 	    return;
+	CacheAccess(registers[instr->rs] + instr->extra, FALSE);
 	break;
 	
       case OP_SLL:
@@ -470,9 +485,10 @@ Machine::OneInstruction(Instruction *instr)
 	break;
 	
       case OP_SW:
-	if (!machine->WriteMem((unsigned) 
+	if (!WriteMem((unsigned) 
 		(registers[instr->rs] + instr->extra), 4, registers[instr->rt]))
 	    return;
+	CacheAccess(registers[instr->rs] + instr->extra, FALSE);
 	break;
 	
       case OP_SWL:	  
@@ -482,7 +498,7 @@ Machine::OneInstruction(Instruction *instr)
         // fail (I think) if the other cases are ever exercised.
 	ASSERT((tmp & 0x3) == 0);  
 
-	if (!machine->ReadMem((tmp & ~0x3), 4, &value))
+	if (!ReadMem((tmp & ~0x3), 4, &value))
 	    return;
 	switch (tmp & 0x3) {
 	  case 0:
@@ -501,8 +517,9 @@ Machine::OneInstruction(Instruction *instr)
 					    0xff);
 	    break;
 	}
-	if (!machine->WriteMem((tmp & ~0x3), 4, value))
+	if (!WriteMem((tmp & ~0x3), 4, value))
 	    return;
+	CacheAccess(tmp & ~0x3, FALSE);
 	break;
     	
       case OP_SWR:	  
@@ -512,7 +529,7 @@ Machine::OneInstruction(Instruction *instr)
         // fail (I think) if the other cases are ever exercised.
 	ASSERT((tmp & 0x3) == 0);  
 
-	if (!machine->ReadMem((tmp & ~0x3), 4, &value))
+	if (!ReadMem((tmp & ~0x3), 4, &value))
 	    return;
 	switch (tmp & 0x3) {
 	  case 0:
@@ -528,11 +545,16 @@ Machine::OneInstruction(Instruction *instr)
 	    value = registers[instr->rt];
 	    break;
 	}
-	if (!machine->WriteMem((tmp & ~0x3), 4, value))
+	if (!WriteMem((tmp & ~0x3), 4, value))
 	    return;
+	CacheAccess(tmp & ~0x3, FALSE);
 	break;
     	
       case OP_SYSCALL:
+	if (tracer != NULL)		// the kernel completes it, and does
+					// not restart it
+	    tracer->Executed(currentThread->GetPID(), registers[PCReg],
+			     instr->opCode, 0, FALSE);
 	RaiseException(SyscallException, 0);
 	return; 
 	
@@ -555,6 +577,9 @@ Machine::OneInstruction(Instruction *instr)
     
     // Now we have successfully executed the instruction.
     
+    if (tracer != NULL)			// before the delayed load changes rs
+	address = registers[instr->rs] + instr->extra;
+
     // Do any delayed load operation
     DelayedLoad(nextLoadReg, nextLoadValue);
     
@@ -563,6 +588,11 @@ Machine::OneInstruction(Instruction *instr)
 						// are jumping into lala-land
     registers[PCReg] = registers[NextPCReg];
     registers[NextPCReg] = pcAfter;
+
+    if (tracer != NULL)
+	tracer->Executed(currentThread->GetPID(), registers[PrevPCReg],
+			 instr->opCode, address,
+			 pcAfter != registers[PCReg] + 4);
 }
 
 //----------------------------------------------------------------------
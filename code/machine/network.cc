@@ -62,12 +62,23 @@ Network::CheckPktAvail()
 
     if (inHdr.length != 0) 	// do nothing if packet is already buffered
 	return;		
-    if (!PollSocket(sock)) 	// do nothing if no packet to be read
-	return;
 
-    // otherwise, read packet in
+    // otherwise, read packet in -- from the input log, if replaying
     char *buffer = new char[MaxWireSize];
-    ReadFromSocket(sock, buffer, MaxWireSize);
+    if (inputLog != NULL && inputLog->IsReplaying()) {
+	if (inputLog->Replay(NetworkInput, buffer) < 0) {
+	    delete []buffer;
+	    return;
+	}
+    } else {
+	if (!PollSocket(sock)) {	// do nothing if no packet to be read
+	    delete []buffer;
+	    return;
+	}
+	ReadFromSocket(sock, buffer, MaxWireSize);
+	if (inputLog != NULL)
+	    inputLog->Record(NetworkInput, buffer, MaxWireSize);
+    }
 
     // divide packet into header and data
     inHdr = *(PacketHeader *)buffer;
@@ -114,6 +125,8 @@ Network::Send(PacketHeader hdr, char* data)
 	DEBUG('n', "oops, lost it!\n");
 	return;
     }
+    if (inputLog != NULL && inputLog->IsReplaying())
+	return;			// the other machines are not listening
 
     // concatenate hdr and data into a single buffer, and send it out
     char *buffer = new char[MaxWireSize];
@@ -0,0 +1,140 @@
+// replay.cc
+//	Routines to record and replay the inputs of a simulation.  See
+//	replay.h for the format of the log.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include <stdlib.h>		// for rand(); before sysdep.h
+#include "copyright.h"
+#include "replay.h"
+#include "system.h"
+
+static char *inputKindNames[] = { "console", "network", "random" };
+
+//----------------------------------------------------------------------
+// InputLog::InputLog
+// 	Open the log of inputs.
+//
+//	"fileName" -- where the log is kept
+//	"replay" -- if TRUE, read the inputs from the log; otherwise write
+//		the inputs of this run to it
+//----------------------------------------------------------------------
+
+InputLog::InputLog(char *fileName, bool replay)
+{
+    replaying = replay;
+    numRecords = 0;
+    haveNext = FALSE;
+    fp = fopen(fileName, replaying ? "rb" : "wb");
+    if (fp == NULL) {
+	perror(fileName);
+	ASSERT(FALSE);
+    }
+    if (replaying)
+	ReadNext();
+}
+
+//----------------------------------------------------------------------
+// InputLog::~InputLog
+// 	Close the log.  Warn if a replay did not use all of it.
+//----------------------------------------------------------------------
+
+InputLog::~InputLog()
+{
+    if (replaying && haveNext)
+	printf("Replay stopped before the %s input logged at tick %d\n",
+	       inputKindNames[nextKind], nextTick);
+    DEBUG('i', "%s %d inputs\n", replaying ? "Replayed" : "Recorded",
+	  numRecords);
+    fclose(fp);
+}
+
+//----------------------------------------------------------------------
+// InputLog::ReadNext
+// 	Read the next record of the log ahead, so that we can tell when
+//	it is due.
+//----------------------------------------------------------------------
+
+void
+InputLog::ReadNext()
+{
+    int kind = getc(fp);
+
+    haveNext = FALSE;
+    if (kind == EOF)
+	return;
+    if (fread(&nextTick, sizeof(int), 1, fp) != 1 ||
+	fread(&nextLength, sizeof(int), 1, fp) != 1 ||
+	nextLength < 0 || nextLength > MaxInputLength ||
+	(int) fread(nextData, sizeof(char), nextLength, fp) != nextLength) {
+	printf("Input log is truncated after %d records\n", numRecords);
+	return;
+    }
+    nextKind = (InputKind) kind;
+    haveNext = TRUE;
+}
+
+//----------------------------------------------------------------------
+// InputLog::Record
+// 	Append an input of "kind", taken at the current tick, to the log.
+//----------------------------------------------------------------------
+
+void
+InputLog::Record(InputKind kind, char *data, int length)
+{
+    ASSERT(!replaying && length <= MaxInputLength);
+    putc(kind, fp);
+    fwrite(&stats->totalTicks, sizeof(int), 1, fp);
+    fwrite(&length, sizeof(int), 1, fp);
+    fwrite(data, sizeof(char), length, fp);
+    numRecords++;
+}
+
+//----------------------------------------------------------------------
+// InputLog::Replay
+// 	Called by a device where it would poll the host for input.  If
+//	the next logged input is of "kind" and was taken at or before the
+//	current tick, hand it over.
+//
+//	Returns the length of the input copied into "data", or -1 if
+//	there is none.
+//----------------------------------------------------------------------
+
+int
+InputLog::Replay(InputKind kind, char *data)
+{
+    int length;
+
+    ASSERT(replaying);
+    if (!haveNext || nextKind != kind || nextTick > stats->totalTicks)
+	return -1;
+    length = nextLength;
+    bcopy(nextData, data, length);
+    numRecords++;
+    ReadNext();
+    return length;
+}
+
+//----------------------------------------------------------------------
+// InputLog::Random
+// 	Return a pseudo-random number.  When recording, take one from the
+//	host and log it; when replaying, the next input must be it.
+//----------------------------------------------------------------------
+
+int
+InputLog::Random()
+{
+    int value;
+
+    if (!replaying) {
+	value = rand();
+	Record(RandomInput, (char *) &value, sizeof(int));
+    } else if (Replay(RandomInput, (char *) &value) != sizeof(int)) {
+	printf("Replay diverged from the input log at tick %d\n",
+	       stats->totalTicks);
+	ASSERT(FALSE);
+    }
+    return value;
+}
@@ -0,0 +1,77 @@
+// replay.h
+//	Data structures to record the inputs a simulation receives from
+//	the outside world, and to feed them back in a later run.
+//
+//	The simulation is deterministic except for its inputs: characters
+//	typed at the console, packets arriving from the network, and the
+//	pseudo-random numbers behind "-rs" and lost packets.  With
+//	"-record <file>", each of them is logged together with the tick
+//	at which the simulation took it.  With "-replay <file>", the
+//	devices take their inputs from the log instead: the console and
+//	network no longer poll the host or send packets out, and Random()
+//	returns the logged numbers.  The device poll interrupts still
+//	happen, since they are part of the simulated timing, so a replay
+//	goes through exactly the same ticks as the recorded run, provided
+//	it is given the same flags and user programs.
+//
+//	A log is a sequence of binary records, each
+//
+//		the input kind (one byte)
+//		the tick it was taken (an int)
+//		its length in bytes (an int), then the bytes
+//
+//	in host byte order.  If a replay asks for a random number the log
+//	does not have next, it has diverged from the recording, and we
+//	stop.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "copyright.h"
+#include <stdio.h>
+
+// Kinds of inputs
+enum InputKind { ConsoleInput, NetworkInput, RandomInput };
+
+#define MaxInputLength	128	// longest input, in bytes
+
+// The following class defines the log of inputs, being either written
+// or read.
+
+class InputLog {
+  public:
+    InputLog(char *fileName, bool replay);	// start recording to, or
+					// replaying from, "fileName"
+    ~InputLog();			// flush and close the log
+
+    bool IsReplaying() { return replaying; }
+
+    void Record(InputKind kind, char *data, int length);
+				// Log an input that was taken now
+    int Replay(InputKind kind, char *data);
+				// If an input of "kind" was taken by now,
+				// copy it to "data" and return its length;
+				// otherwise return -1
+    int Random();		// A pseudo-random number, logged or
+				// replayed
+
+  private:
+    FILE *fp;			// the log
+    bool replaying;		// reading the log, rather than writing it
+    int numRecords;		// records written or replayed
+
+    // While replaying, the next record, read ahead
+    bool haveNext;		// FALSE at the end of the log
+    InputKind nextKind;
+    int nextTick;
+    int nextLength;
+    char nextData[MaxInputLength];
+
+    void ReadNext();		// read ahead the next record
+};
+
+#endif // REPLAY_H
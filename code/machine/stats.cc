@@ -15,6 +15,135 @@
 #define max(a, b) ((a) > (b) ? (a) : (b))
 #define min(a, b) ((a) < (b) ? (a) : (b))
 
+//----------------------------------------------------------------------
+// Histogram::Histogram
+// 	Initialize an empty histogram.
+//----------------------------------------------------------------------
+
+Histogram::Histogram()
+{
+    count = 0;
+    minValue = INT_MAX;
+    maxValue = INT_MIN;
+    sum = 0;
+    for (int i = 0; i < HistogramBuckets; i++)
+	buckets[i] = 0;
+}
+
+//----------------------------------------------------------------------
+// Histogram::Record
+// 	Add "value" to the histogram.
+//----------------------------------------------------------------------
+
+void
+Histogram::Record(int value)
+{
+    int bucket = 0;
+
+    count++;
+    sum += value;
+    minValue = min(minValue, value);
+    maxValue = max(maxValue, value);
+
+    while (value > 0 && bucket < HistogramBuckets - 1) {
+	value >>= 1;
+	bucket++;
+    }
+    buckets[bucket]++;
+}
+
+//----------------------------------------------------------------------
+// Histogram::Print
+// 	Print a summary line, followed by one line per non-empty bucket
+//	giving its range and count.
+//----------------------------------------------------------------------
+
+void
+Histogram::Print(char *title)
+{
+    printf("%s: %d samples", title, count);
+    if (count == 0) {
+	printf("\n");
+	return;
+    }
+    printf(", min %d, max %d, mean %f\n", minValue, maxValue, Mean());
+    for (int i = 0; i < HistogramBuckets; i++) {
+	if (buckets[i] == 0)
+	    continue;
+	if (i == 0)
+	    printf("    <= 0: %d\n", buckets[i]);
+	else
+	    printf("    [%d, %d): %d\n", BucketLow(i), BucketHigh(i),
+		   buckets[i]);
+    }
+}
+
+//----------------------------------------------------------------------
+// Histogram::BucketLow, Histogram::BucketHigh
+// 	Return the bounds of the values counted in "bucket": from
+//	BucketLow up to, but not including, BucketHigh.  The first bucket
+//	starts at the smallest sample seen.
+//----------------------------------------------------------------------
+
+int
+Histogram::BucketLow(int bucket)
+{
+    return (bucket == 0) ? min(minValue, 0) : 1 << (bucket - 1);
+}
+
+int
+Histogram::BucketHigh(int bucket)
+{
+    return (bucket < 31) ? (1 << bucket) : INT_MAX;
+}
+
+//----------------------------------------------------------------------
+// Histogram::WriteJSON
+// 	Write the histogram to "fp" as a JSON object, giving the bounds
+//	and count of each non-empty bucket.
+//----------------------------------------------------------------------
+
+void
+Histogram::WriteJSON(FILE *fp)
+{
+    bool first = TRUE;
+
+    fprintf(fp, "{\"count\": %d", count);
+    if (count > 0)
+	fprintf(fp, ", \"min\": %d, \"max\": %d, \"mean\": %f", minValue,
+		maxValue, Mean());
+    fprintf(fp, ", \"buckets\": [");
+    for (int i = 0; i < HistogramBuckets; i++) {
+	if (buckets[i] == 0)
+	    continue;
+	fprintf(fp, "%s{\"low\": %d, \"high\": %d, \"count\": %d}",
+		first ? "" : ", ", BucketLow(i), BucketHigh(i), buckets[i]);
+	first = FALSE;
+    }
+    fprintf(fp, "]}");
+}
+
+//----------------------------------------------------------------------
+// Histogram::WriteCSV
+// 	Write the histogram to "fp" as rows of the CSV file written by
+//	Statistics::Export: first the summary, then one row per non-empty
+//	bucket, keyed by the bucket's lower bound.
+//----------------------------------------------------------------------
+
+void
+Histogram::WriteCSV(FILE *fp, char *name)
+{
+    fprintf(fp, "histogram,%s,count,%d\n", name, count);
+    if (count == 0)
+	return;
+    fprintf(fp, "histogram,%s,min,%d\n", name, minValue);
+    fprintf(fp, "histogram,%s,max,%d\n", name, maxValue);
+    fprintf(fp, "histogram,%s,mean,%f\n", name, Mean());
+    for (int i = 0; i < HistogramBuckets; i++)
+	if (buckets[i] != 0)
+	    fprintf(fp, "bucket,%s,%d,%d\n", name, BucketLow(i), buckets[i]);
+}
+
 //----------------------------------------------------------------------
 // Statistics::Statistics
 // 	Initialize performance metrics to zero, at system startup.
@@ -24,6 +153,10 @@ Statistics::Statistics()
 {
     totalTicks = idleTicks = systemTicks = userTicks = 0;
     numDiskReads = numDiskWrites = 0;
+    numDiskSeekTracks = maxDiskQueue = 0;
+    numBufferCacheHits = numBufferCacheMisses = 0;
+    numBufferCacheEvictions = numBufferCacheWriteBacks = 0;
+    numBufferCacheReadAheads = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
     cpuBusyTime = cpuUtilization = 0;
@@ -32,7 +165,21 @@ Statistics::Statistics()
     avgCPUBurst = totalCPUBursts = avgWaitingTime = avgFinishTime = 0;
     timerInterruptTicks = 100;
     errorCPUBurst = 0;
+    totalWaitTime = totalWaits = 0;
+    numContextSwitches = numQuantumRetunes = 0;
+    numRealTimeJobs = numDeadlineMisses = numBudgetOverruns = 0;
+    numMigrations = numLoadBalances = numSteals = 0;
+    totalCompletions = 0;
+    sumSquaredFinishTime = 0;
     a = 0.5;
+    cpuBursts = new Histogram;
+    waitTimes = new Histogram;
+    finishTimes = new Histogram;
+    diskLatencies = new Histogram;
+    syscallLatencies = new Histogram;
+    processes = new List;
+    numProcesses = 0;
+    jsonFileName = csvFileName = NULL;
 }
 
 //----------------------------------------------------------------------
@@ -50,6 +197,7 @@ Statistics::trackCPUBurst(int currentBurst)
 
 	maxCPUBurst = max(maxCPUBurst, currentBurst);
 	minCPUBurst = min(minCPUBurst, currentBurst);
+	cpuBursts->Record(currentBurst);
     }
 #endif
 }
@@ -62,6 +210,10 @@ Statistics::trackWaitTime(int currentWaitTime)
 {
     avgWaitingTime = avgWaitingTime*executableCount + currentWaitTime;
     avgWaitingTime /= executableCount;
+
+    totalWaitTime += currentWaitTime;
+    totalWaits++;
+    waitTimes->Record(currentWaitTime);
 }
 
 //----------------------------------------------------------------------
@@ -70,7 +222,8 @@ Statistics::trackWaitTime(int currentWaitTime)
 void
 Statistics::trackFinishTime(int currentFinishTime)
 {
-    finishTimeArray[totalCompletions] = currentFinishTime;
+    sumSquaredFinishTime += (double) currentFinishTime * currentFinishTime;
+    finishTimes->Record(currentFinishTime);
     avgFinishTime = avgFinishTime*totalCompletions + currentFinishTime;
     totalCompletions++;
     avgFinishTime /= totalCompletions;
@@ -79,22 +232,29 @@ Statistics::trackFinishTime(int currentFinishTime)
     minFinishTime = min(minFinishTime, currentFinishTime);
 }
 
+//----------------------------------------------------------------------
+// Statistics::trackProcess
+// 	Keep the record of a process that has exited, for Export.
+//----------------------------------------------------------------------
+void
+Statistics::trackProcess(ProcessRecord *record)
+{
+    processes->Append((void *) record);
+    numProcesses++;
+}
+
 //----------------------------------------------------------------------
 // Statistics::evaluateVariance
-// 	Evaluate variance of thread completion times.
+// 	Evaluate variance of thread completion times, over all the
+//	threads that have completed.
 //----------------------------------------------------------------------
 float
 Statistics::evaluateVariance()
 {
-    float varianceFinishTimes = 0;
-
-    // Evaluate variance of thread completion times.
-    for (int index = 0; index < 10; index++)
-        varianceFinishTimes += (finishTimeArray[index]-avgFinishTime)
-			     * (finishTimeArray[index]-avgFinishTime);
-
-    varianceFinishTimes /= totalCompletions;
-    return varianceFinishTimes;
+    if (totalCompletions == 0)
+	return 0;
+    return sumSquaredFinishTime / totalCompletions
+	   - (double) avgFinishTime * avgFinishTime;
 }
 
 //----------------------------------------------------------------------
@@ -109,6 +269,14 @@ Statistics::Print()
     printf("Ticks: total %d, idle %d, system %d, user %d\n", totalTicks,
 	idleTicks, systemTicks, userTicks);
     printf("Disk I/O: reads %d, writes %d\n", numDiskReads, numDiskWrites);
+    if (numDiskSeekTracks > 0 || maxDiskQueue > 0)
+	printf("Disk seeks: %d tracks, longest queue %d\n", numDiskSeekTracks,
+	       maxDiskQueue);
+    if (numBufferCacheHits > 0 || numBufferCacheMisses > 0)
+	printf("Buffer cache: hits %d, misses %d, evictions %d, "
+	       "write-backs %d, read-aheads %d\n", numBufferCacheHits,
+	       numBufferCacheMisses, numBufferCacheEvictions,
+	       numBufferCacheWriteBacks, numBufferCacheReadAheads);
     printf("Console I/O: reads %d, writes %d\n", numConsoleCharsRead,
 	numConsoleCharsWritten);
     printf("Paging: faults %d\n", numPageFaults);
@@ -132,8 +300,217 @@ Statistics::Print()
 	printf("Error in CPU burst estimation: %f\n", errorCPUBurst / (avgCPUBurst*totalCPUBursts));
     printf("Number of non-zero CPU bursts: %d\n", totalCPUBursts);
     printf("Average waiting time in ready queue: %f\n", avgWaitingTime);
+    printf("Number of context switches: %d\n", numContextSwitches);
+    if (numQuantumRetunes > 0)
+	printf("Adaptive quantum: %d ticks after %d retunes\n",
+	       timerInterruptTicks, numQuantumRetunes);
     printf("Maximum thread completion time: %d\n", maxFinishTime);
     printf("Minimum thread completion time: %d\n", minFinishTime);
     printf("Average thread completion time: %f\n", avgFinishTime);
     printf("Variance of thread completion times: %f\n", evaluateVariance());
+    if (numRealTimeJobs > 0 || numDeadlineMisses > 0) {
+	printf("Real-time jobs completed: %d\n", numRealTimeJobs);
+	printf("Real-time deadline misses: %d\n", numDeadlineMisses);
+	printf("Real-time budget overruns: %d\n", numBudgetOverruns);
+    }
+    if (numMigrations > 0 || numLoadBalances > 0 || numSteals > 0) {
+	printf("Thread migrations: %d\n", numMigrations);
+	printf("Threads moved by the load balancer: %d\n", numLoadBalances);
+	printf("Threads stolen by idle CPUs: %d\n", numSteals);
+    }
+}
+
+//----------------------------------------------------------------------
+// Statistics::Export
+// 	Write the collected statistics, including the full distributions
+//	and one entry per exited process, to jsonFileName as a JSON
+//	object and to csvFileName as CSV, for tools to pick up.  Either
+//	may be NULL.
+//
+//	The CSV file has one value per row: "kind,name,field,value".
+//----------------------------------------------------------------------
+
+static char *histogramNames[] = { "cpu_burst", "ready_wait", "completion",
+				  "disk_latency", "syscall_latency" };
+
+void
+Statistics::Export()
+{
+    Histogram *histograms[] = { cpuBursts, waitTimes, finishTimes,
+				diskLatencies, syscallLatencies };
+    int numHistograms = sizeof(histograms) / sizeof(Histogram *);
+    ProcessRecord *r;
+    FILE *fp;
+    int i;
+
+    if (jsonFileName != NULL) {
+	fp = fopen(jsonFileName, "w");
+	if (fp == NULL) {
+	    perror(jsonFileName);
+	} else {
+	    fprintf(fp, "{\"ticks\": {\"total\": %d, \"idle\": %d, "
+		    "\"system\": %d, \"user\": %d},\n", totalTicks, idleTicks,
+		    systemTicks, userTicks);
+	    fprintf(fp, " \"disk\": {\"reads\": %d, \"writes\": %d, "
+		    "\"seek_tracks\": %d, \"max_queue\": %d},\n", numDiskReads,
+		    numDiskWrites, numDiskSeekTracks, maxDiskQueue);
+	    fprintf(fp, " \"buffer_cache\": {\"hits\": %d, \"misses\": %d, "
+		    "\"evictions\": %d, \"write_backs\": %d, "
+		    "\"read_aheads\": %d},\n", numBufferCacheHits,
+		    numBufferCacheMisses, numBufferCacheEvictions,
+		    numBufferCacheWriteBacks, numBufferCacheReadAheads);
+	    fprintf(fp, " \"console\": {\"reads\": %d, \"writes\": %d},\n",
+		    numConsoleCharsRead, numConsoleCharsWritten);
+	    fprintf(fp, " \"page_faults\": %d,\n", numPageFaults);
+	    fprintf(fp, " \"network\": {\"received\": %d, \"sent\": %d},\n",
+		    numPacketsRecvd, numPacketsSent);
+	    fprintf(fp, " \"execution_time\": %d,\n",
+		    totalTicks - simulationStartTime);
+	    fprintf(fp, " \"context_switches\": %d,\n", numContextSwitches);
+	    fprintf(fp, " \"completion_variance\": %f,\n", evaluateVariance());
+	    fprintf(fp, " \"migrations\": %d, \"load_balances\": %d, "
+		    "\"steals\": %d,\n", numMigrations, numLoadBalances,
+		    numSteals);
+	    fprintf(fp, " \"real_time\": {\"jobs\": %d, \"deadline_misses\": %d, "
+		    "\"budget_overruns\": %d},\n", numRealTimeJobs,
+		    numDeadlineMisses, numBudgetOverruns);
+	    fprintf(fp, " \"histograms\": {");
+	    for (i = 0; i < numHistograms; i++) {
+		fprintf(fp, "%s\n  \"%s\": ", (i == 0) ? "" : ",",
+			histogramNames[i]);
+		histograms[i]->WriteJSON(fp);
+	    }
+	    fprintf(fp, "},\n \"processes\": [");
+	    for (i = 0; i < numProcesses; i++) {	// rotate through the list
+		r = (ProcessRecord *) processes->Remove();
+		fprintf(fp, "%s\n  {\"pid\": %d, \"exit_code\": %d, "
+			"\"start\": %d, \"finish\": %d, \"cpu_time\": %d, "
+			"\"bursts\": %d, \"wait_time\": %d, \"waits\": %d}",
+			(i == 0) ? "" : ",", r->pid, r->exitCode, r->startTime,
+			r->finishTime, r->cpuTime, r->numBursts, r->waitTime,
+			r->numWaits);
+		processes->Append((void *) r);
+	    }
+	    fprintf(fp, "]}\n");
+	    fclose(fp);
+	}
+    }
+
+    if (csvFileName != NULL) {
+	fp = fopen(csvFileName, "w");
+	if (fp == NULL) {
+	    perror(csvFileName);
+	    return;
+	}
+	fprintf(fp, "kind,name,field,value\n");
+	fprintf(fp, "metric,ticks,total,%d\n", totalTicks);
+	fprintf(fp, "metric,ticks,idle,%d\n", idleTicks);
+	fprintf(fp, "metric,ticks,system,%d\n", systemTicks);
+	fprintf(fp, "metric,ticks,user,%d\n", userTicks);
+	fprintf(fp, "metric,disk,reads,%d\n", numDiskReads);
+	fprintf(fp, "metric,disk,writes,%d\n", numDiskWrites);
+	fprintf(fp, "metric,disk,seek_tracks,%d\n", numDiskSeekTracks);
+	fprintf(fp, "metric,disk,max_queue,%d\n", maxDiskQueue);
+	fprintf(fp, "metric,buffer_cache,hits,%d\n", numBufferCacheHits);
+	fprintf(fp, "metric,buffer_cache,misses,%d\n", numBufferCacheMisses);
+	fprintf(fp, "metric,buffer_cache,evictions,%d\n",
+		numBufferCacheEvictions);
+	fprintf(fp, "metric,buffer_cache,write_backs,%d\n",
+		numBufferCacheWriteBacks);
+	fprintf(fp, "metric,buffer_cache,read_aheads,%d\n",
+		numBufferCacheReadAheads);
+	fprintf(fp, "metric,console,reads,%d\n", numConsoleCharsRead);
+	fprintf(fp, "metric,console,writes,%d\n", numConsoleCharsWritten);
+	fprintf(fp, "metric,page_faults,count,%d\n", numPageFaults);
+	fprintf(fp, "metric,network,received,%d\n", numPacketsRecvd);
+	fprintf(fp, "metric,network,sent,%d\n", numPacketsSent);
+	fprintf(fp, "metric,execution_time,ticks,%d\n",
+		totalTicks - simulationStartTime);
+	fprintf(fp, "metric,context_switches,count,%d\n", numContextSwitches);
+	fprintf(fp, "metric,completion,variance,%f\n", evaluateVariance());
+	fprintf(fp, "metric,migrations,count,%d\n", numMigrations);
+	fprintf(fp, "metric,load_balances,count,%d\n", numLoadBalances);
+	fprintf(fp, "metric,steals,count,%d\n", numSteals);
+	fprintf(fp, "metric,real_time,jobs,%d\n", numRealTimeJobs);
+	fprintf(fp, "metric,real_time,deadline_misses,%d\n", numDeadlineMisses);
+	fprintf(fp, "metric,real_time,budget_overruns,%d\n", numBudgetOverruns);
+	for (i = 0; i < numHistograms; i++)
+	    histograms[i]->WriteCSV(fp, histogramNames[i]);
+	for (i = 0; i < numProcesses; i++) {
+	    r = (ProcessRecord *) processes->Remove();
+	    fprintf(fp, "process,%d,exit_code,%d\n", r->pid, r->exitCode);
+	    fprintf(fp, "process,%d,start,%d\n", r->pid, r->startTime);
+	    fprintf(fp, "process,%d,finish,%d\n", r->pid, r->finishTime);
+	    fprintf(fp, "process,%d,cpu_time,%d\n", r->pid, r->cpuTime);
+	    fprintf(fp, "process,%d,bursts,%d\n", r->pid, r->numBursts);
+	    fprintf(fp, "process,%d,wait_time,%d\n", r->pid, r->waitTime);
+	    fprintf(fp, "process,%d,waits,%d\n", r->pid, r->numWaits);
+	    processes->Append((void *) r);
+	}
+	fclose(fp);
+    }
+}
+
+//----------------------------------------------------------------------
+// Statistics::Checkpoint
+// 	Write all the statistics to the checkpoint "fp": the counters,
+//	the distributions, and the records of exited processes.
+//----------------------------------------------------------------------
+
+void
+Statistics::Checkpoint(FILE *fp)
+{
+    Histogram *histograms[] = { cpuBursts, waitTimes, finishTimes,
+				diskLatencies, syscallLatencies };
+    ProcessRecord *r;
+    int i;
+
+    fwrite(this, sizeof(Statistics), 1, fp);	// Restore ignores the
+						// pointers
+    for (i = 0; i < (int) (sizeof(histograms) / sizeof(Histogram *)); i++)
+	fwrite(histograms[i], sizeof(Histogram), 1, fp);
+    for (i = 0; i < numProcesses; i++) {	// rotate through the list
+	r = (ProcessRecord *) processes->Remove();
+	fwrite(r, sizeof(ProcessRecord), 1, fp);
+	processes->Append((void *) r);
+    }
+}
+
+//----------------------------------------------------------------------
+// Statistics::Restore
+// 	Replace all the statistics with those saved by Checkpoint.  The
+//	export file names stay those given on this command line.
+//----------------------------------------------------------------------
+
+void
+Statistics::Restore(FILE *fp)
+{
+    Histogram *histograms[] = { cpuBursts, waitTimes, finishTimes,
+				diskLatencies, syscallLatencies };
+    List *processList = processes;
+    char *json = jsonFileName, *csv = csvFileName;
+    ProcessRecord *r;
+    int i, savedProcesses;
+
+    fread(this, sizeof(Statistics), 1, fp);
+    cpuBursts = histograms[0];			// keep our own pointers
+    waitTimes = histograms[1];
+    finishTimes = histograms[2];
+    diskLatencies = histograms[3];
+    syscallLatencies = histograms[4];
+    processes = processList;
+    jsonFileName = json;
+    csvFileName = csv;
+
+    for (i = 0; i < (int) (sizeof(histograms) / sizeof(Histogram *)); i++)
+	fread(histograms[i], sizeof(Histogram), 1, fp);
+    while ((r = (ProcessRecord *) processes->Remove()) != NULL)
+	delete r;
+    savedProcesses = numProcesses;
+    numProcesses = 0;
+    for (i = 0; i < savedProcesses; i++) {
+	r = new ProcessRecord;
+	fread(r, sizeof(ProcessRecord), 1, fp);
+	trackProcess(r);
+    }
 }
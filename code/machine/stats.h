@@ -12,6 +12,49 @@
 #define STATS_H
 
 #include "copyright.h"
+#include "list.h"
+#include <stdio.h>
+
+// The following class defines a histogram with logarithmic buckets:
+// bucket 0 counts values <= 0, and bucket i > 0 counts values in
+// [2^(i-1), 2^i).  This keeps the histogram small while still showing
+// the shape of distributions (latencies, bursts) spanning many orders
+// of magnitude.
+
+#define HistogramBuckets 32
+
+class Histogram {
+  public:
+    Histogram();		// initialize an empty histogram
+    void Record(int value);	// add one sample
+    void Print(char *title);	// print non-empty buckets, one per line
+    void WriteJSON(FILE *fp);	// write as a JSON object
+    void WriteCSV(FILE *fp, char *name);	// write as CSV rows
+    int BucketLow(int bucket);	// smallest value counted in "bucket"
+    int BucketHigh(int bucket);	// ... and the next value after it
+    float Mean() { return (count > 0) ? sum / count : 0; }
+
+    int count;			// number of samples
+    int minValue, maxValue;	// smallest and largest sample
+    float sum;			// sum of samples
+    int buckets[HistogramBuckets];
+};
+
+// The following class records how one process fared, for the per-process
+// breakdown in the exported statistics.  The fields are public to make
+// it simpler to fill in.
+
+class ProcessRecord {
+  public:
+    int pid;
+    int exitCode;
+    int startTime;		// when the process was created
+    int finishTime;		// when it called Exit
+    int cpuTime;		// ticks spent running
+    int numBursts;		// number of non-zero CPU bursts
+    int waitTime;		// ticks spent in the ready queue
+    int numWaits;		// number of times it was dispatched
+};
 
 // The following class defines the statistics that are to be kept
 // about Nachos behavior -- how much time (ticks) elapsed, how
@@ -30,6 +73,13 @@ class Statistics {
 
     int numDiskReads;		// number of disk read requests
     int numDiskWrites;		// number of disk write requests
+    int numDiskSeekTracks;	// tracks the disk head moved across
+    int maxDiskQueue;		// most disk requests waiting at once
+    int numBufferCacheHits;	// sector reads found in the buffer cache
+    int numBufferCacheMisses;	// ... and read from disk
+    int numBufferCacheEvictions; // cached sectors replaced by others
+    int numBufferCacheWriteBacks; // dirty cached sectors written to disk
+    int numBufferCacheReadAheads; // sectors read into the cache ahead
     int numConsoleCharsRead;	// number of characters read from the keyboard
     int numConsoleCharsWritten; // number of characters written to the display
     int numPageFaults;		// number of virtual memory page faults
@@ -47,21 +97,46 @@ class Statistics {
     int totalCPUBursts; 	// Number of non-zero CPU bursts
     float errorCPUBurst; 	// Error in CPU burst estimation
     float avgWaitingTime;	// Average waiting time in the ready queue
+    int totalWaitTime;		// Sum of all waits in the ready queue
+    int totalWaits;		// Number of waits in the ready queue
+    int numContextSwitches;	// Number of switches to a different thread
+    int numQuantumRetunes;	// Number of adaptive quantum changes
+    int numRealTimeJobs;	// Number of completed real-time jobs
+    int numDeadlineMisses;	// ... that finished past their deadline
+    int numBudgetOverruns;	// Number of exhausted real-time budgets
+    int numMigrations;		// Number of dispatches on a different CPU
+				// than the thread last ran on
+    int numLoadBalances;	// Number of threads moved by the balancer
+    int numSteals;		// Number of threads stolen by idle CPUs
     int maxFinishTime;		// Maximum thread completion time
     int minFinishTime; 		// Minimum thread completion time
     float avgFinishTime; 	// Average thread completion time
     int totalCompletions; 	// Total number of exited threads
-    // TODO: Update the hardcoded size of array to reflect
-    // total number of scheduled threads.
-    int finishTimeArray[128];	// Array to store finish times
+    double sumSquaredFinishTime; // Sum of squared completion times, for
+				// their variance
     float a; 			// Estimation parameter in SJF
 
+    Histogram *cpuBursts;	// Distributions of non-zero CPU bursts,
+    Histogram *waitTimes;	// waits in the ready queue,
+    Histogram *finishTimes;	// thread completion times,
+    Histogram *diskLatencies;	// synchronous disk requests,
+    Histogram *syscallLatencies; // and system calls (to return to user)
+    List *processes;		// ProcessRecord of each exited process
+    int numProcesses;		// number of entries on "processes"
+
+    char *jsonFileName;		// where Export writes statistics as JSON
+    char *csvFileName;		// ... and as CSV; NULL if not wanted
+
     Statistics(); 		// initialize (nearly) everything to zero
     void trackCPUBurst(int);
     void trackWaitTime(int);
     void trackFinishTime(int);
+    void trackProcess(ProcessRecord *record);
     float evaluateVariance();
     void Print();		// print collected statistics
+    void Export();		// write them to jsonFileName and csvFileName
+    void Checkpoint(FILE *fp);	// save everything to a checkpoint
+    void Restore(FILE *fp);	// ... and load it back
 };
 
 // Constants used to reflect the relative time an operation would
@@ -34,6 +34,7 @@ extern "C" {
 #include <sys/socket.h>
 #include <sys/file.h>
 #include <sys/un.h>
+#include <sys/uio.h>
 #include <sys/mman.h>
 #ifdef HOST_i386
 #include <sys/time.h>
@@ -209,6 +210,43 @@ WriteFile(int fd, char *buffer, int nBytes)
     ASSERT(retVal == nBytes);
 }
 
+//----------------------------------------------------------------------
+// ReadVector/WriteVector
+// 	Read/write "numBuffers" buffers of "nBytes" each, from/to
+//	consecutive locations in an open file starting at "offset", with
+//	a single call.  Abort if the transfer is short.
+//----------------------------------------------------------------------
+
+#define MaxVector	64		// most buffers in one call
+
+void
+ReadVector(int fd, char **buffers, int numBuffers, int nBytes, int offset)
+{
+    struct iovec vector[MaxVector];
+
+    ASSERT(numBuffers <= MaxVector);
+    for (int i = 0; i < numBuffers; i++) {
+	vector[i].iov_base = buffers[i];
+	vector[i].iov_len = nBytes;
+    }
+    int retVal = preadv(fd, vector, numBuffers, offset);
+    ASSERT(retVal == numBuffers * nBytes);
+}
+
+void
+WriteVector(int fd, char **buffers, int numBuffers, int nBytes, int offset)
+{
+    struct iovec vector[MaxVector];
+
+    ASSERT(numBuffers <= MaxVector);
+    for (int i = 0; i < numBuffers; i++) {
+	vector[i].iov_base = buffers[i];
+	vector[i].iov_len = nBytes;
+    }
+    int retVal = pwritev(fd, vector, numBuffers, offset);
+    ASSERT(retVal == numBuffers * nBytes);
+}
+
 //----------------------------------------------------------------------
 // Lseek
 // 	Change the location within an open file.  Abort on error.
@@ -237,6 +275,47 @@ Tell(int fd)
 }
 
 
+//----------------------------------------------------------------------
+// MapFile
+// 	Map the first "nBytes" of an open file into memory, shared, so that
+//	stores into the mapping change the file.  Return the address of
+//	the mapping.  Abort on error.
+//----------------------------------------------------------------------
+
+char *
+MapFile(int fd, int nBytes)
+{
+    void *addr = mmap(NULL, nBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    ASSERT(addr != MAP_FAILED);
+    return (char *) addr;
+}
+
+//----------------------------------------------------------------------
+// SyncMappedFile
+// 	Write the changes made through a mapping out to the file, and
+//	wait until they are there.  Abort on error.
+//----------------------------------------------------------------------
+
+void
+SyncMappedFile(char *addr, int nBytes)
+{
+    int retVal = msync(addr, nBytes, MS_SYNC);
+    ASSERT(retVal == 0);
+}
+
+//----------------------------------------------------------------------
+// UnmapFile
+// 	Remove a mapping made by MapFile.  Abort on error.
+//----------------------------------------------------------------------
+
+void
+UnmapFile(char *addr, int nBytes)
+{
+    int retVal = munmap(addr, nBytes);
+    ASSERT(retVal == 0);
+}
+
 //----------------------------------------------------------------------
 // Close
 // 	Close a file.  Abort on error.
@@ -449,6 +528,8 @@ RandomInit(unsigned seed)
 int 
 Random()
 {
+    if (inputLog != NULL)		// recording or replaying inputs
+	return inputLog->Random();
     return rand();
 }
 
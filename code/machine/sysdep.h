@@ -25,7 +25,14 @@ extern void Read(int fd, char *buffer, int nBytes);
 extern int ReadPartial(int fd, char *buffer, int nBytes);
 extern void WriteFile(int fd, char *buffer, int nBytes);
 extern void Lseek(int fd, int offset, int whence);
+extern void ReadVector(int fd, char **buffers, int numBuffers, int nBytes,
+		       int offset);
+extern void WriteVector(int fd, char **buffers, int numBuffers, int nBytes,
+			int offset);
 extern int Tell(int fd);
+extern char *MapFile(int fd, int nBytes);
+extern void SyncMappedFile(char *addr, int nBytes);
+extern void UnmapFile(char *addr, int nBytes);
 extern void Close(int fd);
 extern bool Unlink(char *name);
 
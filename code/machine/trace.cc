@@ -0,0 +1,180 @@
+// trace.cc
+//	Routines to collect an instruction mix and an address trace of
+//	user programs.  See trace.h for the format of the trace.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "trace.h"
+#include "mipssim.h"
+#include "system.h"
+
+// Size in bytes of the data reference made by each load and store
+// opcode; 0 for all other opcodes.  The unaligned forms (LWL, LWR,
+// SWL, SWR) touch the word containing the effective address.
+
+static int loadSize[NumOpcodes];
+static int storeSize[NumOpcodes];
+static bool isBranch[NumOpcodes];	// conditional branches
+
+//----------------------------------------------------------------------
+// Tracer::Tracer
+// 	Initialize the counters, and open the address trace.
+//
+//	"traceFileName" -- where to write the address trace; NULL if only
+//		the instruction mix is wanted
+//----------------------------------------------------------------------
+
+Tracer::Tracer(char *traceFileName)
+{
+    ASSERT(MaxOpcode < NumOpcodes);
+    for (int i = 0; i < NumOpcodes; i++)
+	counts[i] = 0;
+    branchesTaken = branchesNotTaken = 0;
+    numLoads = numStores = 0;
+
+    loadSize[OP_LB] = loadSize[OP_LBU] = 1;
+    loadSize[OP_LH] = loadSize[OP_LHU] = 2;
+    loadSize[OP_LW] = loadSize[OP_LWL] = loadSize[OP_LWR] = 4;
+    storeSize[OP_SB] = 1;
+    storeSize[OP_SH] = 2;
+    storeSize[OP_SW] = storeSize[OP_SWL] = storeSize[OP_SWR] = 4;
+    isBranch[OP_BEQ] = isBranch[OP_BNE] = TRUE;
+    isBranch[OP_BGEZ] = isBranch[OP_BGEZAL] = isBranch[OP_BGTZ] = TRUE;
+    isBranch[OP_BLEZ] = isBranch[OP_BLTZ] = isBranch[OP_BLTZAL] = TRUE;
+
+    traceFile = NULL;
+    buffer = NULL;
+    for (int i = 0; i < TraceProcess; i++)
+	lastAddress[i] = 0;
+    lastPid = -1;
+    if (traceFileName != NULL) {
+	traceFile = fopen(traceFileName, "wb");
+	if (traceFile == NULL) {
+	    perror(traceFileName);
+	    return;
+	}
+	buffer = new char[TraceBufferSize];
+	setvbuf(traceFile, buffer, _IOFBF, TraceBufferSize);
+    }
+}
+
+//----------------------------------------------------------------------
+// Tracer::~Tracer
+// 	Flush and close the address trace.
+//----------------------------------------------------------------------
+
+Tracer::~Tracer()
+{
+    if (traceFile != NULL)
+	fclose(traceFile);
+    delete [] buffer;
+}
+
+//----------------------------------------------------------------------
+// Tracer::Record
+// 	Append a record to the address trace: a byte giving "kind" and
+//	"size", then "value" in LEB128 form.
+//----------------------------------------------------------------------
+
+void
+Tracer::Record(TraceKind kind, int size, int value)
+{
+    unsigned v = value;
+    int log2Size = (size == 4) ? 2 : size - 1;	// 1, 2 or 4 bytes
+
+    putc(kind | (log2Size << 2), traceFile);
+    while (v >= 0x80) {
+	putc((v & 0x7f) | 0x80, traceFile);
+	v >>= 7;
+    }
+    putc(v, traceFile);
+}
+
+// Zigzag encoding maps small differences of either sign to small
+// unsigned numbers: 0, -1, 1, -2, ... become 0, 1, 2, 3, ...
+
+#define ZigZag(delta)	(((delta) << 1) ^ ((delta) >> 31))
+
+//----------------------------------------------------------------------
+// Tracer::Executed
+// 	Called by Machine::OneInstruction when the instruction at "pc" of
+//	process "pid" has completed without trapping.  Count it, its
+//	branch outcome and its data reference, and trace its fetch and
+//	data reference.
+//
+//	"address" is the effective address (rs + immediate); it is only
+//		meaningful for loads and stores
+//	"jumped" is TRUE if the next PC is not the next instruction
+//----------------------------------------------------------------------
+
+void
+Tracer::Executed(int pid, int pc, int opCode, int address, bool jumped)
+{
+    counts[opCode]++;
+    if (traceFile != NULL) {
+	if (pid != lastPid) {
+	    Record(TraceProcess, 1, pid);
+	    lastPid = pid;
+	}
+	Record(TraceFetch, 4, ZigZag(pc - lastAddress[TraceFetch]));
+	lastAddress[TraceFetch] = pc;
+    }
+    if (isBranch[opCode]) {
+	if (jumped)
+	    branchesTaken++;
+	else
+	    branchesNotTaken++;
+    } else if (loadSize[opCode] != 0) {
+	numLoads++;
+	if (traceFile != NULL) {
+	    Record(TraceLoad, loadSize[opCode],
+		   ZigZag(address - lastAddress[TraceLoad]));
+	    lastAddress[TraceLoad] = address;
+	}
+    } else if (storeSize[opCode] != 0) {
+	numStores++;
+	if (traceFile != NULL) {
+	    Record(TraceStore, storeSize[opCode],
+		   ZigZag(address - lastAddress[TraceStore]));
+	    lastAddress[TraceStore] = address;
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// Tracer::Print
+// 	Print the instruction mix: executions per opcode, most frequent
+//	first, then branch and memory reference counts.
+//----------------------------------------------------------------------
+
+void
+Tracer::Print()
+{
+    int total = 0, best, i;
+    int left[NumOpcodes];
+    char *name;
+
+    for (i = 0; i < NumOpcodes; i++) {
+	total += counts[i];
+	left[i] = counts[i];
+    }
+    printf("\nInstruction mix: %d instructions\n", total);
+    for (;;) {				// selection sort, most first
+	best = 0;
+	for (i = 1; i < NumOpcodes; i++)
+	    if (left[i] > left[best])
+		best = i;
+	if (left[best] == 0)
+	    break;
+	name = opStrings[best].string;	// the mnemonic is the first word
+	printf("%-8.*s %10d  %6.2f%%\n", (int) strcspn(name, " "), name,
+	       left[best], 100.0 * left[best] / total);
+	left[best] = 0;
+    }
+    printf("Conditional branches: taken %d, not taken %d\n", branchesTaken,
+	   branchesNotTaken);
+    printf("Memory references: loads %d, stores %d\n", numLoads, numStores);
+}
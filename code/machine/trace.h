@@ -0,0 +1,72 @@
+// trace.h
+//	Data structures to collect an instruction mix and, optionally, a
+//	trace of the virtual addresses referenced by user programs.
+//
+//	When enabled ("-imix", or "-vatrace <file>"), Machine::OneInstruction
+//	tells the tracer about every instruction it executes, once the
+//	instruction has completed; one that traps is not counted (it is
+//	counted when it is restarted), except for system calls.  We count executions per opcode, taken and not taken
+//	conditional branches, and loads and stores.  When disabled, the
+//	global "tracer" is NULL and the simulator only pays for testing it.
+//
+//	The address trace is a stream of variable-length binary records,
+//	one per reference.  The first byte of a record is
+//
+//		bits 0-1: kind -- TraceFetch, TraceLoad, TraceStore,
+//			  or TraceProcess
+//		bits 2-3: log2 of the access size (fetches are 4 bytes)
+//
+//	followed by a number in LEB128 form (7 bits per byte, low bits
+//	first, high bit set on all but the last byte).  For references,
+//	the number is the zigzag-encoded difference from the previous
+//	address of the same kind; sequential fetches thus take two bytes.
+//	A TraceProcess record gives the pid of the process whose
+//	references follow, since each process has its own address space.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "copyright.h"
+#include <stdio.h>
+
+// Kinds of trace records
+enum TraceKind { TraceFetch, TraceLoad, TraceStore, TraceProcess };
+
+#define NumOpcodes	64		// as MaxOpcode + 1, in mipssim.h
+#define TraceBufferSize	(1 << 20)	// bytes buffered before a write
+
+// The following class defines the tracer.
+
+class Tracer {
+  public:
+    Tracer(char *traceFileName);	// start counting; also write an
+					// address trace, if not NULL
+    ~Tracer();				// flush and close the trace
+
+    void Executed(int pid, int pc, int opCode, int address, bool jumped);
+				// An instruction has completed; "address"
+				// is the effective address, if a load or
+				// store, "jumped" is TRUE if control was
+				// transferred
+    void Print();		// Print the instruction mix
+
+  private:
+    int counts[NumOpcodes];	// executions per opcode
+    int branchesTaken;		// conditional branches taken
+    int branchesNotTaken;	// ... and not taken
+    int numLoads, numStores;	// data references
+
+    FILE *traceFile;		// address trace, NULL if not wanted
+    char *buffer;		// its stdio buffer
+    int lastAddress[TraceProcess];	// previous address of each kind
+    int lastPid;		// process of the previous reference
+
+    void Record(TraceKind kind, int size, int value);
+				// append a record to the trace
+};
+
+#endif // TRACE_H
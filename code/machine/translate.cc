@@ -95,22 +95,22 @@ Machine::ReadMem(int addr, int size, int *value)
     
     exception = Translate(addr, &physicalAddress, size, FALSE);
     if (exception != NoException) {
-	machine->RaiseException(exception, addr);
+	RaiseException(exception, addr);
 	return FALSE;
     }
     switch (size) {
       case 1:
-	data = machine->mainMemory[physicalAddress];
+	data = mainMemory[physicalAddress];
 	*value = data;
 	break;
 	
       case 2:
-	data = *(unsigned short *) &machine->mainMemory[physicalAddress];
+	data = *(unsigned short *) &mainMemory[physicalAddress];
 	*value = ShortToHost(data);
 	break;
 	
       case 4:
-	data = *(unsigned int *) &machine->mainMemory[physicalAddress];
+	data = *(unsigned int *) &mainMemory[physicalAddress];
 	*value = WordToHost(data);
 	break;
 
@@ -144,21 +144,21 @@ Machine::WriteMem(int addr, int size, int value)
 
     exception = Translate(addr, &physicalAddress, size, TRUE);
     if (exception != NoException) {
-	machine->RaiseException(exception, addr);
+	RaiseException(exception, addr);
 	return FALSE;
     }
     switch (size) {
       case 1:
-	machine->mainMemory[physicalAddress] = (unsigned char) (value & 0xff);
+	mainMemory[physicalAddress] = (unsigned char) (value & 0xff);
 	break;
 
       case 2:
-	*(unsigned short *) &machine->mainMemory[physicalAddress]
+	*(unsigned short *) &mainMemory[physicalAddress]
 		= ShortToMachine((unsigned short) (value & 0xffff));
 	break;
       
       case 4:
-	*(unsigned int *) &machine->mainMemory[physicalAddress]
+	*(unsigned int *) &mainMemory[physicalAddress]
 		= WordToMachine((unsigned int) value);
 	break;
 	
@@ -254,6 +254,29 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
     return NoException;
 }
 
+//----------------------------------------------------------------------
+// Machine::CacheAccess
+// 	Called by OneInstruction after each instruction fetch, load and
+//	store of the user program, to simulate it in the caches (cf.
+//	cache.h).  System calls also read and write user memory, through
+//	ReadMem and WriteMem, but that is the kernel's doing, and is left
+//	out of the caches and of user time.
+//
+//	"virtAddr" -- the address accessed, which has just translated
+//	"fetch" -- TRUE for an instruction fetch, FALSE for data
+//----------------------------------------------------------------------
+
+void
+Machine::CacheAccess(int virtAddr, bool fetch)
+{
+    int physAddr;
+
+    if (caches == NULL)
+	return;
+    if (Translate(virtAddr, &physAddr, 1, FALSE) == NoException)
+	caches->Access(currentThread->GetPID(), physAddr, fetch);
+}
+
 //----------------------------------------------------------------------
 // Machine::GetPA
 //      Returns the physical address corresponding to the passed virtual
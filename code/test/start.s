@@ -218,6 +218,14 @@ syscall_wrapper_PrintIntHex:
 	j	$31
 	.end syscall_wrapper_PrintIntHex
 
+	.globl syscall_wrapper_SetRealTime
+	.ent    syscall_wrapper_SetRealTime
+syscall_wrapper_SetRealTime:
+	addiu $2,$0,SysCall_SetRealTime
+	syscall
+	j	$31
+	.end syscall_wrapper_SetRealTime
+
 /* dummy function to keep gcc happy */
         .globl  __main
         .ent    __main
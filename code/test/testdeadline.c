@@ -0,0 +1,35 @@
+#include "syscall.h"
+#define PERIOD 3000
+#define BUDGET 1000
+#define JOBS 5
+#define SIZE 100
+
+int
+main()
+{
+    int array[SIZE], i, k, sum = 0, x;
+    unsigned release, now;
+
+    x = syscall_wrapper_Fork();
+    if (syscall_wrapper_SetRealTime(PERIOD, BUDGET) != 0) {
+       syscall_wrapper_PrintString("Real-time reservation rejected.\n");
+       return 1;
+    }
+    release = syscall_wrapper_GetTime();
+    for (k=0; k<JOBS; k++) {
+       for (i=0; i<SIZE; i++) sum += array[i];
+       now = syscall_wrapper_GetTime();
+       syscall_wrapper_PrintString("*** thread ");
+       syscall_wrapper_PrintInt(syscall_wrapper_GetPID());
+       syscall_wrapper_PrintString(" job ");
+       syscall_wrapper_PrintInt(k);
+       syscall_wrapper_PrintString(" done after ");
+       syscall_wrapper_PrintInt(now-release);
+       syscall_wrapper_PrintString(" ticks.\n");
+       release += PERIOD;
+       now = syscall_wrapper_GetTime();
+       if (now < release) syscall_wrapper_Sleep(release-now);
+    }
+    if (x != 0) syscall_wrapper_Join(x);
+    return 0;
+}
@@ -0,0 +1,40 @@
+#include "syscall.h"
+#define PERIOD 1000
+#define BUDGET 500		/* utilization 0.5 */
+#define WINDOW 40000
+#define GAP 50			/* longer between two reads: preempted */
+
+int
+main()
+{
+    int x;
+    unsigned start, end, last, now, ran = 0;
+
+    start = syscall_wrapper_GetTime();
+    end = start + WINDOW;
+    x = syscall_wrapper_Fork();
+    if (x != 0) {
+       /* Real-time parent: spin, far beyond its budget. */
+       if (syscall_wrapper_SetRealTime(PERIOD, BUDGET) != 0) {
+          syscall_wrapper_PrintString("Real-time reservation rejected.\n");
+          return 1;
+       }
+       while (syscall_wrapper_GetTime() < end) ;
+       syscall_wrapper_Join(x);
+       return 0;
+    }
+
+    /* Ordinary child: count the ticks it gets until the end. */
+    last = syscall_wrapper_GetTime();
+    while (last < end) {
+       now = syscall_wrapper_GetTime();
+       if (now - last < GAP) ran += now - last;
+       last = now;
+    }
+    syscall_wrapper_PrintString("*** ordinary thread got ");
+    syscall_wrapper_PrintInt((ran * 100) / (last - start));
+    syscall_wrapper_PrintString("% of the CPU, expected about ");
+    syscall_wrapper_PrintInt(100 - (BUDGET * 100) / PERIOD);
+    syscall_wrapper_PrintString("%.\n");
+    return 0;
+}
@@ -236,3 +236,58 @@ List::SortedRemove(int *keyPtr)
     return thing;
 }
 
+
+//----------------------------------------------------------------------
+// List::Front
+//      Look at the first "item" of the list, without removing it.
+//
+// Returns:
+//	Pointer to the first item, NULL if nothing on the list.
+//	Sets *keyPtr to its priority value, if keyPtr is not NULL.
+//----------------------------------------------------------------------
+
+void *
+List::Front(int *keyPtr)
+{
+    if (IsEmpty())
+	return NULL;
+    if (keyPtr != NULL)
+	*keyPtr = first->key;
+    return first->item;
+}
+
+//----------------------------------------------------------------------
+// List::RemoveLast
+//      Remove the last "item" from the list.  Takes time proportional
+//	to the length of the list, since the list is singly linked.
+//
+// Returns:
+//	Pointer to the removed item, NULL if nothing on the list.
+//	Sets *keyPtr to its priority value, if keyPtr is not NULL.
+//----------------------------------------------------------------------
+
+void *
+List::RemoveLast(int *keyPtr)
+{
+    ListElement *element = last;
+    ListElement *prev;
+    void *thing;
+
+    if (IsEmpty())
+	return NULL;
+
+    if (first == last) {	// list had one item, now has none
+        first = NULL;
+	last = NULL;
+    } else {
+	for (prev = first; prev->next != last; prev = prev->next)
+	    ;
+	prev->next = NULL;
+	last = prev;
+    }
+    thing = element->item;
+    if (keyPtr != NULL)
+	*keyPtr = element->key;
+    delete element;
+    return thing;
+}
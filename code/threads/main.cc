@@ -9,27 +9,73 @@
 // 	Most of this file is not needed until later assignments.
 //
 // Usage: nachos -d <debugflags> -rs <random seed #>
-//		-s -x <nachos file> -c <consoleIn> <consoleOut>
-//		-f -cp <unix file> <nachos file>
-//		-p <nachos file> -r <nachos file> -l -D -t
+//		-aq <overhead|response> <goal> -bp <ewma|median|linear>
+//		-json <file> -csv <file> -record <file> -replay <file>
+//		-s -ncpu <#> -nosteal -P <ticks> -prof <ticks>
+//		-imix -vatrace <file> -l1i <size> <ways> <line> <penalty>
+//		-l1d <size> <ways> <line> <penalty>
+//		-l2 <size> <ways> <line> <penalty> -ckpt <tick> <file>
+//		-restore <file> -x <nachos file>
+//		-c <consoleIn> <consoleOut>
+//		-f -bc <buffers> <flush ticks> -ds <fcfs|sstf|scan|clook> -dm
+//		-cp <unix file> <nachos file>
+//		-p <nachos file> -r <nachos file> -md <nachos dir> -l -D -t
 //              -n <network reliability> -m <machine id>
 //              -o <other machine id>
 //              -z
 //
 //    -d causes certain debugging messages to be printed (cf. utility.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
+//    -aq adapts the round-robin quantum at run time, aiming for the given
+//	  fraction of kernel overhead, or mean ready-queue wait in ticks
+//    -bp selects how the shortest-next-burst scheduler predicts bursts
+//    -json, -csv write the statistics, with full distributions and a
+//	  per-process breakdown, to the given file when Nachos halts
+//    -record logs console input, network packets and random numbers,
+//	  with the tick each was taken, to the given file
+//    -replay takes those inputs from a log written by -record, rather
+//	  than from the host, repeating the recorded run exactly
 //    -z prints the copyright message
 //
 //  USER_PROGRAM
 //    -s causes user programs to be executed in single-step mode
+//    -ncpu simulates a multiprocessor with the given number of CPUs
+//    -nosteal keeps idle CPUs from stealing work; only the periodic
+//	  load balancer then moves threads between CPUs
+//    -P runs the user programs of different CPUs on parallel host
+//	  threads, in epochs of the given number of ticks
+//    -prof samples the PC of user programs at most once every given number
+//	  of ticks, and writes a profile of each process when it exits
+//    -imix counts user instructions by opcode, branch outcomes and memory
+//	  references
+//    -vatrace also writes a compressed trace of user virtual addresses
+//	  to the given file (see machine/trace.h)
+//    -l1i, -l1d, -l2 simulate an instruction, data or second-level cache
+//	  of the given size, associativity and line size in bytes, and
+//	  miss penalty in ticks
+//    -ckpt writes a checkpoint of the simulation to the given file at
+//	  the given tick, or as soon after as possible (see
+//	  userprog/checkpoint.h)
+//    -restore continues the simulation saved in a checkpoint
 //    -x runs a user program
 //    -c tests the console
 //
 //  FILESYS
 //    -f causes the physical disk to be formatted
+//    -bc sets the number of disk sectors kept in the buffer cache (0 for
+//	  none), and the ticks between write-backs of the dirty ones (0
+//	  to write them back only when evicted, or when Nachos halts)
+//    -ds sets the order in which queued disk requests are served: in
+//	  order of arrival, nearest track first, elevator, or one-way
+//	  elevator (the default)
+//    -dm maps the UNIX file holding the disk into memory, so that
+//	  sectors are copied rather than read and written with system
+//	  calls; it is synced when the buffer cache flushes, and at halt
 //    -cp copies a file from UNIX to Nachos
 //    -p prints a Nachos file to stdout
-//    -r removes a Nachos file from the file system
+//    -r removes a Nachos file, or empty directory, from the file system
+//    -md makes a Nachos directory; Nachos files are named by paths
+//	  from the root directory, such as "dir/file"
 //    -l lists the contents of the Nachos directory
 //    -D prints the contents of the entire file system
 //    -t tests the performance of the Nachos file system
@@ -108,7 +154,11 @@ main(int argc, char **argv)
 	    ASSERT(argc > 1);
             LaunchUserProcess(*(argv + 1));
             argCount = 2;
-        } else if (!strcmp(*argv, "-c")) {      // test the console
+        } else if (!strcmp(*argv, "-restore")) {	// continue a checkpoint
+	    ASSERT(argc > 1);
+	    RestoreCheckpoint(*(argv + 1));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-c")) {      // test the console
 	    if (argc == 1)
 	        ConsoleTest(NULL, NULL);
 	    else {
@@ -129,7 +179,7 @@ main(int argc, char **argv)
 
 	    if (read = getline(&line, &len, fp) != -1) {
 		sched_algo_number = (int)atoi(line);
-		if (sched_algo_number < 1 || sched_algo_number > 10) {
+		if (sched_algo_number < 1 || sched_algo_number > 11) {
 		    fprintf(stderr, "Bad scheduling algorithm number\n");
 		    return 1;
 		}
@@ -188,6 +238,10 @@ main(int argc, char **argv)
 		case 10:
 		    stats->timerInterruptTicks = 20;
 		    break;
+		case 11:
+		    // Minimum granularity of the fair scheduler.
+		    stats->timerInterruptTicks = 20;
+		    break;
 		default:
 		    break;
 	    }
@@ -210,6 +264,10 @@ main(int argc, char **argv)
 	    ASSERT(argc > 1);
 	    fileSystem->Remove(*(argv + 1));
 	    argCount = 2;
+	} else if (!strcmp(*argv, "-md")) {	// make Nachos directory
+	    ASSERT(argc > 1);
+	    fileSystem->MakeDirectory(*(argv + 1));
+	    argCount = 2;
 	} else if (!strcmp(*argv, "-l")) {	// list Nachos directory
             fileSystem->List();
 	} else if (!strcmp(*argv, "-D")) {	// print entire filesystem
@@ -0,0 +1,158 @@
+// predictor.cc
+//	Routines to predict the next CPU burst of a thread.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "predictor.h"
+#include "system.h"
+
+#define TrackingWeight	0.2	// weight of the newest error when smoothing
+				// errors to adapt the EWMA parameter
+#define MinAlpha	0.05	// keep the EWMA from freezing...
+#define MaxAlpha	0.95	// ... or from just repeating the last burst
+
+//----------------------------------------------------------------------
+// BurstPredictor::BurstPredictor
+// 	Initialize a predictor with no history.
+//
+//	"kindOfPredictor" is the prediction method to use.
+//	"initialGuess" is predicted until the first burst has been seen.
+//----------------------------------------------------------------------
+
+BurstPredictor::BurstPredictor(PredictorKind kindOfPredictor, int initialGuess)
+{
+    kind = kindOfPredictor;
+    prediction = initialGuess;
+    numSamples = nextSlot = 0;
+    alpha = stats->a;
+    smoothedError = smoothedAbsError = 0;
+    errors = new Histogram;
+}
+
+//----------------------------------------------------------------------
+// BurstPredictor::~BurstPredictor
+// 	De-allocate the error histogram.
+//----------------------------------------------------------------------
+
+BurstPredictor::~BurstPredictor()
+{
+    delete errors;
+}
+
+//----------------------------------------------------------------------
+// BurstPredictor::Update
+// 	Record the error of the current prediction, remember the burst,
+//	and compute the prediction for the next one.
+//
+//	"actualBurst" is the length of the CPU burst that just ended.
+//----------------------------------------------------------------------
+
+void
+BurstPredictor::Update(int actualBurst)
+{
+    int error = actualBurst - prediction;
+
+    errors->Record(abs(error));
+
+    history[nextSlot] = actualBurst;
+    nextSlot = (nextSlot + 1) % PredictorWindow;
+    if (numSamples < PredictorWindow)
+	numSamples++;
+
+    switch (kind) {
+      case EWMAPredictor:
+	// Adapt alpha: if the errors keep the same sign, the average is
+	// lagging behind the bursts and should react faster; if they
+	// cancel out, the bursts are noisy and should be smoothed more.
+	smoothedError = TrackingWeight * error
+		      + (1 - TrackingWeight) * smoothedError;
+	smoothedAbsError = TrackingWeight * abs(error)
+			 + (1 - TrackingWeight) * smoothedAbsError;
+	if (smoothedAbsError > 0) {
+	    alpha = smoothedError / smoothedAbsError;
+	    if (alpha < 0)
+		alpha = -alpha;
+	    if (alpha < MinAlpha)
+		alpha = MinAlpha;
+	    if (alpha > MaxAlpha)
+		alpha = MaxAlpha;
+	}
+	prediction = (int)(alpha * actualBurst + (1 - alpha) * prediction);
+	break;
+      case MedianPredictor:
+	prediction = Median();
+	break;
+      case LinearPredictor:
+	prediction = LinearFit();
+	break;
+    }
+}
+
+//----------------------------------------------------------------------
+// BurstPredictor::Median
+// 	Return the median of the remembered bursts (the lower median
+//	if there is an even number of them).
+//----------------------------------------------------------------------
+
+int
+BurstPredictor::Median()
+{
+    int sorted[PredictorWindow];
+    int i, j, value;
+
+    for (i = 0; i < numSamples; i++) {		// insertion sort
+	value = history[i];
+	for (j = i; j > 0 && sorted[j - 1] > value; j--)
+	    sorted[j] = sorted[j - 1];
+	sorted[j] = value;
+    }
+    return sorted[(numSamples - 1) / 2];
+}
+
+//----------------------------------------------------------------------
+// BurstPredictor::LinearFit
+// 	Fit a least-squares line through the remembered bursts, oldest
+//	first, and return its value one step past the newest burst.
+//	Falls back to the newest burst until there are two points.
+//----------------------------------------------------------------------
+
+int
+BurstPredictor::LinearFit()
+{
+    int oldest = (nextSlot - numSamples + PredictorWindow) % PredictorWindow;
+    float sumX = 0, sumY = 0, sumXY = 0, sumXX = 0;
+    float n = numSamples, slope, intercept, next;
+    int x, y;
+
+    if (numSamples < 2)
+	return history[oldest];
+
+    for (x = 0; x < numSamples; x++) {
+	y = history[(oldest + x) % PredictorWindow];
+	sumX += x;
+	sumY += y;
+	sumXY += x * y;
+	sumXX += x * x;
+    }
+    slope = (n * sumXY - sumX * sumY) / (n * sumXX - sumX * sumX);
+    intercept = (sumY - slope * sumX) / n;
+    next = intercept + slope * n;
+    return (next > 0) ? (int)next : 0;
+}
+
+//----------------------------------------------------------------------
+// BurstPredictor::PrintErrors
+// 	Print the histogram of absolute prediction errors of thread "pid".
+//----------------------------------------------------------------------
+
+void
+BurstPredictor::PrintErrors(int pid)
+{
+    char title[64];
+
+    sprintf(title, "[pid %d] CPU burst prediction error", pid);
+    errors->Print(title);
+}
@@ -0,0 +1,61 @@
+// predictor.h
+//	Data structures for predicting the next CPU burst of a thread,
+//	as needed by the shortest-next-burst-first scheduler.
+//
+//	Each thread has its own predictor, holding its recent burst
+//	history, so that the prediction (and its accuracy) depends only
+//	on the thread's own behaviour.  The kind of predictor is chosen
+//	on the command line ("-bp"):
+//
+//	  ewma   -- exponentially weighted moving average, with a smoothing
+//		    parameter per thread that adapts to how well the
+//		    average tracks the bursts (Trigg-Leach)
+//	  median -- median of the last PredictorWindow bursts; not thrown
+//		    off by the occasional long burst
+//	  linear -- least-squares line through the last PredictorWindow
+//		    bursts, extrapolated one step; follows trends
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PREDICTOR_H
+#define PREDICTOR_H
+
+#include "copyright.h"
+#include "stats.h"
+
+enum PredictorKind { EWMAPredictor, MedianPredictor, LinearPredictor };
+
+#define PredictorWindow 8	// bursts remembered by median/linear
+
+// The following class defines the per-thread predictor.
+
+class BurstPredictor {
+  public:
+    BurstPredictor(PredictorKind kind, int initialGuess);
+    ~BurstPredictor();
+
+    int Predict() { return prediction; }	// expected next burst
+    void Update(int actualBurst);	// learn from a finished burst
+    void PrintErrors(int pid);		// print the error histogram
+
+  private:
+    PredictorKind kind;
+    int prediction;		// current guess for the next burst
+
+    int history[PredictorWindow];	// circular buffer of recent bursts
+    int numSamples;		// valid entries in history
+    int nextSlot;		// where the next burst goes in history
+
+    float alpha;		// EWMA weight of the newest burst
+    float smoothedError;	// EWMA of signed errors (Trigg-Leach)
+    float smoothedAbsError;	// EWMA of absolute errors
+
+    Histogram *errors;		// absolute prediction errors
+
+    int Median();
+    int LinearFit();
+};
+
+#endif // PREDICTOR_H
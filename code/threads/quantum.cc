@@ -0,0 +1,125 @@
+// quantum.cc
+//	Routines for the adaptive time-quantum controller.
+//
+//	Every RetuneInterval ticks, the controller compares the observed
+//	value of its target metric over the last window with the goal, and
+//	scales the quantum by goal/observed (for overhead, observed/goal),
+//	limited to a factor of two per step to avoid oscillation:
+//
+//	  - kernel overhead goes down when the quantum grows, since fewer
+//	    preemptions mean fewer context switches;
+//	  - time spent waiting in the ready queue goes down when the
+//	    quantum shrinks, since each ready thread waits for at most
+//	    one quantum per thread ahead of it.
+//
+//	A quantum much longer than the typical CPU burst no longer saves
+//	any switches (threads block before it expires), so the quantum is
+//	also capped at twice the mean burst of the window.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "quantum.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// QuantumController::QuantumController
+// 	Initialize the controller.
+//
+//	"kind" selects the metric the controller aims for.
+//	"goalValue" is the target value of that metric: a fraction in
+//		(0,1) for SwitchOverheadTarget, a number of ticks for
+//		ResponseTimeTarget.
+//----------------------------------------------------------------------
+
+QuantumController::QuantumController(QuantumTarget kind, float goalValue)
+{
+    ASSERT(goalValue > 0);
+    ASSERT(kind != SwitchOverheadTarget || goalValue < 1);
+
+    target = kind;
+    goal = goalValue;
+    nextRetune = stats->totalTicks + RetuneInterval;
+    TakeSnapshot();
+}
+
+//----------------------------------------------------------------------
+// QuantumController::TakeSnapshot
+// 	Remember the cumulative counters, marking the start of a window.
+//----------------------------------------------------------------------
+
+void
+QuantumController::TakeSnapshot()
+{
+    lastSystemTicks = stats->systemTicks;
+    lastUserTicks = stats->userTicks;
+    lastBursts = stats->totalCPUBursts;
+    lastBurstSum = stats->avgCPUBurst * stats->totalCPUBursts;
+    lastWaits = stats->totalWaits;
+    lastWaitSum = stats->totalWaitTime;
+}
+
+//----------------------------------------------------------------------
+// QuantumController::Retune
+// 	Called from the timer interrupt handler, with interrupts disabled.
+//	If the current window is over, compute the new quantum and store
+//	it in stats->timerInterruptTicks, which both the timer (to pick
+//	its next interrupt) and the timer handler (to decide whether to
+//	preempt) use from then on.
+//
+//	Windows in which no CPU burst ended carry no information; they
+//	are merged into the next one.
+//----------------------------------------------------------------------
+
+void
+QuantumController::Retune()
+{
+    int bursts, busy, waits;
+    float meanBurst, observed, ratio, quantum;
+
+    if (stats->totalTicks < nextRetune)
+	return;
+    nextRetune = stats->totalTicks + RetuneInterval;
+
+    // Non-preemptive algorithms ignore the quantum.
+    if (scheduler->schedAlgo <= NPtvShortestNextBurst)
+	return;
+
+    bursts = stats->totalCPUBursts - lastBursts;
+    if (bursts == 0)
+	return;
+    meanBurst = (stats->avgCPUBurst * stats->totalCPUBursts - lastBurstSum) / bursts;
+
+    if (target == SwitchOverheadTarget) {
+	busy = (stats->systemTicks - lastSystemTicks)
+	     + (stats->userTicks - lastUserTicks);
+	observed = (busy > 0) ? (stats->systemTicks - lastSystemTicks) * 1.0 / busy : 0;
+	ratio = observed / goal;
+    } else {
+	waits = stats->totalWaits - lastWaits;
+	observed = (waits > 0) ? (stats->totalWaitTime - lastWaitSum) * 1.0 / waits : 0;
+	ratio = (observed > 0) ? goal / observed : 2;
+    }
+    if (ratio < 0.5)
+	ratio = 0.5;
+    if (ratio > 2)
+	ratio = 2;
+
+    quantum = stats->timerInterruptTicks * ratio;
+    if (quantum > 2 * meanBurst)
+	quantum = 2 * meanBurst;
+    if (quantum < MinQuantum)
+	quantum = MinQuantum;
+    if (quantum > MaxQuantum)
+	quantum = MaxQuantum;
+
+    DEBUG('t', "Quantum retune at %d: mean burst %.1f, observed %.3f, quantum %d -> %d\n",
+	  stats->totalTicks, meanBurst, observed, stats->timerInterruptTicks,
+	  (int)quantum);
+
+    stats->timerInterruptTicks = (int)quantum;
+    stats->numQuantumRetunes++;
+    TakeSnapshot();
+}
@@ -0,0 +1,55 @@
+// quantum.h
+//	Data structures for the adaptive time-quantum controller.
+//
+//	The round-robin (and priority) scheduling algorithms use a fixed
+//	quantum chosen by the batch file's algorithm number.  When the
+//	controller is enabled ("-aq"), it periodically looks at how the
+//	last window of execution went -- kernel overhead, CPU bursts,
+//	ready-queue waiting time -- and retunes stats->timerInterruptTicks
+//	(which the timer uses as its period) towards a target.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef QUANTUM_H
+#define QUANTUM_H
+
+#include "copyright.h"
+
+// What the controller is aiming for.
+enum QuantumTarget {
+    SwitchOverheadTarget,	// fraction of busy time spent in the kernel
+    ResponseTimeTarget		// mean ticks spent waiting in the ready queue
+};
+
+#define MinQuantum	(2 * SystemTick)	// never retune below this
+#define MaxQuantum	(10 * TimerTicks)	// ... or above this
+#define RetuneInterval	(10 * TimerTicks)	// ticks between two retunes
+
+// The following class defines the controller.  It is called from the
+// timer interrupt handler, and keeps a snapshot of the cumulative
+// counters in "stats" so that each decision is based only on what
+// happened since the previous one.
+
+class QuantumController {
+  public:
+    QuantumController(QuantumTarget kind, float goal);
+    void Retune();		// Called on every timer interrupt; adjusts
+				// the quantum once per RetuneInterval
+
+  private:
+    QuantumTarget target;	// what "goal" measures
+    float goal;			// overhead fraction, or response ticks
+    int nextRetune;		// when the current window ends
+
+    // Snapshot of the counters at the start of the current window.
+    int lastSystemTicks, lastUserTicks;
+    int lastBursts;
+    float lastBurstSum;
+    int lastWaits, lastWaitSum;
+
+    void TakeSnapshot();
+};
+
+#endif // QUANTUM_H
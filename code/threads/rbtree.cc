@@ -0,0 +1,446 @@
+// rbtree.cc
+//
+//     	Routines to manage a red-black tree of "things".
+//
+// 	A red-black tree is a binary search tree in which every node
+//	is coloured red or black, such that no red node has a red
+//	child, and every path from the root to a leaf passes through
+//	the same number of black nodes.  Together these keep the
+//	height of the tree below 2*log(n+1).
+//
+//     	NOTE: Mutual exclusion must be provided by the caller.
+//  	If you want a synchronized tree, you must use the routines
+//	in synch.cc.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "rbtree.h"
+
+// A missing (NULL) child counts as a black leaf.
+#define IsRed(node)	((node) != NULL && (node)->red)
+#define IsBlack(node)	((node) == NULL || !(node)->red)
+
+//----------------------------------------------------------------------
+// RedBlackNode::RedBlackNode
+// 	Initialize a tree node, so it can be added somewhere in the tree.
+//	New nodes are always red; InsertFixup repairs the colouring.
+//
+//	"itemPtr" is the item to be put in the tree.
+//	"sortKey" is the key of the item.
+//----------------------------------------------------------------------
+
+RedBlackNode::RedBlackNode(void *itemPtr, int sortKey)
+{
+     item = itemPtr;
+     key = sortKey;
+     left = right = parent = NULL;
+     red = TRUE;
+}
+
+//----------------------------------------------------------------------
+// RedBlackTree::RedBlackTree
+//	Initialize a tree, empty to start with.
+//----------------------------------------------------------------------
+
+RedBlackTree::RedBlackTree()
+{
+    root = NULL;
+    numItems = 0;
+}
+
+//----------------------------------------------------------------------
+// RedBlackTree::~RedBlackTree
+//	Prepare a tree for deallocation.  If the tree still contains any
+//	nodes, de-allocate them.  However, note that we do *not*
+//	de-allocate the "items" in the tree -- this module allocates
+//	and de-allocates the RedBlackNodes to keep track of each item,
+//	but a given item may be on multiple trees, so we can't
+//	de-allocate them here.
+//----------------------------------------------------------------------
+
+RedBlackTree::~RedBlackTree()
+{
+    while (RemoveMin(NULL) != NULL)
+	;	 // delete all the tree nodes
+}
+
+//----------------------------------------------------------------------
+// RedBlackTree::RotateLeft
+//	Make the right child of "node" take its place, with "node"
+//	becoming its left child.  The in-order sequence is unchanged.
+//----------------------------------------------------------------------
+
+void
+RedBlackTree::RotateLeft(RedBlackNode *node)
+{
+    RedBlackNode *child = node->right;
+
+    node->right = child->left;
+    if (child->left != NULL)
+	child->left->parent = node;
+    Transplant(node, child);
+    child->left = node;
+    node->parent = child;
+}
+
+//----------------------------------------------------------------------
+// RedBlackTree::RotateRight
+//	Mirror image of RotateLeft.
+//----------------------------------------------------------------------
+
+void
+RedBlackTree::RotateRight(RedBlackNode *node)
+{
+    RedBlackNode *child = node->left;
+
+    node->left = child->right;
+    if (child->right != NULL)
+	child->right->parent = node;
+    Transplant(node, child);
+    child->right = node;
+    node->parent = child;
+}
+
+//----------------------------------------------------------------------
+// RedBlackTree::Transplant
+//	Put "newNode" (which may be NULL) in the position of the tree
+//	currently held by "oldNode".  The children of either node are
+//	not touched.
+//----------------------------------------------------------------------
+
+void
+RedBlackTree::Transplant(RedBlackNode *oldNode, RedBlackNode *newNode)
+{
+    if (oldNode->parent == NULL)
+	root = newNode;
+    else if (oldNode == oldNode->parent->left)
+	oldNode->parent->left = newNode;
+    else
+	oldNode->parent->right = newNode;
+    if (newNode != NULL)
+	newNode->parent = oldNode->parent;
+}
+
+//----------------------------------------------------------------------
+// RedBlackTree::Insert
+//      Insert an "item" into the tree, so that an in-order walk
+//	visits items in increasing order by "sortKey".  An item whose
+//	key equals that of items already in the tree is placed after
+//	them.
+//
+//	"item" is the thing to put in the tree, it can be a pointer to
+//		anything.
+//	"sortKey" is the priority of the item.
+//----------------------------------------------------------------------
+
+void
+RedBlackTree::Insert(void *item, int sortKey)
+{
+    RedBlackNode *node = new RedBlackNode(item, sortKey);
+    RedBlackNode *parentNode = NULL;
+    RedBlackNode *ptr = root;
+
+    while (ptr != NULL) {
+	parentNode = ptr;
+	if (sortKey < ptr->key)
+	    ptr = ptr->left;
+	else
+	    ptr = ptr->right;
+    }
+    node->parent = parentNode;
+    if (parentNode == NULL)
+	root = node;
+    else if (sortKey < parentNode->key)
+	parentNode->left = node;
+    else
+	parentNode->right = node;
+
+    numItems++;
+    InsertFixup(node);
+}
+
+//----------------------------------------------------------------------
+// RedBlackTree::InsertFixup
+//	Restore the red-black properties after "node" (red) has been
+//	linked in as a leaf.  The only property that can be violated is
+//	that of a red node with a red parent; push the violation up the
+//	tree by recolouring, and finish off with at most two rotations.
+//----------------------------------------------------------------------
+
+void
+RedBlackTree::InsertFixup(RedBlackNode *node)
+{
+    RedBlackNode *uncle, *grandParent;
+
+    while (IsRed(node->parent)) {
+	grandParent = node->parent->parent;	// exists, root is black
+	if (node->parent == grandParent->left) {
+	    uncle = grandParent->right;
+	    if (IsRed(uncle)) {
+		node->parent->red = FALSE;
+		uncle->red = FALSE;
+		grandParent->red = TRUE;
+		node = grandParent;
+	    } else {
+		if (node == node->parent->right) {
+		    node = node->parent;
+		    RotateLeft(node);
+		}
+		node->parent->red = FALSE;
+		grandParent->red = TRUE;
+		RotateRight(grandParent);
+	    }
+	} else {
+	    uncle = grandParent->left;
+	    if (IsRed(uncle)) {
+		node->parent->red = FALSE;
+		uncle->red = FALSE;
+		grandParent->red = TRUE;
+		node = grandParent;
+	    } else {
+		if (node == node->parent->left) {
+		    node = node->parent;
+		    RotateRight(node);
+		}
+		node->parent->red = FALSE;
+		grandParent->red = TRUE;
+		RotateLeft(grandParent);
+	    }
+	}
+    }
+    root->red = FALSE;
+}
+
+//----------------------------------------------------------------------
+// RedBlackTree::DeleteNode
+//	Unlink "node" from the tree (but do not de-allocate it).
+//	If the node has two children, its in-order successor takes its
+//	place.  If a black node was removed from some path, DeleteFixup
+//	restores the black height starting from the spliced-in child.
+//----------------------------------------------------------------------
+
+void
+RedBlackTree::DeleteNode(RedBlackNode *node)
+{
+    RedBlackNode *successor, *child, *childParent;
+    bool removedRed = node->red;
+
+    if (node->left == NULL) {
+	child = node->right;
+	childParent = node->parent;
+	Transplant(node, node->right);
+    } else if (node->right == NULL) {
+	child = node->left;
+	childParent = node->parent;
+	Transplant(node, node->left);
+    } else {
+	successor = node->right;
+	while (successor->left != NULL)
+	    successor = successor->left;
+	removedRed = successor->red;
+	child = successor->right;
+	if (successor->parent == node) {
+	    childParent = successor;
+	} else {
+	    childParent = successor->parent;
+	    Transplant(successor, successor->right);
+	    successor->right = node->right;
+	    successor->right->parent = successor;
+	}
+	Transplant(node, successor);
+	successor->left = node->left;
+	successor->left->parent = successor;
+	successor->red = node->red;
+    }
+
+    numItems--;
+    if (!removedRed)
+	DeleteFixup(child, childParent);
+}
+
+//----------------------------------------------------------------------
+// RedBlackTree::DeleteFixup
+//	"node" (possibly NULL) carries an extra black after a deletion;
+//	"parentNode" is its parent, needed because a NULL node cannot
+//	tell us where it is.  Move the extra black up the tree until it
+//	can be absorbed by a red node, or rotated away.
+//----------------------------------------------------------------------
+
+void
+RedBlackTree::DeleteFixup(RedBlackNode *node, RedBlackNode *parentNode)
+{
+    RedBlackNode *sibling;
+
+    while (node != root && IsBlack(node)) {
+	if (node == parentNode->left) {
+	    sibling = parentNode->right;
+	    if (IsRed(sibling)) {
+		sibling->red = FALSE;
+		parentNode->red = TRUE;
+		RotateLeft(parentNode);
+		sibling = parentNode->right;
+	    }
+	    if (IsBlack(sibling->left) && IsBlack(sibling->right)) {
+		sibling->red = TRUE;
+		node = parentNode;
+		parentNode = node->parent;
+	    } else {
+		if (IsBlack(sibling->right)) {
+		    sibling->left->red = FALSE;
+		    sibling->red = TRUE;
+		    RotateRight(sibling);
+		    sibling = parentNode->right;
+		}
+		sibling->red = parentNode->red;
+		parentNode->red = FALSE;
+		sibling->right->red = FALSE;
+		RotateLeft(parentNode);
+		node = root;
+	    }
+	} else {
+	    sibling = parentNode->left;
+	    if (IsRed(sibling)) {
+		sibling->red = FALSE;
+		parentNode->red = TRUE;
+		RotateRight(parentNode);
+		sibling = parentNode->left;
+	    }
+	    if (IsBlack(sibling->left) && IsBlack(sibling->right)) {
+		sibling->red = TRUE;
+		node = parentNode;
+		parentNode = node->parent;
+	    } else {
+		if (IsBlack(sibling->left)) {
+		    sibling->right->red = FALSE;
+		    sibling->red = TRUE;
+		    RotateLeft(sibling);
+		    sibling = parentNode->left;
+		}
+		sibling->red = parentNode->red;
+		parentNode->red = FALSE;
+		sibling->left->red = FALSE;
+		RotateRight(parentNode);
+		node = root;
+	    }
+	}
+    }
+    if (node != NULL)
+	node->red = FALSE;
+}
+
+//----------------------------------------------------------------------
+// RedBlackTree::RemoveNode
+//	Unlink and de-allocate "node", returning its item and, if
+//	"keyPtr" is not NULL, storing its key there.
+//----------------------------------------------------------------------
+
+void *
+RedBlackTree::RemoveNode(RedBlackNode *node, int *keyPtr)
+{
+    void *thing = node->item;
+
+    if (keyPtr != NULL)
+	*keyPtr = node->key;
+    DeleteNode(node);
+    delete node;
+    return thing;
+}
+
+//----------------------------------------------------------------------
+// RedBlackTree::RemoveMin
+//      Remove the item with the smallest key from the tree.  Among
+//	items with equal keys, the one inserted first is removed.
+//
+// Returns:
+//	Pointer to removed item, NULL if nothing is in the tree.
+//	Sets *keyPtr to the key of the removed item, if keyPtr
+//	is not NULL.
+//----------------------------------------------------------------------
+
+void *
+RedBlackTree::RemoveMin(int *keyPtr)
+{
+    RedBlackNode *node = root;
+
+    if (node == NULL)
+	return NULL;
+    while (node->left != NULL)
+	node = node->left;
+    return RemoveNode(node, keyPtr);
+}
+
+//----------------------------------------------------------------------
+// RedBlackTree::RemoveMax
+//      Remove the item with the largest key from the tree.  Among
+//	items with equal keys, the one inserted last is removed.
+//
+// Returns:
+//	Pointer to removed item, NULL if nothing is in the tree.
+//----------------------------------------------------------------------
+
+void *
+RedBlackTree::RemoveMax(int *keyPtr)
+{
+    RedBlackNode *node = root;
+
+    if (node == NULL)
+	return NULL;
+    while (node->right != NULL)
+	node = node->right;
+    return RemoveNode(node, keyPtr);
+}
+
+//----------------------------------------------------------------------
+// RedBlackTree::MinKey
+//	Store the smallest key in the tree in *keyPtr, without removing
+//	anything.  Returns FALSE (and leaves *keyPtr alone) if the tree
+//	is empty.
+//----------------------------------------------------------------------
+
+bool
+RedBlackTree::MinKey(int *keyPtr)
+{
+    RedBlackNode *node = root;
+
+    if (node == NULL)
+	return FALSE;
+    while (node->left != NULL)
+	node = node->left;
+    *keyPtr = node->key;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// RedBlackTree::Mapcar
+//	Apply a function to each item in the tree, in increasing order
+//	of key.  The walk follows parent pointers, so it needs no
+//	recursion (thread stacks are small).
+//
+//	"func" is the procedure to apply to each item in the tree.
+//----------------------------------------------------------------------
+
+void
+RedBlackTree::Mapcar(VoidFunctionPtr func)
+{
+    RedBlackNode *node = root;
+
+    if (node == NULL)
+	return;
+    while (node->left != NULL)
+	node = node->left;
+    while (node != NULL) {
+	(*func)((int)node->item);
+	if (node->right != NULL) {		// leftmost node of right subtree
+	    node = node->right;
+	    while (node->left != NULL)
+		node = node->left;
+	} else {				// climb until we come from a left child
+	    while (node->parent != NULL && node == node->parent->right)
+		node = node->parent;
+	    node = node->parent;
+	}
+    }
+}
@@ -0,0 +1,68 @@
+// rbtree.h
+//	Data structures to manage a balanced (red-black) search tree.
+//
+//	Like a sorted List, the tree holds "void *" items ordered by
+//	an integer key, but insertion and removal of the smallest item
+//	take O(log n) instead of O(n).  This is what the completely
+//	fair scheduler uses to keep threads ordered by virtual runtime.
+//
+//	Items with equal keys are kept in insertion order, so that
+//	the tree degenerates to FIFO behaviour when all keys are equal.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef RBTREE_H
+#define RBTREE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// The following class defines a node of the tree.  Internal data
+// structures kept public so that RedBlackTree operations can access
+// them directly.
+
+class RedBlackNode {
+   public:
+     RedBlackNode(void *itemPtr, int sortKey);	// initialize a tree node
+
+     RedBlackNode *left;	// subtree with smaller keys, NULL if none
+     RedBlackNode *right;	// subtree with larger (or equal) keys
+     RedBlackNode *parent;	// NULL if this is the root
+     bool red;			// node colour; the root is always black
+     int key;			// sort key of the item
+     void *item;		// pointer to item in the tree
+};
+
+// The following class defines the tree itself.
+
+class RedBlackTree {
+  public:
+    RedBlackTree();			// initialize an empty tree
+    ~RedBlackTree();			// de-allocate the tree
+
+    void Insert(void *item, int sortKey);	// Put item into the tree
+    void *RemoveMin(int *keyPtr);	// Remove item with smallest key
+    void *RemoveMax(int *keyPtr);	// Remove item with largest key
+    bool MinKey(int *keyPtr);		// Peek at smallest key, FALSE if empty
+
+    void Mapcar(VoidFunctionPtr func);	// Apply "func" to every item,
+					// in increasing order of key
+    bool IsEmpty() { return (root == NULL); }
+    int NumItems() { return numItems; }
+
+  private:
+    RedBlackNode *root;		// NULL if the tree is empty
+    int numItems;		// number of items in the tree
+
+    void RotateLeft(RedBlackNode *node);
+    void RotateRight(RedBlackNode *node);
+    void InsertFixup(RedBlackNode *node);
+    void Transplant(RedBlackNode *oldNode, RedBlackNode *newNode);
+    void DeleteNode(RedBlackNode *node);
+    void DeleteFixup(RedBlackNode *node, RedBlackNode *parentNode);
+    void *RemoveNode(RedBlackNode *node, int *keyPtr);
+};
+
+#endif // RBTREE_H
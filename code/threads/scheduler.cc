@@ -22,6 +22,8 @@
 #include "scheduler.h"
 #include "system.h"
 
+SchedulingAlgo ProcessScheduler::schedAlgo;
+
 //----------------------------------------------------------------------
 // ProcessScheduler::ProcessScheduler
 // 	Initialize the list of ready but not running threads to empty.
@@ -30,6 +32,12 @@
 ProcessScheduler::ProcessScheduler()
 {
     listOfReadyThreads = new List;
+    fairReadyTree = new RedBlackTree;
+    minVirtualRuntime = 0;
+    listOfRealTimeThreads = new List;
+    listOfThrottledThreads = new List;
+    realTimeUtilization = 0;
+    readyCount = 0;
 }
 
 //----------------------------------------------------------------------
@@ -40,6 +48,9 @@ ProcessScheduler::ProcessScheduler()
 ProcessScheduler::~ProcessScheduler()
 {
     delete listOfReadyThreads;
+    delete fairReadyTree;
+    delete listOfRealTimeThreads;
+    delete listOfThrottledThreads;
 }
 
 //----------------------------------------------------------------------
@@ -56,16 +67,35 @@ ProcessScheduler::MoveThreadToReadyQueue (NachOSThread *thread)
     DEBUG('t', "Putting thread %s with PID %d on ready list.\n", thread->getName(), thread->GetPID());
 
     thread->setStatus(READY);
+    readyCount++;
 
 #ifdef USER_PROGRAM
     thread->statistics->setWaitStartTime(stats->totalTicks);
 
-    if (schedAlgo == 2)
+    if (thread->IsRealTime()) {
+        // If the current job's deadline has passed while the thread was
+        // blocked or throttled, this is the release of a new job.
+        ReleaseRealTimeJob(thread);
+        if (thread->rtBudgetLeft > 0)
+            listOfRealTimeThreads->SortedInsert(thread, thread->rtDeadline);
+        else
+            listOfThrottledThreads->SortedInsert(thread, thread->rtDeadline);
+    }
+    else if (schedAlgo == 2)
         listOfReadyThreads->SortedInsert(thread,
                                          thread->statistics->getExpectedCPUBurst());
-    else if (schedAlgo > 6)
+    else if (schedAlgo >= PtvPrioritySched1 && schedAlgo <= PtvPrioritySched4)
         listOfReadyThreads->SortedInsert(thread,
                                          thread->UNIXPriority);
+    else if (schedAlgo == PtvCompletelyFair) {
+        // A new thread, or one that slept for a long time, must not be
+        // able to monopolize the CPU with a stale (small) virtual
+        // runtime, so it is placed no further left than the tree's
+        // current minimum.
+        if (thread->virtualRuntime < minVirtualRuntime)
+            thread->virtualRuntime = minVirtualRuntime;
+        fairReadyTree->Insert(thread, thread->virtualRuntime);
+    }
     else
         listOfReadyThreads->Append((void *)thread);
 #else
@@ -85,7 +115,324 @@ ProcessScheduler::MoveThreadToReadyQueue (NachOSThread *thread)
 NachOSThread *
 ProcessScheduler::SelectNextReadyThread ()
 {
-    return (NachOSThread *)listOfReadyThreads->Remove();
+    NachOSThread *thread;
+    int virtualRuntime;
+
+    ReplenishThrottledThreads();
+    if (!listOfRealTimeThreads->IsEmpty())
+        thread = (NachOSThread *)listOfRealTimeThreads->Remove();
+    else if (schedAlgo == PtvCompletelyFair) {
+        thread = (NachOSThread *)fairReadyTree->RemoveMin(&virtualRuntime);
+        if (thread != NULL && virtualRuntime > minVirtualRuntime)
+            minVirtualRuntime = virtualRuntime;
+    }
+    else
+        thread = (NachOSThread *)listOfReadyThreads->Remove();
+
+    // Throttled threads only get the CPU that nobody else wants.
+    if (thread == NULL)
+        thread = (NachOSThread *)listOfThrottledThreads->Remove();
+
+    if (thread != NULL)
+        readyCount--;
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// ProcessScheduler::HasMigratableThread
+// 	Return TRUE if some ready thread may move to another CPU, i.e.
+//	RemoveThreadForMigration would not return NULL.
+//----------------------------------------------------------------------
+
+bool
+ProcessScheduler::HasMigratableThread ()
+{
+    if (schedAlgo == PtvCompletelyFair)
+        return !fairReadyTree->IsEmpty();
+    return !listOfReadyThreads->IsEmpty();
+}
+
+//----------------------------------------------------------------------
+// ProcessScheduler::RemoveThreadForMigration
+// 	Take the ready thread that would run last off the ready list, so
+//	that the load balancer can move it to a less loaded CPU.  The
+//	thread at the front is likely to run soon (and, on a real machine,
+//	to still have its working set in this CPU's cache), so it is left
+//	alone.  Real-time threads stay on the CPU that admitted them,
+//	since admission control is per CPU.
+//
+//	A fair-share thread's virtual runtime is made relative to our
+//	minimum, so that it keeps its place when it joins another tree.
+//
+//	Returns NULL if there is no thread that can be migrated.
+//----------------------------------------------------------------------
+
+NachOSThread *
+ProcessScheduler::RemoveThreadForMigration ()
+{
+    NachOSThread *thread;
+    int key;
+
+    if (schedAlgo == PtvCompletelyFair) {
+        thread = (NachOSThread *)fairReadyTree->RemoveMax(&key);
+        if (thread != NULL)
+            thread->virtualRuntime -= minVirtualRuntime;
+    }
+    else
+        thread = (NachOSThread *)listOfReadyThreads->RemoveLast(&key);
+
+    if (thread != NULL)
+        readyCount--;
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// ProcessScheduler::AddMigratedThread
+// 	Put "thread", just taken off another CPU's ready list by
+//	RemoveThreadForMigration, onto ours.  It has been waiting since
+//	it was first made ready, so its wait start time is kept.
+//----------------------------------------------------------------------
+
+void
+ProcessScheduler::AddMigratedThread (NachOSThread *thread)
+{
+#ifdef USER_PROGRAM
+    int waitStartTime = thread->statistics->getWaitStartTime();
+
+    if (schedAlgo == PtvCompletelyFair)
+        thread->virtualRuntime += minVirtualRuntime;
+    MoveThreadToReadyQueue(thread);
+    thread->statistics->setWaitStartTime(waitStartTime);
+#else
+    MoveThreadToReadyQueue(thread);
+#endif
+}
+
+//----------------------------------------------------------------------
+// ProcessScheduler::FairShareExceeded
+// 	Called from the timer interrupt handler once "thread" has run for
+//	at least the minimum granularity.  Returns TRUE if the thread, after
+//	being charged for the "ranFor" ticks of its current burst, would no
+//	longer have the smallest virtual runtime, i.e. some ready thread
+//	is owed the CPU.  If nobody is behind it, the thread keeps running
+//	and we avoid a useless context switch.
+//----------------------------------------------------------------------
+
+bool
+ProcessScheduler::FairShareExceeded (NachOSThread *thread, int ranFor)
+{
+    int leftmost;
+
+    if (!fairReadyTree->MinKey(&leftmost))
+        return FALSE;
+    return (leftmost < thread->virtualRuntime + thread->VirtualRuntimeDelta(ranFor));
+}
+
+//----------------------------------------------------------------------
+// ProcessScheduler::AdmitRealTime
+// 	Move "thread" into the real-time class, reserving "budget" ticks
+//	of CPU every "period" ticks, provided the total utilization of
+//	all real-time threads stays within RealTimeUtilizationBound.
+//	A thread that is already real-time may change its reservation;
+//	its old share does not count against the new one.
+//
+//	The first job is released immediately.  Returns FALSE (and leaves
+//	the thread alone) if the reservation is invalid or would overload
+//	the CPU.
+//----------------------------------------------------------------------
+
+bool
+ProcessScheduler::AdmitRealTime (NachOSThread *thread, int period, int budget)
+{
+    float others = realTimeUtilization;
+
+    if (period <= 0 || budget <= 0 || budget > period)
+        return FALSE;
+    if (thread->IsRealTime())
+        others -= (float)thread->rtBudget / thread->rtPeriod;
+    if (others + (float)budget / period > RealTimeUtilizationBound) {
+        DEBUG('t', "Rejecting real-time thread %d: utilization %f + %d/%d\n",
+              thread->GetPID(), others, budget, period);
+        return FALSE;
+    }
+
+    realTimeUtilization = others + (float)budget / period;
+    thread->rtPeriod = period;
+    thread->rtBudget = budget;
+    thread->rtDeadline = stats->totalTicks + period;
+    // The whole of the current burst is charged to the budget when it
+    // ends, including the ticks run before this call; credit them back.
+    thread->rtBudgetLeft = budget +
+        (stats->totalTicks - thread->statistics->getBurstStartTime());
+    thread->rtJobMissed = FALSE;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// ProcessScheduler::LeaveRealTime
+// 	Release the CPU share reserved by "thread", which goes back to
+//	being scheduled by the selected algorithm.
+//----------------------------------------------------------------------
+
+void
+ProcessScheduler::LeaveRealTime (NachOSThread *thread)
+{
+    if (!thread->IsRealTime())
+        return;
+    realTimeUtilization -= (float)thread->rtBudget / thread->rtPeriod;
+    if (realTimeUtilization < 0)
+        realTimeUtilization = 0;
+    thread->rtPeriod = 0;
+}
+
+//----------------------------------------------------------------------
+// ProcessScheduler::ChargeRealTime
+// 	Charge the CPU burst that a real-time thread just finished to the
+//	budget of its current job.
+//
+//	A job that has used up its budget is throttled: until its
+//	deadline, when the budget is replenished (less any overrun, see
+//	ReleaseRealTimeJob), it is not allowed to
+//	take the CPU from any other thread (see MoveThreadToReadyQueue).
+//	This keeps the share promised by admission control to the other
+//	threads, real-time or not.
+//
+//	"jobDone" is TRUE if the thread is blocking or exiting, which ends
+//	the current job; a job that ends past its deadline is a miss,
+//	unless it overran its budget, which is counted instead.
+//----------------------------------------------------------------------
+
+void
+ProcessScheduler::ChargeRealTime (NachOSThread *thread, int runningTime,
+                                  bool jobDone)
+{
+    if (thread->rtBudgetLeft > 0 && thread->rtBudgetLeft <= runningTime)
+        stats->numBudgetOverruns++;
+    thread->rtBudgetLeft -= runningTime;
+
+    if (jobDone) {
+        stats->numRealTimeJobs++;
+        if (stats->totalTicks > thread->rtDeadline &&
+            thread->rtBudgetLeft > 0 && !thread->rtJobMissed) {
+            stats->numDeadlineMisses++;
+            thread->rtJobMissed = TRUE;
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// ProcessScheduler::ReleaseRealTimeJob
+// 	If the deadline of the current job of "thread" has passed, release
+//	its next job: move the deadline on to the end of the current
+//	period, and give it a budget for each period that has passed.
+//
+//	Budget left unused does not carry over, but an overrun does: it is
+//	paid back out of the next budgets, so that a thread that keeps
+//	overrunning cannot take more than its reserved share.  The budget
+//	is never more than one full budget.
+//----------------------------------------------------------------------
+
+void
+ProcessScheduler::ReleaseRealTimeJob (NachOSThread *thread)
+{
+    if (stats->totalTicks < thread->rtDeadline)
+        return;
+    if (thread->rtBudgetLeft > 0)
+        thread->rtBudgetLeft = 0;
+    while (thread->rtDeadline <= stats->totalTicks) {
+        thread->rtDeadline += thread->rtPeriod;
+        thread->rtBudgetLeft += thread->rtBudget;
+    }
+    if (thread->rtBudgetLeft > thread->rtBudget)
+        thread->rtBudgetLeft = thread->rtBudget;
+    thread->rtJobMissed = FALSE;
+}
+
+//----------------------------------------------------------------------
+// ProcessScheduler::ReplenishThrottledThreads
+// 	Release the next job of the throttled threads whose deadline has
+//	passed, and move them to the list of ready real-time threads, or,
+//	if they are still paying back an overrun, leave them throttled
+//	until their new deadline.
+//----------------------------------------------------------------------
+
+void
+ProcessScheduler::ReplenishThrottledThreads ()
+{
+    NachOSThread *thread;
+    int replenishAt;
+
+    while ((thread = (NachOSThread *)listOfThrottledThreads->Front(&replenishAt))
+           != NULL && replenishAt <= stats->totalTicks) {
+        listOfThrottledThreads->Remove();
+        ReleaseRealTimeJob(thread);
+        if (thread->rtBudgetLeft > 0)
+            listOfRealTimeThreads->SortedInsert(thread, thread->rtDeadline);
+        else
+            listOfThrottledThreads->SortedInsert(thread, thread->rtDeadline);
+    }
+}
+
+//----------------------------------------------------------------------
+// ProcessScheduler::RealTimePreemption
+// 	Called from the timer interrupt handler, with "thread" running
+//	for "ranFor" ticks.  Budgets are only enforced at timer
+//	interrupts, so a job may overrun by up to one timer period.
+//
+//	Returns TRUE if the thread must give up the CPU: a real-time
+//	thread that has used up its budget, or any thread while a
+//	real-time thread with an earlier deadline is ready.  Throttled
+//	threads whose budget is due back are made ready first.
+//	Also counts a miss for a running job that is past its deadline.
+//----------------------------------------------------------------------
+
+bool
+ProcessScheduler::RealTimePreemption (NachOSThread *thread, int ranFor)
+{
+    NachOSThread *first;
+
+    ReplenishThrottledThreads();
+    if (thread->IsRealTime()) {
+        if (ranFor >= thread->rtBudgetLeft)
+            return TRUE;		// out of budget, or throttled
+        if (stats->totalTicks > thread->rtDeadline && !thread->rtJobMissed) {
+            stats->numDeadlineMisses++;
+            thread->rtJobMissed = TRUE;
+        }
+    }
+
+    if (listOfRealTimeThreads->IsEmpty())
+        return FALSE;
+    if (!thread->IsRealTime())
+        return TRUE;
+    first = (NachOSThread *)listOfRealTimeThreads->Front(NULL);
+    return (first->rtDeadline < thread->rtDeadline);
+}
+
+//----------------------------------------------------------------------
+// ProcessScheduler::ShouldPreempt
+// 	Called from the timer interrupt handler, with "thread" running
+//	for "ranFor" ticks.  Returns TRUE if it should give up the CPU.
+//
+//	Budgets and deadlines come first; a real-time thread is not
+//	subject to the quantum of the selected algorithm.  The
+//	non-preemptive algorithms (1 and 2) never preempt otherwise.
+//----------------------------------------------------------------------
+
+bool
+ProcessScheduler::ShouldPreempt (NachOSThread *thread, int ranFor)
+{
+    if (RealTimePreemption(thread, ranFor))
+        return TRUE;
+    if (thread->IsRealTime())
+        return FALSE;
+
+    if (schedAlgo == PtvCompletelyFair)
+        // The quantum is only the minimum granularity; past it, give
+        // up the CPU only if some ready thread has less virtual runtime.
+        return (ranFor >= stats->timerInterruptTicks &&
+                FairShareExceeded(thread, ranFor));
+    return (schedAlgo > 2 && ranFor >= stats->timerInterruptTicks);
 }
 
 //----------------------------------------------------------------------
@@ -119,12 +466,22 @@ ProcessScheduler::ScheduleThread (NachOSThread *nextThread)
     oldThread->CheckOverflow();		    // check if the old thread
     // had an undetected stack overflow
 
+    if (oldThread != nextThread)
+        stats->numContextSwitches++;
+
     currentThread = nextThread;		    // switch to the next thread
     currentThread->setStatus(RUNNING);      // nextThread is now running
 
-    // Mark the start of CPU burst.
+    // Mark the start of CPU burst.  A thread that was made ready on
+    // another CPU started waiting by that CPU's clock, which may be a
+    // little ahead of ours.
     waitTime = currentThread->statistics->getWaitTimeAndRun(stats->totalTicks);
-    stats->trackWaitTime(waitTime);
+    if (waitTime < 0)
+        waitTime = 0;
+#ifdef USER_PROGRAM
+    if (multiprocessor == NULL || multiprocessor->Dispatch(currentThread))
+#endif
+        stats->trackWaitTime(waitTime);
     currentThread->statistics->setBurstStartTime(stats->totalTicks);
 
     DEBUG('t', "Switching from thread \"%s\" with pid %d to thread \"%s\" with pid %d\n",
@@ -191,5 +548,10 @@ void
 ProcessScheduler::Print()
 {
     printf("Ready list contents:\n");
-    listOfReadyThreads->Mapcar((VoidFunctionPtr) ThreadPrint);
+    listOfRealTimeThreads->Mapcar((VoidFunctionPtr) ThreadPrint);
+    listOfThrottledThreads->Mapcar((VoidFunctionPtr) ThreadPrint);
+    if (schedAlgo == PtvCompletelyFair)
+        fairReadyTree->Mapcar((VoidFunctionPtr) ThreadPrint);
+    else
+        listOfReadyThreads->Mapcar((VoidFunctionPtr) ThreadPrint);
 }
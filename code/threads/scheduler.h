@@ -11,6 +11,7 @@
 
 #include "copyright.h"
 #include "list.h"
+#include "rbtree.h"
 #include "thread.h"
 
 //----------------------------------------------------------------------
@@ -27,10 +28,18 @@ enum SchedulingAlgo {
     PtvPrioritySched1 = 7, 	// Using 1/4th quanta
     PtvPrioritySched2 = 8,	// Using 1/2th quanta
     PtvPrioritySched3 = 9,      // Using 3/4th quanta
-    PtvPrioritySched4 = 10 	// Maximum CPU utilization quanta
+    PtvPrioritySched4 = 10, 	// Maximum CPU utilization quanta
+    PtvCompletelyFair = 11	// Smallest virtual runtime first, quantum
+				// is the minimum granularity
 };
 
 
+// Real-time threads are admitted as long as the sum of budget/period
+// over all of them stays within this bound.  EDF could in principle
+// use the whole CPU, but kernel time is charged to whichever thread is
+// running, so some headroom is kept.
+#define RealTimeUtilizationBound 0.9
+
 // The following class defines the scheduler/dispatcher abstraction --
 // the data structures and operations needed to keep track of which
 // thread is running, and which threads are ready but not running.
@@ -49,12 +58,63 @@ class ProcessScheduler {
 
 	void Tail();		   // Used by fork()
 
-	SchedulingAlgo schedAlgo;  // Selected scheduling algorithm
+	static SchedulingAlgo schedAlgo;  // Selected scheduling algorithm,
+				   // shared by the schedulers of all CPUs
+
+	bool FairShareExceeded(NachOSThread *thread, int ranFor);
+				   // Has "thread" run ahead of the
+				   // leftmost thread in the fair tree?
+
+	// Earliest-deadline-first real-time class.  Ready real-time
+	// threads run before all other threads, whatever the selected
+	// algorithm, as long as they have budget left.
+	bool AdmitRealTime(NachOSThread *thread, int period, int budget);
+	void LeaveRealTime(NachOSThread *thread);
+	void ChargeRealTime(NachOSThread *thread, int runningTime, bool jobDone);
+	bool RealTimePreemption(NachOSThread *thread, int ranFor);
+				   // Should "thread" give up the CPU now?
+	bool ShouldPreempt(NachOSThread *thread, int ranFor);
+				   // Same question, for the timer: also
+				   // applies the algorithm's quantum
+
+	// Used by the load balancer and by idle CPUs stealing work, on
+	// a multiprocessor (see cpu.h).  The ready list acts as a deque:
+	// the owning CPU pops threads from the front, other CPUs take
+	// them from the back.
+	int NumReady() { return readyCount; }
+	bool HasMigratableThread(); // Can RemoveThreadForMigration succeed?
+	NachOSThread *RemoveThreadForMigration();
+				   // Take a thread that will not run soon
+				   // off the ready list, NULL if none
+	void AddMigratedThread(NachOSThread *thread);
+				   // Put a thread from another CPU's
+				   // ready list onto ours
 
     private:
 	// queue of threads that are ready to run,
 	// but not running
 	List *listOfReadyThreads;
+
+	// Ready threads ordered by virtual runtime (PtvCompletelyFair).
+	RedBlackTree *fairReadyTree;
+	int minVirtualRuntime;	   // Monotonic lower bound on the
+				   // virtual runtime of ready threads
+
+	// Ready real-time threads, ordered by absolute deadline.
+	List *listOfRealTimeThreads;
+	// Ready real-time threads that have used up their budget, ordered
+	// by when it is replenished (their deadline).  They only run when
+	// no other thread is ready.
+	List *listOfThrottledThreads;
+	float realTimeUtilization; // Sum of budget/period of admitted threads
+	void ReleaseRealTimeJob(NachOSThread *thread);
+				   // Start the next job if the deadline
+				   // of the current one has passed
+	void ReplenishThrottledThreads();
+				   // Move throttled threads whose budget
+				   // is due back to the real-time list
+
+	int readyCount;		   // Number of threads on all ready lists
 };
 
 #endif // SCHEDULER_H
@@ -1,8 +1,8 @@
 // synch.cc 
 //	Routines for synchronizing threads.  Three kinds of
 //	synchronization routines are defined here: semaphores, locks 
-//   	and condition variables (the implementation of the last two
-//	are left to the reader).
+//   	and condition variables.  Locks and condition variables are
+//	built out of semaphores.
 //
 // Any implementation of a synchronization routine needs some
 // primitive atomic operation.  We assume Nachos is running on
@@ -97,16 +97,141 @@ Semaphore::V()
     (void) interrupt->SetLevel(oldLevel);
 }
 
-// Dummy functions -- so we can compile our later assignments 
-// Note -- without a correct implementation of Condition::Wait(), 
-// the test case in the network assignment won't work!
-Lock::Lock(char* debugName) {}
-Lock::~Lock() {}
-void Lock::Acquire() {}
-void Lock::Release() {}
-
-Condition::Condition(char* debugName) { }
-Condition::~Condition() { }
-void Condition::Wait(Lock* conditionLock) { ASSERT(FALSE); }
-void Condition::Signal(Lock* conditionLock) { }
-void Condition::Broadcast(Lock* conditionLock) { }
+//----------------------------------------------------------------------
+// Lock::Lock
+// 	Initialize a lock, so that it can be used for mutual exclusion.
+//	A lock is a binary semaphore that remembers its holder.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+Lock::Lock(char* debugName)
+{
+    name = debugName;
+    semaphore = new Semaphore(debugName, 1);
+    holder = NULL;
+}
+
+//----------------------------------------------------------------------
+// Lock::~Lock
+// 	De-allocate a lock, when no longer needed.  Assume no one holds
+//	it, or is waiting for it!
+//----------------------------------------------------------------------
+
+Lock::~Lock()
+{
+    delete semaphore;
+}
+
+//----------------------------------------------------------------------
+// Lock::Acquire
+// 	Wait until the lock is FREE, then take it.
+//----------------------------------------------------------------------
+
+void
+Lock::Acquire()
+{
+    ASSERT(!isHeldByCurrentThread());	// locks are not recursive
+    semaphore->P();
+    holder = currentThread;
+}
+
+//----------------------------------------------------------------------
+// Lock::Release
+// 	Set the lock FREE, waking up a thread waiting in Acquire, if any.
+//	Only the holder may release the lock.
+//----------------------------------------------------------------------
+
+void
+Lock::Release()
+{
+    ASSERT(isHeldByCurrentThread());
+    holder = NULL;
+    semaphore->V();
+}
+
+//----------------------------------------------------------------------
+// Lock::isHeldByCurrentThread
+// 	Return TRUE if the current thread holds the lock.
+//----------------------------------------------------------------------
+
+bool
+Lock::isHeldByCurrentThread()
+{
+    return holder == currentThread;
+}
+
+//----------------------------------------------------------------------
+// Condition::Condition
+// 	Initialize a condition variable, with no one waiting on it.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+Condition::Condition(char* debugName)
+{
+    name = debugName;
+    waiters = new List;
+}
+
+//----------------------------------------------------------------------
+// Condition::~Condition
+// 	De-allocate a condition variable.  Assume no one is waiting on it!
+//----------------------------------------------------------------------
+
+Condition::~Condition()
+{
+    ASSERT(waiters->IsEmpty());
+    delete waiters;
+}
+
+//----------------------------------------------------------------------
+// Condition::Wait
+// 	Release "conditionLock", wait until signalled, and take the lock
+//	again.  Each waiter sleeps on a semaphore of its own, which it
+//	puts on the queue before releasing the lock, so that a Signal
+//	between the two is not lost.
+//----------------------------------------------------------------------
+
+void
+Condition::Wait(Lock* conditionLock)
+{
+    Semaphore *waiter;
+
+    ASSERT(conditionLock->isHeldByCurrentThread());
+    waiter = new Semaphore(name, 0);
+    waiters->Append((void *) waiter);
+    conditionLock->Release();
+    waiter->P();
+    conditionLock->Acquire();
+    delete waiter;
+}
+
+//----------------------------------------------------------------------
+// Condition::Signal
+// 	Wake up the thread that has waited longest, if any.  With Mesa
+//	semantics, it must check again for the condition it waited for.
+//----------------------------------------------------------------------
+
+void
+Condition::Signal(Lock* conditionLock)
+{
+    Semaphore *waiter;
+
+    ASSERT(conditionLock->isHeldByCurrentThread());
+    waiter = (Semaphore *) waiters->Remove();
+    if (waiter != NULL)
+	waiter->V();
+}
+
+//----------------------------------------------------------------------
+// Condition::Broadcast
+// 	Wake up every thread waiting on the condition.
+//----------------------------------------------------------------------
+
+void
+Condition::Broadcast(Lock* conditionLock)
+{
+    while (!waiters->IsEmpty())
+	Signal(conditionLock);
+}
@@ -2,10 +2,8 @@
 //	Data structures for synchronizing threads.
 //
 //	Three kinds of synchronization are defined here: semaphores,
-//	locks, and condition variables.  The implementation for
-//	semaphores is given; for the latter two, only the procedure
-//	interface is given -- they are to be implemented as part of 
-//	the first assignment.
+//	locks, and condition variables.  Locks and condition variables
+//	are built out of semaphores (cf. synch.cc).
 //
 //	Note that all the synchronization objects take a "name" as
 //	part of the initialization.  This is solely for debugging purposes.
@@ -79,7 +77,8 @@ class Lock {
 
   private:
     char* name;				// for debugging
-    // plus some other stuff you'll need to define
+    Semaphore *semaphore;		// 1 if FREE, 0 if BUSY
+    NachOSThread *holder;		// the thread holding the lock, if BUSY
 };
 
 // The following class defines a "condition variable".  A condition
@@ -131,6 +130,6 @@ class Condition {
 
   private:
     char* name;
-    // plus some other stuff you'll need to define
+    List *waiters;			// a semaphore for each thread in Wait()
 };
 #endif // SYNCH_H
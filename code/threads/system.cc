@@ -18,6 +18,8 @@ Interrupt *interrupt;			// interrupt status
 Statistics *stats;			// performance metrics
 Timer *timer;				// the hardware timer device,
 					// for invoking context switches
+QuantumController *quantumController;	// retunes the quantum, if "-aq"
+PredictorKind burstPredictorKind;	// CPU burst predictor, "-bp"
 unsigned numPagesAllocated;              // number of physical frames allocated
 
 NachOSThread *threadArray[MAX_THREAD_COUNT];  // Array of thread pointers
@@ -26,6 +28,7 @@ bool initializedConsoleSemaphores;
 bool exitThreadArray[MAX_THREAD_COUNT];  //Marks exited threads
 
 TimeSortedWaitQueue *sleepQueueHead;    // Needed to implement SC_Sleep
+InputLog *inputLog;			// "-record" or "-replay" log
 
 #ifdef FILESYS_NEEDED
 FileSystem  *fileSystem;
@@ -33,10 +36,16 @@ FileSystem  *fileSystem;
 
 #ifdef FILESYS
 SynchDisk   *synchDisk;
+BufferCache *bufferCache;	// disk sectors cached in memory, "-bc"
+HeaderCache *headerCache;	// file headers shared by open files
 #endif
 
 #ifdef USER_PROGRAM	// requires either FILESYS or FILESYS_STUB
 Machine *machine;	// user program memory and registers
+Multiprocessor *multiprocessor;	// simulated CPUs, if "-ncpu" > 1
+Profiler *profiler;		// samples user PCs, if "-prof"
+Tracer *tracer;			// instruction mix, if "-imix" or "-vatrace"
+MemoryHierarchy *caches;	// simulated caches, if "-l1i", "-l1d", "-l2"
 #endif
 
 #ifdef NETWORK
@@ -80,13 +89,33 @@ TimerInterruptHandler(int dummy)
     }
 
 #ifdef USER_PROGRAM
-    if (scheduler->schedAlgo > 2 &&
-    	stats->totalTicks - currentThread->statistics->getBurstStartTime() >=
-			    stats->timerInterruptTicks)
+    if (quantumController != NULL)
+	quantumController->Retune();
+
+    int ranFor = stats->totalTicks - currentThread->statistics->getBurstStartTime();
+
+    // An idle CPU has nothing to preempt.
+    if (interrupt->getStatus() != IdleMode &&
+	(multiprocessor == NULL || !multiprocessor->IsIdleThread(currentThread)) &&
+	scheduler->ShouldPreempt(currentThread, ranFor))
 	interrupt->YieldOnReturn();
+
+    if (profiler != NULL && interrupt->getStatus() == UserMode)
+	profiler->Sample(currentThread->GetPID(), machine->ReadRegister(PCReg));
+
+    if (interrupt->getStatus() == UserMode)
+	MaybeCheckpoint();
+
+    if (multiprocessor != NULL)
+	multiprocessor->TimerTick();	// the other CPUs, and load balancing
 #else
     interrupt->YieldOnReturn();
 #endif
+
+#ifdef FILESYS
+    if (bufferCache != NULL)
+	bufferCache->TimerTick();	// time to write dirty sectors back?
+#endif
 }
 
 //----------------------------------------------------------------------
@@ -105,9 +134,16 @@ Initialize(int argc, char **argv)
     int argCount, i;
     char* debugArgs = "";
     bool randomYield = FALSE;
+    QuantumTarget quantumTarget = SwitchOverheadTarget;
+    float quantumGoal = 0;	// 0 means no adaptive quantum
+    char *jsonFileName = NULL;	// export statistics as JSON
+    char *csvFileName = NULL;	// ... and as CSV
+    char *inputLogName = NULL;	// record inputs to, or replay them from
+    bool replayInputs = FALSE;	// ... this file
 
     initializedConsoleSemaphores = false;
     numPagesAllocated = 0;
+    burstPredictorKind = EWMAPredictor;
 
     for (i=0; i<MAX_THREAD_COUNT; i++) { threadArray[i] = NULL; exitThreadArray[i] = false; }
     thread_index = 0;
@@ -116,10 +152,26 @@ Initialize(int argc, char **argv)
 
 #ifdef USER_PROGRAM
     bool debugUserProg = FALSE;	// single step user program
+    int numCPUs = 1;		// simulated CPUs
+    bool workStealing = TRUE;	// idle CPUs steal ready threads
+    int epochTicks = 0;		// run CPUs in parallel, for this long
+    int profileTicks = 0;	// sample user PCs this often, 0 if not
+    bool instructionMix = FALSE;	// count instructions by opcode
+    char *addressTraceFile = NULL;	// ... and trace addresses to here
+    Cache *cacheConfig[NumCacheLevels] = { NULL, NULL, NULL };
+    int checkpointTicks = 0;	// when to write a checkpoint
+    char *checkpointFile = NULL;	// ... and where, NULL if not wanted
+    int level;
 #endif
 #ifdef FILESYS_NEEDED
     bool format = FALSE;	// format disk
 #endif
+#ifdef FILESYS
+    int numCacheBuffers = BufferCacheSize;	// sectors to cache
+    int flushInterval = BufferFlushInterval;	// ticks between flushes
+    DiskSchedAlgo diskSchedAlgo = DiskCLOOK;	// order of disk requests
+    bool diskMapped = FALSE;	// map the disk image into memory
+#endif
 #ifdef NETWORK
     double rely = 1;		// network reliability
     int netname = 0;		// UNIX socket name
@@ -140,15 +192,124 @@ Initialize(int argc, char **argv)
 						// number generator
 	    randomYield = TRUE;
 	    argCount = 2;
+	} else if (!strcmp(*argv, "-aq")) {
+	    // -aq overhead <fraction> | -aq response <ticks>
+	    ASSERT(argc > 2);
+	    if (!strcmp(*(argv + 1), "overhead"))
+		quantumTarget = SwitchOverheadTarget;
+	    else if (!strcmp(*(argv + 1), "response"))
+		quantumTarget = ResponseTimeTarget;
+	    else
+		ASSERT(FALSE);
+	    quantumGoal = atof(*(argv + 2));
+	    argCount = 3;
+	} else if (!strcmp(*argv, "-bp")) {
+	    // -bp ewma | median | linear
+	    ASSERT(argc > 1);
+	    if (!strcmp(*(argv + 1), "ewma"))
+		burstPredictorKind = EWMAPredictor;
+	    else if (!strcmp(*(argv + 1), "median"))
+		burstPredictorKind = MedianPredictor;
+	    else if (!strcmp(*(argv + 1), "linear"))
+		burstPredictorKind = LinearPredictor;
+	    else
+		ASSERT(FALSE);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-json")) {
+	    ASSERT(argc > 1);
+	    jsonFileName = *(argv + 1);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-csv")) {
+	    ASSERT(argc > 1);
+	    csvFileName = *(argv + 1);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-record") || !strcmp(*argv, "-replay")) {
+	    ASSERT(argc > 1);
+	    inputLogName = *(argv + 1);
+	    replayInputs = !strcmp(*argv, "-replay");
+	    argCount = 2;
 	}
 #ifdef USER_PROGRAM
 	if (!strcmp(*argv, "-s"))
 	    debugUserProg = TRUE;
+	else if (!strcmp(*argv, "-ncpu")) {
+	    ASSERT(argc > 1);
+	    numCPUs = atoi(*(argv + 1));
+	    ASSERT((numCPUs >= 1) && (numCPUs <= MaxCPUs));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-nosteal"))
+	    workStealing = FALSE;
+	else if (!strcmp(*argv, "-P")) {
+	    ASSERT(argc > 1);
+	    epochTicks = atoi(*(argv + 1));
+	    ASSERT(epochTicks >= 0);
+	    argCount = 2;
+	}
+	else if (!strcmp(*argv, "-prof")) {
+	    ASSERT(argc > 1);
+	    profileTicks = atoi(*(argv + 1));
+	    ASSERT(profileTicks > 0);
+	    argCount = 2;
+	}
+	else if (!strcmp(*argv, "-l1i") || !strcmp(*argv, "-l1d") ||
+		 !strcmp(*argv, "-l2")) {
+	    // -l1i | -l1d | -l2 <size> <associativity> <line size> <penalty>
+	    ASSERT(argc > 4);
+	    if (!strcmp(*argv, "-l1i"))
+		level = L1InstructionCache;
+	    else if (!strcmp(*argv, "-l1d"))
+		level = L1DataCache;
+	    else
+		level = L2Cache;
+	    delete cacheConfig[level];
+	    cacheConfig[level] = new Cache(atoi(*(argv + 1)),
+			atoi(*(argv + 2)), atoi(*(argv + 3)), atoi(*(argv + 4)));
+	    argCount = 5;
+	}
+	else if (!strcmp(*argv, "-ckpt")) {
+	    ASSERT(argc > 2);
+	    checkpointTicks = atoi(*(argv + 1));
+	    checkpointFile = *(argv + 2);
+	    argCount = 3;
+	}
+	else if (!strcmp(*argv, "-imix"))
+	    instructionMix = TRUE;
+	else if (!strcmp(*argv, "-vatrace")) {
+	    ASSERT(argc > 1);
+	    instructionMix = TRUE;
+	    addressTraceFile = *(argv + 1);
+	    argCount = 2;
+	}
 #endif
 #ifdef FILESYS_NEEDED
 	if (!strcmp(*argv, "-f"))
 	    format = TRUE;
 #endif
+#ifdef FILESYS
+	if (!strcmp(*argv, "-bc")) {
+	    // -bc <buffers> <flush interval>
+	    ASSERT(argc > 2);
+	    numCacheBuffers = atoi(*(argv + 1));
+	    flushInterval = atoi(*(argv + 2));
+	    ASSERT(numCacheBuffers >= 0 && flushInterval >= 0);
+	    argCount = 3;
+	} else if (!strcmp(*argv, "-ds")) {
+	    // -ds fcfs | sstf | scan | clook
+	    ASSERT(argc > 1);
+	    if (!strcmp(*(argv + 1), "fcfs"))
+		diskSchedAlgo = DiskFCFS;
+	    else if (!strcmp(*(argv + 1), "sstf"))
+		diskSchedAlgo = DiskSSTF;
+	    else if (!strcmp(*(argv + 1), "scan"))
+		diskSchedAlgo = DiskSCAN;
+	    else if (!strcmp(*(argv + 1), "clook"))
+		diskSchedAlgo = DiskCLOOK;
+	    else
+		ASSERT(FALSE);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-dm"))
+	    diskMapped = TRUE;
+#endif
 #ifdef NETWORK
 	if (!strcmp(*argv, "-l")) {
 	    ASSERT(argc > 1);
@@ -164,6 +325,11 @@ Initialize(int argc, char **argv)
 
     DebugInit(debugArgs);			// initialize DEBUG messages
     stats = new Statistics();			// collect statistics
+    stats->jsonFileName = jsonFileName;
+    stats->csvFileName = csvFileName;
+    inputLog = NULL;				// before the timer, which
+    if (inputLogName != NULL)			// may want random numbers
+	inputLog = new InputLog(inputLogName, replayInputs);
     interrupt = new Interrupt;			// start up interrupt handling
     scheduler = new ProcessScheduler();		// initialize the ready queue
 
@@ -171,6 +337,9 @@ Initialize(int argc, char **argv)
     // the effect of timer interrupt is nullified by not calling YieldOnReturn()
     // while inside TimerInterruptHandler.
     timer = new Timer(TimerInterruptHandler, 0, randomYield);
+    quantumController = NULL;
+    if (quantumGoal > 0)
+	quantumController = new QuantumController(quantumTarget, quantumGoal);
 
     // if (randomYield)				// start the timer (if needed)
     //     timer = new Timer(TimerInterruptHandler, 0, randomYield);
@@ -190,10 +359,35 @@ Initialize(int argc, char **argv)
 
 #ifdef USER_PROGRAM
     machine = new Machine(debugUserProg);	// this must come first
+    multiprocessor = NULL;
+    caches = NULL;
+    for (level = 0; level < NumCacheLevels; level++) {
+	if (cacheConfig[level] == NULL)
+	    continue;
+	if (caches == NULL)
+	    caches = new MemoryHierarchy;
+	caches->AddCache((CacheLevel) level, cacheConfig[level]);
+    }
+    if (debugUserProg || instructionMix || (caches != NULL))
+	epochTicks = 0;			// single-stepping, tracing and
+					// caches are one CPU at a time
+    if (numCPUs > 1)
+	multiprocessor = new Multiprocessor(numCPUs, debugUserProg,
+					    workStealing, epochTicks);
+    profiler = NULL;
+    if (profileTicks > 0)
+	profiler = new Profiler(profileTicks);
+    tracer = NULL;
+    if (instructionMix)
+	tracer = new Tracer(addressTraceFile);
+    if (checkpointFile != NULL)
+	ScheduleCheckpoint(checkpointTicks, checkpointFile);
 #endif
 
 #ifdef FILESYS
-    synchDisk = new SynchDisk("DISK");
+    synchDisk = new SynchDisk("DISK", diskSchedAlgo, diskMapped);
+    bufferCache = new BufferCache(numCacheBuffers, flushInterval);
+    headerCache = new HeaderCache(HeaderCacheSize);
 #endif
 
 #ifdef FILESYS_NEEDED
@@ -218,6 +412,10 @@ Cleanup()
 #endif
 
 #ifdef USER_PROGRAM
+    delete caches;
+    delete tracer;
+    delete profiler;
+    delete multiprocessor;
     delete machine;
 #endif
 
@@ -226,9 +424,13 @@ Cleanup()
 #endif
 
 #ifdef FILESYS
+    delete headerCache;
+    delete bufferCache;			// writes back dirty sectors
     delete synchDisk;
 #endif
 
+    delete quantumController;
+    delete inputLog;
     delete timer;
     delete scheduler;
     delete interrupt;
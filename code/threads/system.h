@@ -15,6 +15,7 @@
 #include "interrupt.h"
 #include "stats.h"
 #include "timer.h"
+#include "quantum.h"
 
 #define MAX_THREAD_COUNT 1000
 
@@ -32,6 +33,8 @@ extern ProcessScheduler *scheduler;			// the ready list
 extern Interrupt *interrupt;			// interrupt status
 extern Statistics *stats;			// performance metrics
 extern Timer *timer;				// the hardware alarm clock
+extern QuantumController *quantumController;	// adaptive quantum, NULL if off
+extern PredictorKind burstPredictorKind;	// how threads guess their next burst
 extern unsigned numPagesAllocated;              // number of physical frames allocated
 
 extern NachOSThread *threadArray[];  			// Array of thread pointers
@@ -57,9 +60,22 @@ public:
 
 extern TimeSortedWaitQueue *sleepQueueHead;
 
+#include "replay.h"
+extern InputLog *inputLog;		// external inputs, NULL if not
+					// recorded or replayed
+
 #ifdef USER_PROGRAM
 #include "machine.h"
+#include "cpu.h"
 extern Machine* machine;	// user program memory and registers
+extern Multiprocessor *multiprocessor;	// the other CPUs, NULL if only one
+#include "profile.h"
+extern Profiler *profiler;		// samples user PCs, NULL if off
+#include "trace.h"
+extern Tracer *tracer;			// instruction mix, NULL if off
+#include "cache.h"
+extern MemoryHierarchy *caches;		// simulated caches, NULL if none
+#include "checkpoint.h"
 #endif
 
 #ifdef FILESYS_NEEDED 		// FILESYS or FILESYS_STUB 
@@ -70,6 +86,10 @@ extern FileSystem  *fileSystem;
 #ifdef FILESYS
 #include "synchdisk.h"
 extern SynchDisk   *synchDisk;
+#include "bufcache.h"
+extern BufferCache *bufferCache;	// file system access to "synchDisk"
+#include "hdrcache.h"
+extern HeaderCache *headerCache;	// headers of files in use
 #endif
 
 #ifdef NETWORK
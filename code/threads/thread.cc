@@ -36,10 +36,23 @@ ThreadStatistics::ThreadStatistics()
    setBurstStartTime(0);
    // We need to start with a guess for the initial expected CPU burst.
    // We start off with setting it to the average value of CPU bursts
-   // measured when using the non-preemptive NachOS algorithm.
+   // measured so far, which is a better guess for a new thread than 0
+   // (that would put every new thread ahead of all the others).
    // NOTE: Any value can be chosen as it will have little effect in
    // the long run.
-   setExpectedCPUBurst(0);
+   setExpectedCPUBurst((int)stats->avgCPUBurst);
+   totalRunTime = numBursts = 0;
+   totalWaitTime = numWaits = 0;
+   predictor = new BurstPredictor(burstPredictorKind, getExpectedCPUBurst());
+}
+
+//----------------------------------------------------------------------
+// ThreadStatistics::~ThreadStatistics
+//      De-allocate the burst predictor.
+//----------------------------------------------------------------------
+ThreadStatistics::~ThreadStatistics()
+{
+   delete predictor;
 }
 
 //----------------------------------------------------------------------
@@ -131,8 +144,13 @@ ThreadStatistics::setExpectedCPUBurst(int _expectedCPUBurst)
 int
 ThreadStatistics::getWaitTimeAndRun(int currentTime)
 {
+   int waitTime = currentTime - getWaitStartTime();
+
    setBurstStartTime(currentTime);
-   return currentTime - getWaitStartTime();
+   if (waitTime > 0)
+      totalWaitTime += waitTime;
+   numWaits++;
+   return waitTime;
 }
 
 //----------------------------------------------------------------------
@@ -149,14 +167,20 @@ ThreadStatistics::getRunningTimeAndSleep(int currentTime)
 
    currentCPUBurst = currentTime - getBurstStartTime();
    stats->cpuBusyTime += currentCPUBurst;
+   if (currentCPUBurst > 0) {
+      totalRunTime += currentCPUBurst;
+      numBursts++;
+   }
 
    if (scheduler->schedAlgo == 2) {
       stats->errorCPUBurst += abs(currentCPUBurst - getExpectedCPUBurst());
 
       // Estimate the next CPU burst for the SJF algorithm.
-      // NOTE: getExpectedCPUBurst() will return the previously
-      // estimated expected CPU burst.
-      nextCPUBurst = stats->a*currentCPUBurst + (1-stats->a)*getExpectedCPUBurst();
+      // NOTE: the predictor is still holding the previously
+      // estimated expected CPU burst, which it scores before
+      // learning from the current one.
+      predictor->Update(currentCPUBurst);
+      nextCPUBurst = predictor->Predict();
       setExpectedCPUBurst(nextCPUBurst);
    }
 
@@ -183,6 +207,67 @@ ThreadStatistics::setWaitStartTime(int currentTime)
    waitStartTime = currentTime;
 }
 
+//----------------------------------------------------------------------
+// ThreadStatistics::getProcessRecord
+//      Returns a summary of the thread's life so far, for the
+//      per-process statistics.  The caller owns the record.
+//----------------------------------------------------------------------
+ProcessRecord *
+ThreadStatistics::getProcessRecord(int pid, int exitCode)
+{
+   ProcessRecord *record = new ProcessRecord;
+
+   record->pid = pid;
+   record->exitCode = exitCode;
+   record->startTime = getThreadStartTime();
+   record->finishTime = getThreadEndTime();
+   record->cpuTime = totalRunTime;
+   record->numBursts = numBursts;
+   record->waitTime = totalWaitTime;
+   record->numWaits = numWaits;
+   return record;
+}
+
+//----------------------------------------------------------------------
+// ThreadStatistics::Checkpoint
+//      Write the times to the checkpoint "fp".  The burst predictor
+//      is not saved.
+//----------------------------------------------------------------------
+void
+ThreadStatistics::Checkpoint(FILE *fp)
+{
+   fwrite(&threadStartTime, sizeof(int), 1, fp);
+   fwrite(&threadEndTime, sizeof(int), 1, fp);
+   fwrite(&burstStartTime, sizeof(int), 1, fp);
+   fwrite(&expectedCPUBurst, sizeof(int), 1, fp);
+   fwrite(&waitStartTime, sizeof(int), 1, fp);
+   fwrite(&totalRunTime, sizeof(int), 1, fp);
+   fwrite(&numBursts, sizeof(int), 1, fp);
+   fwrite(&totalWaitTime, sizeof(int), 1, fp);
+   fwrite(&numWaits, sizeof(int), 1, fp);
+}
+
+//----------------------------------------------------------------------
+// ThreadStatistics::Restore
+//      Read the times saved by Checkpoint.  The burst predictor starts
+//      over from the saved guess of the next CPU burst.
+//----------------------------------------------------------------------
+void
+ThreadStatistics::Restore(FILE *fp)
+{
+   fread(&threadStartTime, sizeof(int), 1, fp);
+   fread(&threadEndTime, sizeof(int), 1, fp);
+   fread(&burstStartTime, sizeof(int), 1, fp);
+   fread(&expectedCPUBurst, sizeof(int), 1, fp);
+   fread(&waitStartTime, sizeof(int), 1, fp);
+   fread(&totalRunTime, sizeof(int), 1, fp);
+   fread(&numBursts, sizeof(int), 1, fp);
+   fread(&totalWaitTime, sizeof(int), 1, fp);
+   fread(&numWaits, sizeof(int), 1, fp);
+   delete predictor;
+   predictor = new BurstPredictor(burstPredictorKind, getExpectedCPUBurst());
+}
+
 //----------------------------------------------------------------------
 // NachOSThread::NachOSThread
 // 	Initialize a thread control block, so that we can then call
@@ -202,6 +287,7 @@ NachOSThread::NachOSThread(char* threadName)
 #ifdef USER_PROGRAM
    space = NULL;
    stateRestored = true;
+   sysCallInProgress = -1;
 #endif
 
    threadArray[thread_index] = this;
@@ -221,8 +307,12 @@ NachOSThread::NachOSThread(char* threadName)
 
    instructionCount = 0;
 
-   basePriority = 50;
+   basePriority = DefaultBasePriority;
    UNIXPriority = 0;
+   virtualRuntime = 0;
+   rtPeriod = rtBudget = rtDeadline = rtBudgetLeft = 0;
+   rtJobMissed = FALSE;
+   lastCPU = -1;
    statistics = new ThreadStatistics();
 }
 
@@ -245,6 +335,7 @@ NachOSThread::~NachOSThread()
    ASSERT(this != currentThread);
    if (stack != NULL)
       DeallocBoundedArray((char *) stack, StackSize * sizeof(int));
+   delete statistics;
 }
 
 //----------------------------------------------------------------------
@@ -388,12 +479,22 @@ NachOSThread::Exit (bool terminateSim, int exitcode)
    statistics->setThreadEndTime(stats->totalTicks);
    stats->trackFinishTime(statistics->getThreadEndTime() -
                           statistics->getThreadStartTime());
+   stats->trackProcess(statistics->getProcessRecord(pid, exitcode));
+   if (scheduler->schedAlgo == 2)
+      statistics->predictor->PrintErrors(pid);
 
-   if (scheduler->schedAlgo > 6) {
+   if (scheduler->schedAlgo >= PtvPrioritySched1 &&
+       scheduler->schedAlgo <= PtvPrioritySched4) {
       // Update UNIX priority.
       UNIXCPUBurst += runningTime;
       updateUNIXPriorities();
    }
+   else if (scheduler->schedAlgo == PtvCompletelyFair)
+      virtualRuntime += VirtualRuntimeDelta(runningTime);
+   if (IsRealTime()) {
+      scheduler->ChargeRealTime(this, runningTime, TRUE);
+      scheduler->LeaveRealTime(this);
+   }
 #endif
 
    threadToBeDestroyed = currentThread;
@@ -403,11 +504,9 @@ NachOSThread::Exit (bool terminateSim, int exitcode)
    status = BLOCKED;
 
    // Set exit code in parent's structure provided the parent hasn't exited
-   if (ppid != -1) {
+   if ((ppid != -1) && !exitThreadArray[ppid]) {
       ASSERT(threadArray[ppid] != NULL);
-      if (!exitThreadArray[ppid]) {
-         threadArray[ppid]->SetChildExitCode (pid, exitcode);
-      }
+      threadArray[ppid]->SetChildExitCode (pid, exitcode);
    }
 
    while ((nextThread = scheduler->SelectNextReadyThread()) == NULL) {
@@ -417,6 +516,13 @@ NachOSThread::Exit (bool terminateSim, int exitcode)
          printf("Assuming all programs completed.\n");
          interrupt->Halt();
       }
+#ifdef USER_PROGRAM
+      else if (multiprocessor != NULL) {
+         // Other CPUs may still be busy; only this one goes idle.
+         nextThread = multiprocessor->IdleThread();
+         break;
+      }
+#endif
       else interrupt->Idle();      // no one to run, wait for an interrupt
    }
    scheduler->ScheduleThread(nextThread); // returns when we've been signalled
@@ -456,11 +562,16 @@ NachOSThread::YieldCPU ()
    runningTime = statistics->getRunningTimeAndSleep(stats->totalTicks);
    stats->trackCPUBurst(runningTime);
 
-   if (scheduler->schedAlgo > 6) {
+   if (scheduler->schedAlgo >= PtvPrioritySched1 &&
+       scheduler->schedAlgo <= PtvPrioritySched4) {
       // Update UNIX priority.
       UNIXCPUBurst += runningTime;
       updateUNIXPriorities();
    }
+   else if (scheduler->schedAlgo == PtvCompletelyFair)
+      virtualRuntime += VirtualRuntimeDelta(runningTime);
+   if (IsRealTime())
+      scheduler->ChargeRealTime(this, runningTime, FALSE);
 #endif
 
    nextThread = scheduler->SelectNextReadyThread();
@@ -508,15 +619,28 @@ NachOSThread::PutThreadToSleep ()
    runningTime = statistics->getRunningTimeAndSleep(stats->totalTicks);
    stats->trackCPUBurst(runningTime);
 
-   if (scheduler->schedAlgo > 6) {
+   if (scheduler->schedAlgo >= PtvPrioritySched1 &&
+       scheduler->schedAlgo <= PtvPrioritySched4) {
       // Update UNIX priority.
       UNIXCPUBurst += runningTime;
       updateUNIXPriorities();
    }
+   else if (scheduler->schedAlgo == PtvCompletelyFair)
+      virtualRuntime += VirtualRuntimeDelta(runningTime);
+   if (IsRealTime())
+      scheduler->ChargeRealTime(this, runningTime, TRUE);
 #endif
 
-   while ((nextThread = scheduler->SelectNextReadyThread()) == NULL)
+   while ((nextThread = scheduler->SelectNextReadyThread()) == NULL) {
+#ifdef USER_PROGRAM
+      if (multiprocessor != NULL) {
+         // Other CPUs may still be busy; only this one goes idle.
+         nextThread = multiprocessor->IdleThread();
+         break;
+      }
+#endif
       interrupt->Idle();	// no one to run, wait for an interrupt
+   }
 
    scheduler->ScheduleThread(nextThread); // returns when we've been signalled
 }
@@ -676,6 +800,114 @@ NachOSThread::ResetReturnValue ()
 {
    userRegisters[2] = 0;
 }
+
+//----------------------------------------------------------------------
+// NachOSThread::SkipSysCall
+//      Moves the saved program counters past the syscall instruction,
+//      as the system call handler would have done on return.
+//----------------------------------------------------------------------
+
+void
+NachOSThread::SkipSysCall ()
+{
+   userRegisters[PrevPCReg] = userRegisters[PCReg];
+   userRegisters[PCReg] = userRegisters[NextPCReg];
+   userRegisters[NextPCReg] += 4;
+}
+
+//----------------------------------------------------------------------
+// NachOSThread::Checkpoint
+//      Writes the thread to the checkpoint "fp": its identity, children,
+//      user registers, scheduling parameters, times and address space.
+//      The kernel stack cannot be saved; see userprog/checkpoint.h.
+//----------------------------------------------------------------------
+
+void
+NachOSThread::Checkpoint (FILE *fp)
+{
+   int nameLength = strlen(name) + 1;
+   bool hasSpace = (space != NULL);
+
+   fwrite(&pid, sizeof(int), 1, fp);
+   fwrite(&ppid, sizeof(int), 1, fp);
+   fwrite(&nameLength, sizeof(int), 1, fp);
+   fwrite(name, sizeof(char), nameLength, fp);
+   fwrite(childpidArray, sizeof(childpidArray), 1, fp);
+   fwrite(childexitcode, sizeof(childexitcode), 1, fp);
+   fwrite(exitedChild, sizeof(exitedChild), 1, fp);
+   fwrite(&childcount, sizeof(unsigned), 1, fp);
+   fwrite(&waitchild_id, sizeof(int), 1, fp);
+   fwrite(&instructionCount, sizeof(unsigned), 1, fp);
+
+   // The running thread's registers are still in the machine.
+   if (this == currentThread)
+      fwrite(machine->registers, sizeof(userRegisters), 1, fp);
+   else
+      fwrite(userRegisters, sizeof(userRegisters), 1, fp);
+   fwrite(&sysCallInProgress, sizeof(int), 1, fp);
+
+   fwrite(&basePriority, sizeof(int), 1, fp);
+   fwrite(&UNIXPriority, sizeof(int), 1, fp);
+   fwrite(&UNIXCPUBurst, sizeof(int), 1, fp);
+   fwrite(&virtualRuntime, sizeof(int), 1, fp);
+   fwrite(&rtPeriod, sizeof(int), 1, fp);
+   fwrite(&rtBudget, sizeof(int), 1, fp);
+   fwrite(&rtDeadline, sizeof(int), 1, fp);
+   fwrite(&rtBudgetLeft, sizeof(int), 1, fp);
+   fwrite(&rtJobMissed, sizeof(bool), 1, fp);
+   statistics->Checkpoint(fp);
+
+   fwrite(&hasSpace, sizeof(bool), 1, fp);
+   if (hasSpace)
+      space->Checkpoint(fp);
+}
+
+//----------------------------------------------------------------------
+// NachOSThread::Restore
+//      Reads a thread written by Checkpoint into this newly created
+//      thread, which takes over the saved pid.  The caller enters it in
+//      threadArray, and puts it back in the state (ready, sleeping, ...)
+//      it was in.
+//----------------------------------------------------------------------
+
+void
+NachOSThread::Restore (FILE *fp)
+{
+   int nameLength;
+   bool hasSpace;
+
+   fread(&pid, sizeof(int), 1, fp);
+   fread(&ppid, sizeof(int), 1, fp);
+   fread(&nameLength, sizeof(int), 1, fp);
+   name = new char[nameLength];
+   fread(name, sizeof(char), nameLength, fp);
+   fread(childpidArray, sizeof(childpidArray), 1, fp);
+   fread(childexitcode, sizeof(childexitcode), 1, fp);
+   fread(exitedChild, sizeof(exitedChild), 1, fp);
+   fread(&childcount, sizeof(unsigned), 1, fp);
+   fread(&waitchild_id, sizeof(int), 1, fp);
+   fread(&instructionCount, sizeof(unsigned), 1, fp);
+
+   fread(userRegisters, sizeof(userRegisters), 1, fp);
+   stateRestored = false;		// loaded into the machine on dispatch
+   fread(&sysCallInProgress, sizeof(int), 1, fp);
+
+   fread(&basePriority, sizeof(int), 1, fp);
+   fread(&UNIXPriority, sizeof(int), 1, fp);
+   fread(&UNIXCPUBurst, sizeof(int), 1, fp);
+   fread(&virtualRuntime, sizeof(int), 1, fp);
+   fread(&rtPeriod, sizeof(int), 1, fp);
+   fread(&rtBudget, sizeof(int), 1, fp);
+   fread(&rtDeadline, sizeof(int), 1, fp);
+   fread(&rtBudgetLeft, sizeof(int), 1, fp);
+   fread(&rtJobMissed, sizeof(bool), 1, fp);
+   statistics->Restore(fp);
+
+   fread(&hasSpace, sizeof(bool), 1, fp);
+   if (hasSpace)
+      space = new ProcessAddressSpace(fp);
+   ASSERT((pid >= 0) && (pid < MAX_THREAD_COUNT));
+}
 #endif
 
 //----------------------------------------------------------------------
@@ -784,3 +1016,17 @@ NachOSThread::updateUNIXPriorities()
       }
    }
 }
+
+//----------------------------------------------------------------------
+// NachOSThread::VirtualRuntimeDelta
+//      Returns the virtual runtime to be charged for a CPU burst of
+//      "runningTime" ticks.  A larger basePriority means a lower priority
+//      (as in UNIX), so such a thread ages faster in virtual time and
+//      receives a proportionally smaller share of the CPU.
+//----------------------------------------------------------------------
+
+int
+NachOSThread::VirtualRuntimeDelta(int runningTime)
+{
+   return (runningTime * basePriority) / DefaultBasePriority;
+}
@@ -39,8 +39,14 @@
 
 #define MAX_CHILD_COUNT 100
 
+// Base priority of a thread that was not given one explicitly.  Under
+// the completely fair scheduler, a thread with this base priority is
+// charged virtual runtime at the rate of real time.
+#define DefaultBasePriority 50
+
 #include "copyright.h"
 #include "utility.h"
+#include "predictor.h"
 
 #ifdef USER_PROGRAM
 #include "machine.h"
@@ -75,9 +81,14 @@ class ThreadStatistics {
 				// This also acts as 'waitEndTime'.
 	int expectedCPUBurst;	// Expected CPU burst for the next run
     	int waitStartTime; 	// Start time of current READY state
+	int totalRunTime;	// Ticks spent running, over all bursts
+	int numBursts;		// Number of non-zero CPU bursts
+	int totalWaitTime;	// Ticks spent in the ready queue
+	int numWaits;		// Number of times the thread was dispatched
 
     public:
     	ThreadStatistics();
+    	~ThreadStatistics();
     	int getThreadStartTime();
     	void setThreadStartTime(int);
     	int getThreadEndTime();
@@ -90,6 +101,11 @@ class ThreadStatistics {
     	int getRunningTimeAndSleep(int);
     	int getWaitStartTime();
     	void setWaitStartTime(int);
+    	ProcessRecord *getProcessRecord(int pid, int exitCode);
+    	void Checkpoint(FILE *fp);	// save the times to a checkpoint
+    	void Restore(FILE *fp);		// ... and load them back
+
+    	BurstPredictor *predictor;	// Guesses the next CPU burst (SJF)
 };
 
 // The following class defines a "thread control block" -- which
@@ -136,6 +152,7 @@ class NachOSThread {
 	void CheckOverflow();   			// Check if thread has
 	// overflowed its stack
 	void setStatus(ThreadStatus st) { status = st; }
+	ThreadStatus getStatus() { return status; }
 	char* getName() { return (name); }
 	void Print() { printf("%s, ", name); }
 
@@ -167,8 +184,24 @@ class NachOSThread {
     	int basePriority;
     	int UNIXPriority;
     	int UNIXCPUBurst;
+    	int virtualRuntime;	// CPU time charged by the fair scheduler,
+				// weighted by basePriority
 
     	void updateUNIXPriorities();
+    	int VirtualRuntimeDelta(int runningTime);
+
+	// Earliest-deadline-first real-time class (SysCall_SetRealTime).
+	// A thread is real-time iff rtPeriod > 0.  Each period releases a
+	// job, which must get rtBudget ticks of CPU before rtDeadline.
+    	int rtPeriod;		// ticks between job releases, 0 if not real-time
+    	int rtBudget;		// CPU ticks reserved per period
+    	int rtDeadline;		// absolute deadline of the current job
+    	int rtBudgetLeft;	// budget not yet used by the current job
+    	bool rtJobMissed;	// current job already counted as a miss
+    	bool IsRealTime() { return (rtPeriod > 0); }
+
+    	int lastCPU;		// simulated CPU this thread last ran on,
+				// -1 if it has not run yet
 
     private:
 	// some of the private data for this class is listed above
@@ -202,7 +235,13 @@ class NachOSThread {
 	void SaveUserState();		// save user-level register state
 	void RestoreUserState();		// restore user-level register state
 	void ResetReturnValue ();                           // Used by SysCall_Fork to set the return value of child to zero
+	void SkipSysCall ();                                // Resume user code after the system call
 	ProcessAddressSpace *space;			// User code this thread is running.
+	int sysCallInProgress;		// system call being handled, -1 if none
+
+	void Checkpoint(FILE *fp);	// save the thread to a checkpoint
+	void Restore(FILE *fp);		// ... and load it back, in place of
+					// the state given by the constructor
 #endif
 };
 
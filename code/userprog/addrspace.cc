@@ -173,6 +173,23 @@ ProcessAddressSpace::ProcessAddressSpace(ProcessAddressSpace *parentSpace)
     numPagesAllocated += numVirtualPages;
 }
 
+//----------------------------------------------------------------------
+// ProcessAddressSpace::ProcessAddressSpace (FILE*) is called to restore
+//      a checkpoint.  Read the page table saved by Checkpoint; the pages
+//      themselves are restored with the rest of main memory.
+//----------------------------------------------------------------------
+
+ProcessAddressSpace::ProcessAddressSpace(FILE *fp)
+{
+    fread(&numVirtualPages, sizeof(unsigned), 1, fp);
+    KernelPageTable = new TranslationEntry[numVirtualPages];
+    fread(KernelPageTable, sizeof(TranslationEntry), numVirtualPages, fp);
+
+    DEBUG('a', "Restoring address space, num pages %d, first frame %d\n",
+                                        numVirtualPages,
+                                        KernelPageTable[0].physicalPage);
+}
+
 //----------------------------------------------------------------------
 // ProcessAddressSpace::~ProcessAddressSpace
 // 	Dealloate an address space.  Nothing for now!
@@ -251,3 +268,15 @@ ProcessAddressSpace::GetPageTable()
 {
    return KernelPageTable;
 }
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::Checkpoint
+//      Write the page table to the checkpoint "fp".
+//----------------------------------------------------------------------
+
+void
+ProcessAddressSpace::Checkpoint(FILE *fp)
+{
+    fwrite(&numVirtualPages, sizeof(unsigned), 1, fp);
+    fwrite(KernelPageTable, sizeof(TranslationEntry), numVirtualPages, fp);
+}
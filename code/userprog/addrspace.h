@@ -26,6 +26,8 @@ class ProcessAddressSpace {
 
     ProcessAddressSpace (ProcessAddressSpace *parentSpace); // Used by fork
 
+    ProcessAddressSpace (FILE *fp);	// Used to restore a checkpoint
+
     ~ProcessAddressSpace();			// De-allocate an address space
 
     void InitUserModeCPURegisters();		// Initialize user-level CPU registers,
@@ -38,6 +40,8 @@ class ProcessAddressSpace {
 
     TranslationEntry* GetPageTable();
 
+    void Checkpoint(FILE *fp);		// Save the page table
+
   private:
     TranslationEntry *KernelPageTable;	// Assume linear page table translation
 					// for now!
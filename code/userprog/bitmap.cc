@@ -102,6 +102,48 @@ BitMap::Find()
     return -1;
 }
 
+//----------------------------------------------------------------------
+// BitMap::FindRun
+// 	Find a run of consecutive clear bits, and set them.  If bit
+//	"goal" is clear, the run starts there, so that it carries on from
+//	an earlier one; otherwise it is the first run of "wanted" bits or,
+//	if there is no run that long, the longest run there is.
+//
+//	Return the number of the first bit of the run, and its length in
+//	"length", at most "wanted".  If no bits are clear, return -1.
+//
+//	"goal" is the bit to start at if possible, or -1
+//	"wanted" is how many bits we would like
+//----------------------------------------------------------------------
+
+int
+BitMap::FindRun(int goal, int wanted, int *length)
+{
+    int first = -1, best = 0, start, run, i;
+
+    ASSERT(wanted > 0);
+    if (goal >= 0 && goal < numBits && !Test(goal)) {
+	first = goal;
+	for (best = 1; best < wanted && goal + best < numBits &&
+		 !Test(goal + best); best++)
+	    ;
+    } else
+	for (start = 0; start < numBits && best < wanted; start += run + 1) {
+	    for (run = 0; run < wanted && start + run < numBits &&
+		     !Test(start + run); run++)
+		;
+	    if (run > best) {
+		first = start;
+		best = run;
+	    }
+	}
+
+    for (i = 0; i < best; i++)
+	Mark(first + i);
+    *length = best;
+    return first;
+}
+
 //----------------------------------------------------------------------
 // BitMap::NumClear
 // 	Return the number of clear bits in the bitmap.
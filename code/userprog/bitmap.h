@@ -43,6 +43,10 @@ class BitMap {
     int Find();            	// Return the # of a clear bit, and as a side
 				// effect, set the bit. 
 				// If no bits are clear, return -1.
+    int FindRun(int goal, int wanted, int *length);
+				// Find and set a run of up to "wanted"
+				// clear bits, starting at "goal" if it
+				// is clear; return its first bit, or -1
     int NumClear();		// Return the number of clear bits
 
     void Print();		// Print contents of bitmap
@@ -0,0 +1,304 @@
+// checkpoint.cc
+//	Routines to checkpoint and restore a simulation.  See checkpoint.h.
+//
+//	A checkpoint file holds, in order:
+//
+//		the magic number and version
+//		the statistics (Statistics::Checkpoint)
+//		the scheduling algorithm, batch size, number of physical
+//		pages in use, pid counter and exited pids
+//		when the next timer interrupt is due
+//		the physical pages in use
+//		the live threads, each preceded by its state
+//		the sleep queue, as (pid, wake-up time) pairs
+//
+//	in host byte order; a checkpoint is only good on the host that
+//	wrote it.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "syscall.h"
+
+#define CheckpointMagic		0x4e434b50	// "NCKP"
+#define CheckpointVersion	4
+
+// What a thread was doing when the checkpoint was taken
+enum CheckpointState { CheckpointRunning, CheckpointReady,
+		       CheckpointSleeping, CheckpointBlocked };
+
+static int checkpointTime = -1;		// when to checkpoint, -1 if not
+static char *checkpointFile;		// ... and where to
+
+//----------------------------------------------------------------------
+// ScheduleCheckpoint
+// 	Arrange for a checkpoint to be written to "fileName" once the
+//	simulated clock reaches "when".
+//----------------------------------------------------------------------
+
+void
+ScheduleCheckpoint(int when, char *fileName)
+{
+    ASSERT(when >= 0);
+    checkpointTime = when;
+    checkpointFile = fileName;
+}
+
+//----------------------------------------------------------------------
+// CanCheckpoint
+// 	Return TRUE if no I/O is under way, and every thread but the
+//	running one can be restarted from its user registers: it was
+//	preempted in user code, or is in a Yield, Sleep or Join.
+//----------------------------------------------------------------------
+
+static bool
+CanCheckpoint()
+{
+    NachOSThread *thread;
+
+    if (interrupt->NextPending(ConsoleWriteInt) != -1 ||
+	interrupt->NextPending(DiskInt) != -1 ||
+	interrupt->NextPending(NetworkSendInt) != -1)
+	return FALSE;
+
+    for (unsigned pid = 0; pid < thread_index; pid++) {
+	thread = threadArray[pid];
+	if (exitThreadArray[pid] || thread == currentThread)
+	    continue;
+	if (thread->space == NULL)
+	    return FALSE;
+	switch (thread->sysCallInProgress) {
+	  case -1:
+	  case SysCall_Yield:
+	  case SysCall_Sleep:
+	  case SysCall_Join:
+	    break;
+	  default:
+	    return FALSE;
+	}
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// MaybeCheckpoint
+// 	Called by the timer interrupt handler while a user program is
+//	running.  If a checkpoint is due, and can be taken, write it.
+//----------------------------------------------------------------------
+
+void
+MaybeCheckpoint()
+{
+    FILE *fp;
+    NachOSThread *thread;
+    TimeSortedWaitQueue *ptr;
+    int magic = CheckpointMagic, version = CheckpointVersion;
+    int algo, timerWhen, state, numThreads = 0, numSleeping = 0, pid, when;
+    unsigned i;
+
+    if (checkpointTime < 0 || stats->totalTicks < checkpointTime)
+	return;
+    if (multiprocessor != NULL) {
+	printf("Checkpoints are not supported with more than one CPU.\n");
+	checkpointTime = -1;
+	return;
+    }
+    if (!CanCheckpoint())
+	return;				// try again on the next interrupt
+    checkpointTime = -1;
+
+    fp = fopen(checkpointFile, "wb");
+    if (fp == NULL) {
+	perror(checkpointFile);
+	return;
+    }
+
+    fwrite(&magic, sizeof(int), 1, fp);
+    fwrite(&version, sizeof(int), 1, fp);
+    stats->Checkpoint(fp);
+    algo = scheduler->schedAlgo;
+    fwrite(&algo, sizeof(int), 1, fp);
+    fwrite(&executableCount, sizeof(int), 1, fp);
+    fwrite(&numPagesAllocated, sizeof(unsigned), 1, fp);
+    fwrite(&thread_index, sizeof(unsigned), 1, fp);
+    fwrite(exitThreadArray, sizeof(bool), thread_index, fp);
+    timerWhen = interrupt->NextPending(TimerInt);
+    fwrite(&timerWhen, sizeof(int), 1, fp);
+    fwrite(machine->mainMemory, sizeof(char), numPagesAllocated * PageSize,
+	   fp);
+
+    for (i = 0; i < thread_index; i++)
+	if (!exitThreadArray[i])
+	    numThreads++;
+    fwrite(&numThreads, sizeof(int), 1, fp);
+    for (i = 0; i < thread_index; i++) {
+	if (exitThreadArray[i])
+	    continue;
+	thread = threadArray[i];
+	if (thread == currentThread)
+	    state = CheckpointRunning;
+	else if (thread->getStatus() == BLOCKED)
+	    state = CheckpointBlocked;	// refined below, if asleep
+	else
+	    state = CheckpointReady;
+	for (ptr = sleepQueueHead; ptr != NULL; ptr = ptr->GetNext())
+	    if (ptr->GetThread() == thread)
+		state = CheckpointSleeping;
+	fwrite(&state, sizeof(int), 1, fp);
+	thread->Checkpoint(fp);
+    }
+
+    for (ptr = sleepQueueHead; ptr != NULL; ptr = ptr->GetNext())
+	numSleeping++;
+    fwrite(&numSleeping, sizeof(int), 1, fp);
+    for (ptr = sleepQueueHead; ptr != NULL; ptr = ptr->GetNext()) {
+	pid = ptr->GetThread()->GetPID();
+	when = ptr->GetWhen();
+	fwrite(&pid, sizeof(int), 1, fp);
+	fwrite(&when, sizeof(int), 1, fp);
+    }
+
+    fclose(fp);
+    printf("Checkpoint of %d processes written to %s at tick %d\n",
+	   numThreads, checkpointFile, stats->totalTicks);
+}
+
+//----------------------------------------------------------------------
+// RestoreCheckpoint
+// 	Called by the main thread in place of launching user programs.
+//	Load the checkpoint in "fileName", recreate its threads as if
+//	they had just been forked, and hand the CPU over to them; the
+//	main thread is not part of the checkpoint, so it finishes.
+//
+//	Interrupts stay off until the first restored thread runs, so
+//	that the clock does not move while we restore it.
+//----------------------------------------------------------------------
+
+void
+RestoreCheckpoint(char *fileName)
+{
+    FILE *fp = fopen(fileName, "rb");
+    int magic = 0, version = 0;
+    int algo, timerWhen, state, numThreads, numSleeping, pid, when;
+    int numReady = 0, readySince, i, j;
+    unsigned savedThreadIndex;
+    NachOSThread **threads, **ready, *running = NULL, *thread, *nextThread;
+    TimeSortedWaitQueue *tail = NULL, *entry;
+
+    if (fp == NULL) {
+	printf("Unable to open checkpoint %s\n", fileName);
+	return;
+    }
+    fread(&magic, sizeof(int), 1, fp);
+    fread(&version, sizeof(int), 1, fp);
+    if (magic != CheckpointMagic || version != CheckpointVersion) {
+	printf("%s is not a checkpoint\n", fileName);
+	fclose(fp);
+	return;
+    }
+    if (multiprocessor != NULL) {
+	printf("Checkpoints are not supported with more than one CPU.\n");
+	fclose(fp);
+	return;
+    }
+
+    (void) interrupt->SetLevel(IntOff);
+
+    stats->Restore(fp);
+    fread(&algo, sizeof(int), 1, fp);
+    scheduler->schedAlgo = (SchedulingAlgo) algo;
+    fread(&executableCount, sizeof(int), 1, fp);
+    fread(&numPagesAllocated, sizeof(unsigned), 1, fp);
+    fread(&savedThreadIndex, sizeof(unsigned), 1, fp);
+    ASSERT(savedThreadIndex < MAX_THREAD_COUNT);
+    fread(exitThreadArray, sizeof(bool), savedThreadIndex, fp);
+    fread(&timerWhen, sizeof(int), 1, fp);
+    ASSERT(numPagesAllocated <= NumPhysPages);
+    fread(machine->mainMemory, sizeof(char), numPagesAllocated * PageSize,
+	  fp);
+
+    fread(&numThreads, sizeof(int), 1, fp);
+    threads = new NachOSThread *[numThreads];
+    ready = new NachOSThread *[numThreads];
+    for (i = 0; i < numThreads; i++) {
+	fread(&state, sizeof(int), 1, fp);
+	thread = new NachOSThread("restored");	// Restore sets the name
+	thread->Restore(fp);
+	threads[i] = thread;
+
+	// Finish what the thread's system call would have done; a Join
+	// is simply made again.
+	if (thread->sysCallInProgress == SysCall_Yield ||
+	    thread->sysCallInProgress == SysCall_Sleep)
+	    thread->SkipSysCall();
+	thread->sysCallInProgress = -1;
+	thread->CreateThreadStack(ForkStartFunction, 0);
+
+	if (state == CheckpointRunning)
+	    running = thread;
+	else if (state == CheckpointReady) {
+	    // Keep the ready queue in the order the threads joined it.
+	    for (j = numReady; j > 0 &&
+		     ready[j - 1]->statistics->getWaitStartTime() >
+		     thread->statistics->getWaitStartTime(); j--)
+		ready[j] = ready[j - 1];
+	    ready[j] = thread;
+	    numReady++;
+	} else
+	    thread->setStatus(BLOCKED);	// woken by the sleep queue, or
+					// by the child it joins
+    }
+
+    // The new threads were given fresh pids; replace them with the
+    // saved ones.
+    for (i = 0; i < MAX_THREAD_COUNT; i++)
+	threadArray[i] = NULL;
+    for (i = 0; i < numThreads; i++)
+	threadArray[threads[i]->GetPID()] = threads[i];
+    thread_index = savedThreadIndex;
+
+    fread(&numSleeping, sizeof(int), 1, fp);
+    sleepQueueHead = NULL;
+    for (i = 0; i < numSleeping; i++) {		// saved in order
+	fread(&pid, sizeof(int), 1, fp);
+	fread(&when, sizeof(int), 1, fp);
+	ASSERT(threadArray[pid] != NULL);
+	entry = new TimeSortedWaitQueue(threadArray[pid], when);
+	if (tail == NULL)
+	    sleepQueueHead = entry;
+	else
+	    tail->SetNext(entry);
+	tail = entry;
+    }
+    fclose(fp);
+
+    if (timerWhen > stats->totalTicks)
+	interrupt->Reschedule(TimerInt, timerWhen);
+
+    // The interrupted thread goes first, then the others, each keeping
+    // the time it started waiting.
+    if (running != NULL)
+	running->Schedule();
+    for (i = 0; i < numReady; i++) {
+	readySince = ready[i]->statistics->getWaitStartTime();
+	ready[i]->Schedule();
+	ready[i]->statistics->setWaitStartTime(readySince);
+    }
+    delete [] threads;
+    delete [] ready;
+
+    printf("Restored %d processes from %s at tick %d\n", numThreads,
+	   fileName, stats->totalTicks);
+
+    // Switch away for good, without charging the main thread for a CPU
+    // burst, which would disturb the restored statistics.
+    threadToBeDestroyed = currentThread;
+    currentThread->setStatus(BLOCKED);
+    while ((nextThread = scheduler->SelectNextReadyThread()) == NULL)
+	interrupt->Idle();
+    scheduler->ScheduleThread(nextThread);
+    ASSERT(FALSE);			// not reached
+}
@@ -0,0 +1,47 @@
+// checkpoint.h
+//	Routines to save the state of a simulation to a file, and to start
+//	another simulation from that state instead of from tick 0.
+//
+//	"-ckpt <tick> <file>" writes a checkpoint at the first timer
+//	interrupt at or after <tick> that finds a user program running;
+//	the simulation then goes on as if nothing happened.
+//	"-restore <file>" starts from the checkpoint: the clock, the
+//	statistics, main memory, and every live process, with its pid,
+//	children, registers, page table, scheduling parameters and
+//	place in the ready or sleep queue.
+//
+//	Kernel stacks cannot be saved, so a restored process is
+//	restarted like a forked one, from its user registers.  That only
+//	works if every process is in user code or blocked in a system
+//	call that can be resumed from the outside: Yield and Sleep are
+//	completed, Join is made again.  Until that is so (for instance,
+//	while a process waits for the console), and while any disk or
+//	network I/O is under way, the checkpoint is put off to a later
+//	timer interrupt.
+//
+//	Not saved: the state of the profiler, tracer and caches, the
+//	system call counts, the burst predictors (they restart from the
+//	saved guesses), the adaptive quantum, and the random number
+//	generator.  The restored ready queue is in the order the threads
+//	became ready, with the interrupted thread first.  Checkpoints are
+//	not supported with "-ncpu".
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "copyright.h"
+
+extern void ScheduleCheckpoint(int when, char *fileName);
+				// Write a checkpoint to "fileName" at
+				// tick "when"
+extern void MaybeCheckpoint();	// Called on timer interrupts in user
+				// mode; write the checkpoint if it is time
+extern void RestoreCheckpoint(char *fileName);
+				// Continue the simulation saved in
+				// "fileName"; does not return
+
+#endif // CHECKPOINT_H
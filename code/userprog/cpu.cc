@@ -0,0 +1,666 @@
+// cpu.cc
+//	Routines to simulate a shared-memory multiprocessor, by taking
+//	turns at simulating each CPU.  See cpu.h for the overall scheme.
+//
+// 	These routines assume that interrupts are already disabled.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "cpu.h"
+#include "system.h"
+
+#include <pthread.h>
+
+// State shared with the host threads that run parallel epochs.  Only
+// written by the kernel's host thread while the others wait at
+// epochStart.
+
+static pthread_barrier_t epochStart;	// all host threads begin an epoch
+static pthread_barrier_t epochDone;	// ... and all have finished it
+static CPU *epochCPUs[MaxCPUs];		// CPUs running in this epoch
+static int epochSize;			// number of entries in epochCPUs
+static int epochEnd;			// time at which the epoch ends
+
+//----------------------------------------------------------------------
+// IdleLoop
+// 	The body of each CPU's idle thread: run whatever becomes ready on
+//	this CPU, and otherwise leave the host to the other CPUs.
+//
+//	The idle thread runs with interrupts disabled, so that it never
+//	takes a time slice; it only gives up the CPU by switching to a
+//	ready thread (its own, or one stolen from a busy CPU), or to
+//	another CPU.
+//
+//	"which" is the CPU, for debugging.
+//----------------------------------------------------------------------
+
+static void
+IdleLoop(int which)
+{
+    NachOSThread *nextThread;
+
+    currentThread->Startup();	// clean up after whoever ran before us
+    (void) interrupt->SetLevel(IntOff);
+    DEBUG('t', "Idle thread of CPU %d starting\n", which);
+
+    for (;;) {
+	nextThread = scheduler->SelectNextReadyThread();
+	if (nextThread == NULL)
+	    nextThread = multiprocessor->Steal();
+	if (nextThread != NULL)
+	    scheduler->ScheduleThread(nextThread);
+	else
+	    multiprocessor->Idle();
+    }
+}
+
+//----------------------------------------------------------------------
+// RunUserCode
+// 	Execute the user program running on "cpu" until its clock reaches
+//	"until", or it traps.  Called on any host thread, during an epoch;
+//	touches only the CPU's own machine, thread and clock.
+//----------------------------------------------------------------------
+
+static void
+RunUserCode(CPU *cpu, int until)
+{
+    Instruction instr;
+
+    while ((cpu->ticks < until) && !cpu->machine->HasDeferredException()) {
+	cpu->currentThread->IncInstructionCount();
+	cpu->machine->OneInstruction(&instr);
+	cpu->ticks += UserTick;
+    }
+}
+
+//----------------------------------------------------------------------
+// EpochWorker
+// 	The body of each host thread that helps run parallel epochs.
+//	Worker "which" runs the which'th CPU of each epoch, if there is
+//	one; the kernel's own host thread runs the first.
+//----------------------------------------------------------------------
+
+static void *
+EpochWorker(void *which)
+{
+    for (;;) {
+	pthread_barrier_wait(&epochStart);
+	if ((long) which < epochSize)
+	    RunUserCode(epochCPUs[(long) which], epochEnd);
+	pthread_barrier_wait(&epochDone);
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// CPU::CPU
+// 	Initialize the saved state of a simulated CPU.  The Multiprocessor
+//	fills in the machine, scheduler and threads.
+//
+//	"which" is the index of the CPU.
+//----------------------------------------------------------------------
+
+CPU::CPU(int which)
+{
+    id = which;
+    machine = NULL;
+    scheduler = NULL;
+    currentThread = NULL;
+    idleThread = NULL;
+    status = SystemMode;
+    yieldPending = FALSE;
+    ticks = stats->totalTicks;
+    idleTicks = 0;
+    numDispatches = 0;
+    numSteals = 0;
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::Multiprocessor
+// 	Turn the machine we are running on into CPU 0 of a multiprocessor,
+//	and add "howMany" - 1 more CPUs, which share its physical memory.
+//	The new CPUs start out running their idle threads.
+//
+//	The idle threads never exit, so they are marked as exited right
+//	away, so as not to hold up the end of the simulation.
+//
+//	"howMany" is the total number of CPUs.
+//	"debug" -- if TRUE, single-step user programs on every CPU.
+//	"steal" -- if TRUE, idle CPUs steal ready threads from busy ones.
+//	"epoch" -- if non-zero, run user code on parallel host threads,
+//		in epochs of this many ticks.
+//----------------------------------------------------------------------
+
+Multiprocessor::Multiprocessor(int howMany, bool debug, bool steal, int epoch)
+{
+    CPU *cpu;
+    pthread_t worker;
+
+    ASSERT((howMany > 1) && (howMany <= MaxCPUs));
+    numCPUs = howMany;
+    active = 0;
+    numSwitches = 0;
+    workStealing = steal;
+    epochTicks = epoch;
+    numEpochs = 0;
+
+    for (int i = 0; i < numCPUs; i++) {
+	cpu = new CPU(i);
+	if (i == 0) {
+	    cpu->machine = machine;
+	    cpu->scheduler = scheduler;
+	} else {
+	    cpu->machine = new Machine(debug, machine->mainMemory);
+	    cpu->scheduler = new ProcessScheduler();
+	}
+	cpu->idleThread = new NachOSThread("idle");
+	cpu->idleThread->CreateThreadStack(IdleLoop, i);
+	exitThreadArray[cpu->idleThread->GetPID()] = true;
+	cpu->currentThread = (i == 0) ? currentThread : cpu->idleThread;
+	cpus[i] = cpu;
+    }
+
+    // The workers are never stopped; they wait at epochStart until
+    // Nachos exits.
+    if (epochTicks > 0) {
+	pthread_barrier_init(&epochStart, NULL, numCPUs);
+	pthread_barrier_init(&epochDone, NULL, numCPUs);
+	for (long i = 1; i < numCPUs; i++) {
+	    ASSERT(pthread_create(&worker, NULL, EpochWorker, (void *) i) == 0);
+	    pthread_detach(worker);
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::~Multiprocessor
+// 	De-allocate the CPUs we added.  The globals are pointed back at
+//	CPU 0, whose machine and scheduler are deleted by Cleanup.
+//
+//	The idle threads are not deleted, since we may be running on one.
+//----------------------------------------------------------------------
+
+Multiprocessor::~Multiprocessor()
+{
+    machine = cpus[0]->machine;
+    scheduler = cpus[0]->scheduler;
+    for (int i = 0; i < numCPUs; i++) {
+	if (i > 0) {
+	    delete cpus[i]->machine;
+	    delete cpus[i]->scheduler;
+	}
+	delete cpus[i];
+    }
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::Clock, Running
+// 	The local time and the running thread of "cpu".  The saved copies
+//	in the CPU object are stale while it is the CPU being simulated.
+//----------------------------------------------------------------------
+
+int
+Multiprocessor::Clock(CPU *cpu)
+{
+    return (cpu->id == active) ? stats->totalTicks : cpu->ticks;
+}
+
+NachOSThread *
+Multiprocessor::Running(CPU *cpu)
+{
+    return (cpu->id == active) ? currentThread : cpu->currentThread;
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::IsRunnable
+// 	Return TRUE if "cpu" is running a thread, or has one ready to run,
+//	or is idle and could steal one.
+//----------------------------------------------------------------------
+
+bool
+Multiprocessor::IsRunnable(CPU *cpu)
+{
+    if (Running(cpu) != cpu->idleThread)
+	return TRUE;
+    if (cpu->scheduler->NumReady() > 0)
+	return TRUE;
+    return (workStealing && (PickVictim(cpu) != NULL));
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::PickVictim
+// 	Return the CPU an idle "thief" should steal a thread from: the most
+//	loaded CPU that is busy running a thread and has a thread ready that
+//	can move (the lowest index on a tie), or NULL if there is none.
+//----------------------------------------------------------------------
+
+CPU *
+Multiprocessor::PickVictim(CPU *thief)
+{
+    CPU *victim = NULL;
+    CPU *cpu;
+
+    for (int i = 0; i < numCPUs; i++) {
+	cpu = cpus[i];
+	if ((cpu == thief) || (Running(cpu) == cpu->idleThread) ||
+	    !cpu->scheduler->HasMigratableThread())
+	    continue;
+	if ((victim == NULL) || (Load(cpu) > Load(victim)))
+	    victim = cpu;
+    }
+    return victim;
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::Load
+// 	The number of threads running or ready on "cpu".
+//----------------------------------------------------------------------
+
+int
+Multiprocessor::Load(CPU *cpu)
+{
+    return cpu->scheduler->NumReady() +
+	   ((Running(cpu) != cpu->idleThread) ? 1 : 0);
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::PickNext
+// 	Return the runnable CPU with the earliest clock, the one with the
+//	lowest index on a tie, or NULL if no CPU is runnable.
+//----------------------------------------------------------------------
+
+CPU *
+Multiprocessor::PickNext()
+{
+    CPU *best = NULL;
+
+    for (int i = 0; i < numCPUs; i++) {
+	if (!IsRunnable(cpus[i]))
+	    continue;
+	if ((best == NULL) || (Clock(cpus[i]) < Clock(best)))
+	    best = cpus[i];
+    }
+    return best;
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::SwitchTo
+// 	Save the state of the CPU being simulated, and switch to simulating
+//	"next" instead.  Returns when some CPU switches back to this one.
+//
+//	A CPU that was idle did not advance its clock; it has been idle
+//	until now.
+//----------------------------------------------------------------------
+
+void
+Multiprocessor::SwitchTo(CPU *next)
+{
+    CPU *cpu = cpus[active];
+
+    ASSERT(interrupt->getLevel() == IntOff);
+    ASSERT(next != cpu);
+
+    cpu->ticks = stats->totalTicks;
+    cpu->currentThread = currentThread;
+    cpu->status = interrupt->getStatus();
+    cpu->yieldPending = interrupt->getYieldOnReturn();
+
+    // An idle thread that has just started may get here before it
+    // has had a chance to delete the thread that finished before it.
+    if ((threadToBeDestroyed != NULL) && (threadToBeDestroyed != currentThread)) {
+	delete threadToBeDestroyed;
+	threadToBeDestroyed = NULL;
+    }
+
+    if ((next->currentThread == next->idleThread) &&
+	(next->ticks < stats->totalTicks)) {
+	next->idleTicks += stats->totalTicks - next->ticks;
+	stats->idleTicks += stats->totalTicks - next->ticks;
+	next->ticks = stats->totalTicks;
+    }
+
+    DEBUG('t', "Switching from CPU %d at time %d to CPU %d at time %d\n",
+	  cpu->id, cpu->ticks, next->id, next->ticks);
+
+    active = next->id;
+    numSwitches++;
+    stats->totalTicks = next->ticks;
+    machine = next->machine;
+    scheduler = next->scheduler;
+    currentThread = next->currentThread;
+    interrupt->setStatus(next->status);
+    interrupt->setYieldOnReturn(next->yieldPending);
+
+    _SWITCH(cpu->currentThread, next->currentThread);
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::MaybeSwitch
+// 	Called with interrupts disabled each time the current CPU's clock
+//	advances.  If another runnable CPU has fallen InterleaveTicks
+//	behind, simulate it until it catches up.
+//
+//	In parallel mode, if we are running user code, first try to run
+//	an epoch.
+//----------------------------------------------------------------------
+
+void
+Multiprocessor::MaybeSwitch()
+{
+    CPU *next;
+
+    if ((epochTicks > 0) && (interrupt->getStatus() == UserMode))
+	RunEpoch();
+
+    next = PickNext();
+
+    if ((next == NULL) || (next->id == active))
+	return;
+    if (stats->totalTicks - Clock(next) < InterleaveTicks)
+	return;
+    SwitchTo(next);
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::CanRunInParallel
+// 	Return TRUE if "cpu" (whose state must be saved) is stopped between
+//	two user instructions, with no time slice or trap to be taken
+//	first, so that its user program can be run on any host thread.
+//----------------------------------------------------------------------
+
+bool
+Multiprocessor::CanRunInParallel(CPU *cpu)
+{
+    return (cpu->currentThread != cpu->idleThread) &&
+	   (cpu->status == UserMode) && !cpu->yieldPending &&
+	   !cpu->machine->HasDeferredException();
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::RunEpoch
+// 	Called by MaybeSwitch, between two user instructions on the
+//	current CPU.  If no runnable CPU is behind us, run every CPU that
+//	is in user code for epochTicks, on the worker host threads and on
+//	this one.  This is only worth it if at least two CPUs take part.
+//
+//	CPUs that trapped keep the trap pending; the time slice they may
+//	be owed waits until they have taken it, so that the trap is taken
+//	by the thread that caused it, on this CPU.
+//----------------------------------------------------------------------
+
+void
+Multiprocessor::RunEpoch()
+{
+    CPU *cpu = cpus[active];
+    CPU *next = PickNext();
+    int startTicks[MaxCPUs];
+    int i;
+
+    if ((next != NULL) && (Clock(next) < stats->totalTicks))
+	return;
+
+    cpu->ticks = stats->totalTicks;
+    cpu->currentThread = currentThread;
+    cpu->status = interrupt->getStatus();
+    cpu->yieldPending = interrupt->getYieldOnReturn();
+    if (!CanRunInParallel(cpu))
+	return;
+
+    epochSize = 0;
+    for (i = 0; i < numCPUs; i++)
+	if (CanRunInParallel(cpus[i]))
+	    epochCPUs[epochSize++] = cpus[i];
+    if (epochSize < 2)
+	return;
+
+    epochEnd = stats->totalTicks + epochTicks;
+    DEBUG('t', "Running %d CPUs in parallel until time %d\n", epochSize,
+	  epochEnd);
+    for (i = 0; i < epochSize; i++) {
+	startTicks[i] = epochCPUs[i]->ticks;
+	epochCPUs[i]->machine->deferExceptions = TRUE;
+    }
+
+    pthread_barrier_wait(&epochStart);
+    RunUserCode(epochCPUs[0], epochEnd);
+    pthread_barrier_wait(&epochDone);
+
+    for (i = 0; i < epochSize; i++) {
+	epochCPUs[i]->machine->deferExceptions = FALSE;
+	stats->userTicks += epochCPUs[i]->ticks - startTicks[i];
+    }
+    numEpochs++;
+    stats->totalTicks = cpu->ticks;
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::Idle
+// 	Called by the idle thread when its CPU has nothing to run.
+//	Simulate some other CPU that does.
+//
+//	If no CPU has anything to run, every CPU is waiting for an
+//	interrupt.  Bring our clock up to the latest one, since the other
+//	CPUs have already been idle until then, and let the interrupt
+//	simulation advance time to the next interrupt.
+//----------------------------------------------------------------------
+
+void
+Multiprocessor::Idle()
+{
+    CPU *next = PickNext();
+    CPU *cpu = cpus[active];
+    int latest = stats->totalTicks;
+    int before;
+
+    if (next == cpu)		// something became ready here after all
+	return;
+    if (next != NULL) {
+	SwitchTo(next);
+	return;
+    }
+
+    for (int i = 0; i < numCPUs; i++)
+	if (cpus[i]->ticks > latest)
+	    latest = cpus[i]->ticks;
+    cpu->idleTicks += latest - stats->totalTicks;
+    stats->idleTicks += latest - stats->totalTicks;
+    stats->totalTicks = latest;
+
+    before = stats->totalTicks;
+    interrupt->Idle();
+    cpu->idleTicks += stats->totalTicks - before;
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::IdleThread
+// 	Return the idle thread of the current CPU, for a thread that blocks
+//	with nothing else ready.  A pending time slice is moot.
+//----------------------------------------------------------------------
+
+NachOSThread *
+Multiprocessor::IdleThread()
+{
+    interrupt->setYieldOnReturn(FALSE);
+    return cpus[active]->idleThread;
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::Steal
+// 	Called by the idle thread when its own ready list is empty.  Take
+//	the thread at the back of a busy CPU's ready list -- the one that
+//	CPU would run last -- and return it, to be run here.
+//
+//	Returns NULL if work stealing is off, or there is nothing to steal.
+//----------------------------------------------------------------------
+
+NachOSThread *
+Multiprocessor::Steal()
+{
+    CPU *cpu = cpus[active];
+    CPU *victim;
+    NachOSThread *thread;
+
+    if (!workStealing)
+	return NULL;
+    victim = PickVictim(cpu);
+    if (victim == NULL)
+	return NULL;
+
+    thread = victim->scheduler->RemoveThreadForMigration();
+    ASSERT(thread != NULL);
+    DEBUG('t', "CPU %d stealing thread %d from CPU %d\n", cpu->id,
+	  thread->GetPID(), victim->id);
+    stats->numSteals++;
+    cpu->numSteals++;
+
+    // Go through our own ready list, which is empty, so that the
+    // thread is set up for this CPU exactly as a migrated one would be.
+    scheduler->AddMigratedThread(thread);
+    return scheduler->SelectNextReadyThread();
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::IsIdleThread
+// 	Return TRUE if "thread" is the idle thread of some CPU.
+//----------------------------------------------------------------------
+
+bool
+Multiprocessor::IsIdleThread(NachOSThread *thread)
+{
+    for (int i = 0; i < numCPUs; i++)
+	if (cpus[i]->idleThread == thread)
+	    return TRUE;
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::Dispatch
+// 	Called by ProcessScheduler::ScheduleThread once "thread" runs on
+//	the current CPU.  Counts a migration if it last ran on another one.
+//
+//	Returns FALSE for the idle thread, which never waits in a ready
+//	list and so must not count towards the waiting time statistics.
+//----------------------------------------------------------------------
+
+bool
+Multiprocessor::Dispatch(NachOSThread *thread)
+{
+    if (thread == cpus[active]->idleThread)
+	return FALSE;
+
+    if ((thread->lastCPU >= 0) && (thread->lastCPU != active)) {
+	DEBUG('t', "Thread %d migrated from CPU %d to CPU %d\n",
+	      thread->GetPID(), thread->lastCPU, active);
+	stats->numMigrations++;
+    }
+    thread->lastCPU = active;
+    cpus[active]->numDispatches++;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::TimerTick
+// 	Called from the timer interrupt handler, which takes care of the
+//	current CPU.  The timer interrupts all CPUs at once, so decide
+//	whether the threads running on the other CPUs should be
+//	preempted; they will yield once they are simulated again.
+//
+//	A thread with a trap pending from a parallel epoch is left alone
+//	until it has taken the trap (see RunEpoch).
+//
+//	Then even out the load.
+//----------------------------------------------------------------------
+
+void
+Multiprocessor::TimerTick()
+{
+    CPU *cpu;
+    int ranFor;
+
+    for (int i = 0; i < numCPUs; i++) {
+	cpu = cpus[i];
+	if ((i == active) || (cpu->currentThread == cpu->idleThread) ||
+	    cpu->machine->HasDeferredException())
+	    continue;
+	ranFor = cpu->ticks -
+		 cpu->currentThread->statistics->getBurstStartTime();
+	if (cpu->scheduler->ShouldPreempt(cpu->currentThread, ranFor))
+	    cpu->yieldPending = TRUE;
+    }
+    Balance();
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::Balance
+// 	Move ready threads from the most loaded CPU to the least loaded
+//	one, until their loads differ by at most one thread (or nothing
+//	more can be moved).  Ties go to the lowest CPU index, which keeps
+//	the result repeatable.
+//----------------------------------------------------------------------
+
+void
+Multiprocessor::Balance()
+{
+    CPU *busiest, *idlest;
+    NachOSThread *thread;
+
+    for (;;) {
+	busiest = idlest = cpus[0];
+	for (int i = 1; i < numCPUs; i++) {
+	    if (Load(cpus[i]) > Load(busiest))
+		busiest = cpus[i];
+	    if (Load(cpus[i]) < Load(idlest))
+		idlest = cpus[i];
+	}
+	if (Load(busiest) - Load(idlest) < 2)
+	    return;
+
+	thread = busiest->scheduler->RemoveThreadForMigration();
+	if (thread == NULL)
+	    return;
+	DEBUG('t', "Balancing thread %d from CPU %d to CPU %d\n",
+	      thread->GetPID(), busiest->id, idlest->id);
+	idlest->scheduler->AddMigratedThread(thread);
+	stats->numLoadBalances++;
+    }
+}
+
+//----------------------------------------------------------------------
+// Multiprocessor::Print
+// 	Print per-CPU statistics, when the machine halts.  The simulation
+//	ends when the last CPU's clock does, so CPUs that are idle are
+//	brought up to date first, and the halt time is the latest clock.
+//----------------------------------------------------------------------
+
+void
+Multiprocessor::Print()
+{
+    int latest = stats->totalTicks;
+    CPU *cpu;
+
+    cpus[active]->ticks = stats->totalTicks;
+    cpus[active]->currentThread = currentThread;
+    for (int i = 0; i < numCPUs; i++)
+	if (cpus[i]->ticks > latest)
+	    latest = cpus[i]->ticks;
+
+    printf("Simulated CPUs: %d, switches between them: %d\n", numCPUs,
+	   numSwitches);
+    if (epochTicks > 0)
+	printf("Parallel epochs of %d ticks: %d\n", epochTicks, numEpochs);
+    for (int i = 0; i < numCPUs; i++) {
+	cpu = cpus[i];
+	if ((cpu->currentThread == cpu->idleThread) && (cpu->ticks < latest)) {
+	    cpu->idleTicks += latest - cpu->ticks;
+	    stats->idleTicks += latest - cpu->ticks;
+	    cpu->ticks = latest;
+	}
+	printf("CPU %d: clock %d, busy %d, idle %d, dispatches %d, "
+	       "steals %d\n", i, cpu->ticks, cpu->ticks - cpu->idleTicks,
+	       cpu->idleTicks, cpu->numDispatches, cpu->numSteals);
+    }
+    stats->totalTicks = latest;
+}
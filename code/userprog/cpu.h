@@ -0,0 +1,123 @@
+// cpu.h
+//	Data structures to simulate a shared-memory multiprocessor.
+//
+//	Each simulated CPU has its own register file (a Machine sharing
+//	physical memory with the others), its own running thread and its
+//	own ready list (a ProcessScheduler).  The globals "machine",
+//	"scheduler" and "currentThread" always refer to the CPU that is
+//	being simulated at the moment.
+//
+//	Nachos itself is still a single host thread, so the CPUs take
+//	turns.  Each CPU keeps a clock of its own, and we always run the
+//	CPU whose clock is furthest behind, switching whenever it gets
+//	more than InterleaveTicks ahead of another runnable CPU.  The
+//	choice depends only on simulated time, so runs are repeatable.
+//	Switches happen only at the points where a uniprocessor could
+//	take a time slice (see Interrupt::OneTick).
+//
+//	A CPU with nothing to run switches to its idle thread; when no
+//	CPU has anything to run, time advances to the next interrupt.
+//	Threads made ready go onto the ready list of whichever CPU made
+//	them ready; the load balancer, run on each timer interrupt, moves
+//	threads from busy CPUs to idle ones.
+//
+//	With work stealing (the default), an idle CPU does not wait for
+//	the balancer: as soon as a busy CPU has a thread ready, the idle
+//	CPU takes it from the back of that CPU's ready list.
+//
+//	Optionally ("-P"), the user programs running on different CPUs are
+//	simulated on separate host threads.  Once the CPUs' clocks have
+//	caught up with each other, every CPU that is running user code
+//	executes up to epochTicks of instructions, all at the same time.
+//	User programs do not share memory, so this needs no locking.  A
+//	CPU that traps stops early; the trap is taken when the CPU is next
+//	simulated as usual, so the kernel is only ever entered by one host
+//	thread.  Interrupts that come due during an epoch are delivered at
+//	its end.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CPU_H
+#define CPU_H
+
+#include "copyright.h"
+#include "thread.h"
+#include "scheduler.h"
+#include "interrupt.h"
+#include "machine.h"
+
+#define MaxCPUs 	16	// largest supported "-ncpu"
+#define InterleaveTicks	20	// how far one CPU's clock may run ahead
+				// of another runnable CPU's
+
+// The following class defines the state of one simulated CPU, saved
+// while some other CPU is being simulated.  The internal data
+// structures are left public to make it simpler to manipulate.
+
+class CPU {
+  public:
+    CPU(int which);		// initialize an (unused) CPU
+
+    int id;			// index in Multiprocessor::cpus
+    Machine *machine;		// registers (memory is shared)
+    ProcessScheduler *scheduler; // this CPU's ready list
+    NachOSThread *currentThread; // the thread running on this CPU
+    NachOSThread *idleThread;	// runs when the ready list is empty
+    MachineStatus status;	// user or kernel mode
+    bool yieldPending;		// time slice requested by the timer
+    int ticks;			// local clock
+    int idleTicks;		// time spent idle
+    int numDispatches;		// number of threads dispatched here
+    int numSteals;		// number of threads stolen by this CPU
+};
+
+// The following class defines the multiprocessor: the set of CPUs and
+// the routines that choose which one runs next.
+
+class Multiprocessor {
+  public:
+    Multiprocessor(int howMany, bool debug, bool steal, int epoch);
+				// Add CPUs to the one already running
+    ~Multiprocessor();		// De-allocate all but the first CPU
+
+    void MaybeSwitch();		// Let a CPU that is behind catch up;
+				// called by Interrupt::OneTick
+    void Idle();		// Nothing to run here; run another CPU,
+				// or wait for an interrupt
+    NachOSThread *IdleThread();	// The current CPU's idle thread
+    NachOSThread *Steal();	// A ready thread of a busy CPU, for the
+				// current (idle) CPU; NULL if none
+    bool IsIdleThread(NachOSThread *thread);
+    bool Dispatch(NachOSThread *thread);
+				// Called when "thread" is scheduled;
+				// FALSE if it is an idle thread
+    void TimerTick();		// Time slices for the other CPUs, and
+				// load balancing
+    void Print();		// Print per-CPU statistics
+
+  private:
+    CPU *cpus[MaxCPUs];
+    int numCPUs;
+    int active;			// the CPU being simulated
+    int numSwitches;		// number of times we changed CPUs
+    bool workStealing;		// do idle CPUs steal ready threads?
+    int epochTicks;		// length of a parallel epoch, 0 if the
+				// CPUs are only simulated one at a time
+    int numEpochs;		// number of parallel epochs run
+
+    int Clock(CPU *cpu);	// "cpu"'s current time
+    NachOSThread *Running(CPU *cpu);	// ... and current thread
+    bool IsRunnable(CPU *cpu);	// does "cpu" have anything to run?
+    int Load(CPU *cpu);		// running plus ready threads
+    CPU *PickVictim(CPU *thief); // the CPU "thief" should steal from
+    CPU *PickNext();		// the runnable CPU furthest behind
+    void SwitchTo(CPU *next);	// simulate "next" from now on
+    void Balance();		// even out the ready lists
+    bool CanRunInParallel(CPU *cpu);	// is "cpu" in the middle
+				// of user code, with nothing pending?
+    void RunEpoch();		// run user code on all CPUs at once
+};
+
+#endif // CPU_H
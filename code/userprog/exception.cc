@@ -48,6 +48,12 @@
 //
 //	"which" is the kind of exception.  The list of possible exceptions 
 //	are in machine.h.
+//
+//	Each system call has a handler, found by indexing sysCallTable
+//	with the call code.  Every call is counted, globally and per
+//	process, together with the ticks from entering the kernel to
+//	returning to the user program (including any time spent blocked);
+//	PrintSysCallStats prints the totals when Nachos halts.
 //----------------------------------------------------------------------
 static Semaphore *readAvail;
 static Semaphore *writeDone;
@@ -79,239 +85,425 @@ static void ConvertIntToHex (unsigned v, Console *console)
    }
 }
 
-void
-ExceptionHandler(ExceptionType which)
+//----------------------------------------------------------------------
+// AdvancePC
+// 	Move the program counters past the syscall instruction, so that
+//	the user program resumes after it.
+//----------------------------------------------------------------------
+
+static void
+AdvancePC()
 {
-    int type = machine->ReadRegister(2);
-    int memval, vaddr, printval, tempval, exp;
-    unsigned printvalus;        // Used for printing in hex
-    if (!initializedConsoleSemaphores) {
-       readAvail = new Semaphore("read avail", 0);
-       writeDone = new Semaphore("write done", 1);
-       initializedConsoleSemaphores = true;
-    }
-    Console *console = new Console(NULL, NULL, ReadAvail, WriteDone, 0);;
-    int exitcode;               // Used in SysCall_Exit
+    machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
+    machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
+    machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+}
+
+static Console *console;	// for the Print* system calls, created
+				// at the first system call
+
+//----------------------------------------------------------------------
+// System call handlers, one per call code.  Arguments are in r4..r7,
+// and the result, if any, goes in r2.
+//----------------------------------------------------------------------
+
+static void
+SysCallHalt()
+{
+    DEBUG('a', "Shutdown, initiated by user program.\n");
+    interrupt->Halt();
+}
+
+static void
+SysCallExit()
+{
+    int exitcode = machine->ReadRegister(4);
     unsigned i;
-    char buffer[1024];          // Used in SysCall_Exec
-    int waitpid;                // Used in SysCall_Join
-    int whichChild;             // Used in SysCall_Join
-    NachOSThread *child;              // Used by SysCall_Fork
-    unsigned sleeptime;         // Used by SysCall_Sleep
-
-    if ((which == SyscallException) && (type == SysCall_Halt)) {
-	DEBUG('a', "Shutdown, initiated by user program.\n");
-   	interrupt->Halt();
-    }
-    else if ((which == SyscallException) && (type == SysCall_Exit)) {
-       exitcode = machine->ReadRegister(4);
-       printf("[pid %d]: Exit called. Code: %d\n", currentThread->GetPID(), exitcode);
-       // We do not wait for the children to finish.
-       // The children will continue to run.
-       // We will worry about this when and if we implement signals.
-       exitThreadArray[currentThread->GetPID()] = true;
-
-       // Find out if all threads have called exit
-       for (i=0; i<thread_index; i++) {
-          if (!exitThreadArray[i]) break;
-       }
-       currentThread->Exit(i==thread_index, exitcode);
+
+    printf("[pid %d]: Exit called. Code: %d\n", currentThread->GetPID(), exitcode);
+    // We do not wait for the children to finish.
+    // The children will continue to run.
+    // We will worry about this when and if we implement signals.
+    exitThreadArray[currentThread->GetPID()] = true;
+    if (profiler != NULL)
+       profiler->ExitProcess(currentThread->GetPID());
+
+    // Find out if all threads have called exit
+    for (i=0; i<thread_index; i++) {
+       if (!exitThreadArray[i]) break;
     }
-    else if ((which == SyscallException) && (type == SysCall_Exec)) {
-       // Copy the executable name into kernel space
-       vaddr = machine->ReadRegister(4);
-       machine->ReadMem(vaddr, 1, &memval);
-       i = 0;
-       while ((*(char*)&memval) != '\0') {
-          buffer[i] = (*(char*)&memval);
-          i++;
-          vaddr++;
-          machine->ReadMem(vaddr, 1, &memval);
-       }
+    currentThread->Exit(i==thread_index, exitcode);
+}
+
+static void
+SysCallExec()
+{
+    int memval, vaddr;
+    unsigned i;
+    char buffer[1024];
+
+    // Copy the executable name into kernel space
+    vaddr = machine->ReadRegister(4);
+    machine->ReadMem(vaddr, 1, &memval);
+    i = 0;
+    while ((*(char*)&memval) != '\0') {
        buffer[i] = (*(char*)&memval);
-       LaunchUserProcess(buffer);
-    }
-    else if ((which == SyscallException) && (type == SysCall_Join)) {
-       waitpid = machine->ReadRegister(4);
-       // Check if this is my child. If not, return -1.
-       whichChild = currentThread->CheckIfChild (waitpid);
-       if (whichChild == -1) {
-          printf("[pid %d] Cannot join with non-existent child [pid %d].\n", currentThread->GetPID(), waitpid);
-          machine->WriteRegister(2, -1);
-          // Advance program counters.
-          machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-          machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-          machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-       }
-       else {
-          exitcode = currentThread->JoinWithChild (whichChild);
-          machine->WriteRegister(2, exitcode);
-          // Advance program counters.
-          machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-          machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-          machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-       }
-    }
-    else if ((which == SyscallException) && (type == SysCall_Create)) {
-    }
-    else if ((which == SyscallException) && (type == SysCall_Open)) {
-    }
-    else if ((which == SyscallException) && (type == SysCall_Read)) {
-    }
-    else if ((which == SyscallException) && (type == SysCall_Write)) {
-    }
-    else if ((which == SyscallException) && (type == SysCall_Close)) {
+       i++;
+       vaddr++;
+       machine->ReadMem(vaddr, 1, &memval);
     }
-    else if ((which == SyscallException) && (type == SysCall_Fork)) {
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-
-       child = new NachOSThread("Forked thread");
-       child->space = new ProcessAddressSpace (currentThread->space);  // Duplicates the address space
-       child->SaveUserState ();                               // Duplicate the register set
-       child->ResetReturnValue ();                           // Sets the return register to zero
-       child->CreateThreadStack (ForkStartFunction, 0);     // Make it ready for a later context switch
-       child->Schedule ();
-       machine->WriteRegister(2, child->GetPID());              // Return value for parent
+    buffer[i] = (*(char*)&memval);
+    LaunchUserProcess(buffer);
+}
+
+static void
+SysCallJoin()
+{
+    int waitpid = machine->ReadRegister(4);
+    int whichChild;
+
+    // Check if this is my child. If not, return -1.
+    whichChild = currentThread->CheckIfChild (waitpid);
+    if (whichChild == -1) {
+       printf("[pid %d] Cannot join with non-existent child [pid %d].\n", currentThread->GetPID(), waitpid);
+       machine->WriteRegister(2, -1);
     }
-    else if ((which == SyscallException) && (type == SysCall_Yield)) {
-       currentThread->YieldCPU();
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+    else
+       machine->WriteRegister(2, currentThread->JoinWithChild (whichChild));
+    AdvancePC();
+}
+
+// Create, Open, Read, Write and Close are not implemented yet.
+
+static void
+SysCallUnimplemented()
+{
+}
+
+static void
+SysCallFork()
+{
+    NachOSThread *child;
+
+    AdvancePC();
+
+    child = new NachOSThread("Forked thread");
+    child->space = new ProcessAddressSpace (currentThread->space);  // Duplicates the address space
+    if (profiler != NULL)
+       profiler->ForkProcess(child->GetPID(), currentThread->GetPID());
+    child->SaveUserState ();                               // Duplicate the register set
+    child->ResetReturnValue ();                           // Sets the return register to zero
+    child->CreateThreadStack (ForkStartFunction, 0);     // Make it ready for a later context switch
+    child->Schedule ();
+    machine->WriteRegister(2, child->GetPID());              // Return value for parent
+}
+
+static void
+SysCallYield()
+{
+    currentThread->YieldCPU();
+    AdvancePC();
+}
+
+static void
+SysCallPrintInt()
+{
+    int printval = machine->ReadRegister(4);
+    int tempval, exp;
+
+    if (printval == 0) {
+       writeDone->P() ;
+       console->PutChar('0');
     }
-    else if ((which == SyscallException) && (type == SysCall_PrintInt)) {
-       printval = machine->ReadRegister(4);
-       if (printval == 0) {
-	  writeDone->P() ;
-          console->PutChar('0');
+    else {
+       if (printval < 0) {
+          writeDone->P() ;
+          console->PutChar('-');
+          printval = -printval;
+       }
+       tempval = printval;
+       exp=1;
+       while (tempval != 0) {
+          tempval = tempval/10;
+          exp = exp*10;
        }
-       else {
-          if (printval < 0) {
-	     writeDone->P() ;
-             console->PutChar('-');
-             printval = -printval;
-          }
-          tempval = printval;
-          exp=1;
-          while (tempval != 0) {
-             tempval = tempval/10;
-             exp = exp*10;
-          }
+       exp = exp/10;
+       while (exp > 0) {
+          writeDone->P() ;
+          console->PutChar('0'+(printval/exp));
+          printval = printval % exp;
           exp = exp/10;
-          while (exp > 0) {
-	     writeDone->P() ;
-             console->PutChar('0'+(printval/exp));
-             printval = printval % exp;
-             exp = exp/10;
-          }
        }
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
     }
-    else if ((which == SyscallException) && (type == SysCall_PrintChar)) {
-	writeDone->P() ;
-        console->PutChar(machine->ReadRegister(4));   // echo it!
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SysCall_PrintString)) {
-       vaddr = machine->ReadRegister(4);
+    AdvancePC();
+}
+
+static void
+SysCallPrintChar()
+{
+    writeDone->P() ;
+    console->PutChar(machine->ReadRegister(4));   // echo it!
+    AdvancePC();
+}
+
+static void
+SysCallPrintString()
+{
+    int memval;
+    int vaddr = machine->ReadRegister(4);
+
+    machine->ReadMem(vaddr, 1, &memval);
+    while ((*(char*)&memval) != '\0') {
+       writeDone->P() ;
+       console->PutChar(*(char*)&memval);
+       vaddr++;
        machine->ReadMem(vaddr, 1, &memval);
-       while ((*(char*)&memval) != '\0') {
-	  writeDone->P() ;
-          console->PutChar(*(char*)&memval);
-          vaddr++;
-          machine->ReadMem(vaddr, 1, &memval);
-       }
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
     }
-    else if ((which == SyscallException) && (type == SysCall_GetReg)) {
-       machine->WriteRegister(2, machine->ReadRegister(machine->ReadRegister(4))); // Return value
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SysCall_GetPA)) {
-       vaddr = machine->ReadRegister(4);
-       machine->WriteRegister(2, machine->GetPA(vaddr));  // Return value
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+    AdvancePC();
+}
+
+static void
+SysCallGetReg()
+{
+    machine->WriteRegister(2, machine->ReadRegister(machine->ReadRegister(4))); // Return value
+    AdvancePC();
+}
+
+static void
+SysCallGetPA()
+{
+    machine->WriteRegister(2, machine->GetPA(machine->ReadRegister(4)));  // Return value
+    AdvancePC();
+}
+
+static void
+SysCallGetPID()
+{
+    machine->WriteRegister(2, currentThread->GetPID());
+    AdvancePC();
+}
+
+static void
+SysCallGetPPID()
+{
+    machine->WriteRegister(2, currentThread->GetPPID());
+    AdvancePC();
+}
+
+static void
+SysCallSleep()
+{
+    unsigned sleeptime = machine->ReadRegister(4);
+
+    if (sleeptime == 0) {
+       // emulate a yield
+       currentThread->YieldCPU();
     }
-    else if ((which == SyscallException) && (type == SysCall_GetPID)) {
-       machine->WriteRegister(2, currentThread->GetPID());
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+    else {
+       currentThread->SortedInsertInWaitQueue (sleeptime+stats->totalTicks);
     }
-    else if ((which == SyscallException) && (type == SysCall_GetPPID)) {
-       machine->WriteRegister(2, currentThread->GetPPID());
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+    AdvancePC();
+}
+
+static void
+SysCallTime()
+{
+    machine->WriteRegister(2, stats->totalTicks);
+    AdvancePC();
+}
+
+static void
+SysCallPrintIntHex()
+{
+    unsigned printvalus = (unsigned)machine->ReadRegister(4);
+
+    writeDone->P() ;
+    console->PutChar('0');
+    writeDone->P() ;
+    console->PutChar('x');
+    if (printvalus == 0) {
+       writeDone->P() ;
+       console->PutChar('0');
     }
-    else if ((which == SyscallException) && (type == SysCall_Sleep)) {
-       sleeptime = machine->ReadRegister(4);
-       if (sleeptime == 0) {
-          // emulate a yield
-          currentThread->YieldCPU();
-       }
-       else {
-          currentThread->SortedInsertInWaitQueue (sleeptime+stats->totalTicks);
-       }
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+    else {
+       ConvertIntToHex (printvalus, console);
     }
-    else if ((which == SyscallException) && (type == SysCall_Time)) {
-       machine->WriteRegister(2, stats->totalTicks);
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+    AdvancePC();
+}
+
+static void
+SysCallSetRealTime()
+{
+    int period = machine->ReadRegister(4);
+    int budget = machine->ReadRegister(5);
+
+    if (period == 0) {
+       scheduler->LeaveRealTime(currentThread);
+       machine->WriteRegister(2, 0);
     }
-    else if ((which == SyscallException) && (type == SysCall_PrintIntHex)) {
-       printvalus = (unsigned)machine->ReadRegister(4);
-       writeDone->P() ;
-       console->PutChar('0');
-       writeDone->P() ;
-       console->PutChar('x');
-       if (printvalus == 0) {
-          writeDone->P() ;
-          console->PutChar('0');
-       }
-       else {
-          ConvertIntToHex (printvalus, console);
-       }
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+    else if (scheduler->AdmitRealTime(currentThread, period, budget))
+       machine->WriteRegister(2, 0);
+    else
+       machine->WriteRegister(2, -1);
+    AdvancePC();
+}
+
+static void
+SysCallNumInstr()
+{
+    machine->WriteRegister(2, currentThread->GetInstructionCount());
+    AdvancePC();
+}
+
+// The handler and name of each system call, indexed by call code;
+// codes with no system call have a NULL handler.
+
+static VoidNoArgFunctionPtr sysCallTable[NumSysCalls];
+static char *sysCallNames[NumSysCalls];
+
+// Accounting, globally and per process.  Calls that never return
+// (Halt, Exit, and Exec of a valid program) are counted, but have no
+// latency.
+
+static int sysCallCount[NumSysCalls];
+static Histogram *sysCallLatency[NumSysCalls];
+static int processSysCallCount[MAX_THREAD_COUNT][NumSysCalls];
+static int processSysCallTicks[MAX_THREAD_COUNT][NumSysCalls];
+
+//----------------------------------------------------------------------
+// InitSysCallTable
+// 	Fill in sysCallTable, sysCallNames and sysCallLatency.  Called
+//	on the first exception.
+//----------------------------------------------------------------------
+
+static void
+InitSysCallTable()
+{
+    sysCallTable[SysCall_Halt] = SysCallHalt;
+    sysCallTable[SysCall_Exit] = SysCallExit;
+    sysCallTable[SysCall_Exec] = SysCallExec;
+    sysCallTable[SysCall_Join] = SysCallJoin;
+    sysCallTable[SysCall_Create] = SysCallUnimplemented;
+    sysCallTable[SysCall_Open] = SysCallUnimplemented;
+    sysCallTable[SysCall_Read] = SysCallUnimplemented;
+    sysCallTable[SysCall_Write] = SysCallUnimplemented;
+    sysCallTable[SysCall_Close] = SysCallUnimplemented;
+    sysCallTable[SysCall_Fork] = SysCallFork;
+    sysCallTable[SysCall_Yield] = SysCallYield;
+    sysCallTable[SysCall_PrintInt] = SysCallPrintInt;
+    sysCallTable[SysCall_PrintChar] = SysCallPrintChar;
+    sysCallTable[SysCall_PrintString] = SysCallPrintString;
+    sysCallTable[SysCall_GetReg] = SysCallGetReg;
+    sysCallTable[SysCall_GetPA] = SysCallGetPA;
+    sysCallTable[SysCall_GetPID] = SysCallGetPID;
+    sysCallTable[SysCall_GetPPID] = SysCallGetPPID;
+    sysCallTable[SysCall_Sleep] = SysCallSleep;
+    sysCallTable[SysCall_Time] = SysCallTime;
+    sysCallTable[SysCall_PrintIntHex] = SysCallPrintIntHex;
+    sysCallTable[SysCall_SetRealTime] = SysCallSetRealTime;
+    sysCallTable[SysCall_NumInstr] = SysCallNumInstr;
+
+    sysCallNames[SysCall_Halt] = "Halt";
+    sysCallNames[SysCall_Exit] = "Exit";
+    sysCallNames[SysCall_Exec] = "Exec";
+    sysCallNames[SysCall_Join] = "Join";
+    sysCallNames[SysCall_Create] = "Create";
+    sysCallNames[SysCall_Open] = "Open";
+    sysCallNames[SysCall_Read] = "Read";
+    sysCallNames[SysCall_Write] = "Write";
+    sysCallNames[SysCall_Close] = "Close";
+    sysCallNames[SysCall_Fork] = "Fork";
+    sysCallNames[SysCall_Yield] = "Yield";
+    sysCallNames[SysCall_PrintInt] = "PrintInt";
+    sysCallNames[SysCall_PrintChar] = "PrintChar";
+    sysCallNames[SysCall_PrintString] = "PrintString";
+    sysCallNames[SysCall_GetReg] = "GetReg";
+    sysCallNames[SysCall_GetPA] = "GetPA";
+    sysCallNames[SysCall_GetPID] = "GetPID";
+    sysCallNames[SysCall_GetPPID] = "GetPPID";
+    sysCallNames[SysCall_Sleep] = "Sleep";
+    sysCallNames[SysCall_Time] = "Time";
+    sysCallNames[SysCall_PrintIntHex] = "PrintIntHex";
+    sysCallNames[SysCall_SetRealTime] = "SetRealTime";
+    sysCallNames[SysCall_NumInstr] = "NumInstr";
+
+    for (int type = 0; type < NumSysCalls; type++)
+	if (sysCallTable[type] != NULL)
+	    sysCallLatency[type] = new Histogram;
+}
+
+void
+ExceptionHandler(ExceptionType which)
+{
+    int type = machine->ReadRegister(2);
+    int pid = currentThread->GetPID();
+    int startTime = stats->totalTicks;	// for the syscall latency
+    int latency;
+
+    if (!initializedConsoleSemaphores) {
+       readAvail = new Semaphore("read avail", 0);
+       writeDone = new Semaphore("write done", 1);
+       initializedConsoleSemaphores = true;
+       console = new Console(NULL, NULL, ReadAvail, WriteDone, 0);
+       InitSysCallTable();
     }
-    else if ((which == SyscallException) && (type == SysCall_NumInstr)) {
-       machine->WriteRegister(2, currentThread->GetInstructionCount());
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    } else {
+
+    if ((which != SyscallException) || (type < 0) || (type >= NumSysCalls)
+	|| (sysCallTable[type] == NULL)) {
 	printf("Unexpected user mode exception %d %d\n", which, type);
 	ASSERT(FALSE);
     }
+
+    sysCallCount[type]++;
+    processSysCallCount[pid][type]++;
+    currentThread->sysCallInProgress = type;	// for checkpoints
+    (*sysCallTable[type])();
+    currentThread->sysCallInProgress = -1;
+
+    latency = stats->totalTicks - startTime;
+    sysCallLatency[type]->Record(latency);
+    processSysCallTicks[pid][type] += latency;
+    stats->syscallLatencies->Record(latency);
+}
+
+//----------------------------------------------------------------------
+// PrintSysCallStats
+// 	Print how often each system call was made, and how long it took
+//	to return, first over all processes and then for each process.
+//	Called when Nachos halts.
+//----------------------------------------------------------------------
+
+void
+PrintSysCallStats()
+{
+    int type;
+    unsigned pid;
+
+    if (!initializedConsoleSemaphores)
+	return;				// no system call was made
+
+    printf("\nSystem calls (ticks from entry to return):\n");
+    for (type = 0; type < NumSysCalls; type++) {
+	if (sysCallCount[type] == 0)
+	    continue;
+	printf("%s: %d calls, ", sysCallNames[type], sysCallCount[type]);
+	sysCallLatency[type]->Print("returned");
+    }
+
+    for (pid = 0; pid < thread_index; pid++) {
+	bool first = TRUE;
+
+	for (type = 0; type < NumSysCalls; type++) {
+	    if (processSysCallCount[pid][type] == 0)
+		continue;
+	    if (first)
+		printf("pid %d:", pid);
+	    printf(" %s %d (%d ticks)", sysCallNames[type],
+		   processSysCallCount[pid][type],
+		   processSysCallTicks[pid][type]);
+	    first = FALSE;
+	}
+	if (!first)
+	    printf("\n");
+    }
 }
@@ -0,0 +1,302 @@
+// profile.cc
+//	Routines for the sampling profiler of user programs.
+//
+//	Samples are counted per instruction (PC / 4) in an array that
+//	grows to cover the highest PC seen, so a process costs nothing
+//	until it is first sampled.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "profile.h"
+#include "system.h"
+
+#define MaxSymbolLength	128	// longest function name we keep
+
+//----------------------------------------------------------------------
+// SymbolTable::SymbolTable
+// 	Read the functions of a program from "fileName", a listing in the
+//	format of "nm -n": one "<hex address> <type> <name>" per line,
+//	sorted by address.  Only text symbols (types "t" and "T") are
+//	kept.  If the file cannot be opened, the table is empty.
+//----------------------------------------------------------------------
+
+SymbolTable::SymbolTable(char *fileName)
+{
+    FILE *fp = fopen(fileName, "r");
+    char line[2 * MaxSymbolLength], name[MaxSymbolLength];
+    unsigned address;
+    char type;
+    int maxSymbols = 0;
+
+    numSymbols = 0;
+    addresses = NULL;
+    names = NULL;
+    if (fp == NULL)
+	return;
+
+    while (fgets(line, sizeof(line), fp) != NULL)
+	maxSymbols++;
+    addresses = new int[maxSymbols];
+    names = new char *[maxSymbols];
+
+    rewind(fp);
+    while (fgets(line, sizeof(line), fp) != NULL) {
+	if (sscanf(line, "%x %c %127s", &address, &type, name) != 3)
+	    continue;
+	if (type != 't' && type != 'T')
+	    continue;
+	addresses[numSymbols] = address;
+	names[numSymbols] = new char[strlen(name) + 1];
+	strcpy(names[numSymbols], name);
+	numSymbols++;
+    }
+    fclose(fp);
+}
+
+//----------------------------------------------------------------------
+// SymbolTable::~SymbolTable
+// 	De-allocate the symbols.
+//----------------------------------------------------------------------
+
+SymbolTable::~SymbolTable()
+{
+    for (int i = 0; i < numSymbols; i++)
+	delete [] names[i];
+    delete [] names;
+    delete [] addresses;
+}
+
+//----------------------------------------------------------------------
+// SymbolTable::Find
+// 	Return the index of the function containing "address": the last
+//	one starting at or before it.  Binary search.
+//----------------------------------------------------------------------
+
+int
+SymbolTable::Find(int address)
+{
+    int low = 0, high = numSymbols - 1, middle, found = -1;
+
+    while (low <= high) {
+	middle = (low + high) / 2;
+	if (addresses[middle] <= address) {
+	    found = middle;
+	    low = middle + 1;
+	} else
+	    high = middle - 1;
+    }
+    return found;
+}
+
+//----------------------------------------------------------------------
+// Profiler::Profiler
+// 	Initialize a profiler with no samples.
+//
+//	"ticks" is the minimum time between two samples.  Samples are
+//	taken on timer interrupts, so a value below the timer period
+//	samples on every interrupt.
+//----------------------------------------------------------------------
+
+Profiler::Profiler(int ticks)
+{
+    ASSERT(ticks > 0);
+    interval = ticks;
+    nextSample = 0;
+
+    programs = new char *[MAX_THREAD_COUNT];
+    counts = new int *[MAX_THREAD_COUNT];
+    numSlots = new int[MAX_THREAD_COUNT];
+    numSamples = new int[MAX_THREAD_COUNT];
+    for (int i = 0; i < MAX_THREAD_COUNT; i++) {
+	programs[i] = NULL;
+	counts[i] = NULL;
+	numSlots[i] = numSamples[i] = 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// Profiler::~Profiler
+// 	De-allocate the profiler.  Profiles of processes that are still
+//	running are lost.
+//----------------------------------------------------------------------
+
+Profiler::~Profiler()
+{
+    for (int i = 0; i < MAX_THREAD_COUNT; i++) {
+	delete [] programs[i];
+	delete [] counts[i];
+    }
+    delete [] programs;
+    delete [] counts;
+    delete [] numSlots;
+    delete [] numSamples;
+}
+
+//----------------------------------------------------------------------
+// Profiler::StartProcess
+// 	Called when process "pid" starts running "program" (a file name),
+//	discarding any samples of what it ran before.
+//----------------------------------------------------------------------
+
+void
+Profiler::StartProcess(int pid, char *program)
+{
+    ASSERT((pid >= 0) && (pid < MAX_THREAD_COUNT));
+    delete [] programs[pid];
+    delete [] counts[pid];
+    programs[pid] = new char[strlen(program) + 1];
+    strcpy(programs[pid], program);
+    counts[pid] = NULL;
+    numSlots[pid] = numSamples[pid] = 0;
+}
+
+//----------------------------------------------------------------------
+// Profiler::ForkProcess
+// 	Called when "child" is forked from "parent": it runs the same
+//	program, and is profiled separately from now on.
+//----------------------------------------------------------------------
+
+void
+Profiler::ForkProcess(int child, int parent)
+{
+    if (programs[parent] != NULL)
+	StartProcess(child, programs[parent]);
+}
+
+//----------------------------------------------------------------------
+// Profiler::Sample
+// 	Called from the timer interrupt handler while process "pid" is
+//	running user code at "pc".  Count a sample if it is time to.
+//----------------------------------------------------------------------
+
+void
+Profiler::Sample(int pid, int pc)
+{
+    int slot = pc / 4;
+    int size, *larger;
+
+    if (stats->totalTicks < nextSample || programs[pid] == NULL || pc < 0)
+	return;
+    nextSample = stats->totalTicks + interval;
+
+    if (slot >= numSlots[pid]) {		// grow to cover "pc"
+	size = (numSlots[pid] > 0) ? numSlots[pid] : 256;
+	while (size <= slot)
+	    size *= 2;
+	larger = new int[size];
+	for (int i = 0; i < size; i++)
+	    larger[i] = (i < numSlots[pid]) ? counts[pid][i] : 0;
+	delete [] counts[pid];
+	counts[pid] = larger;
+	numSlots[pid] = size;
+    }
+    counts[pid][slot]++;
+    numSamples[pid]++;
+}
+
+//----------------------------------------------------------------------
+// Profiler::ExitProcess
+// 	Called when process "pid" exits: write its profile to
+//	"<program>.<pid>.prof", using the symbols in "<program>.sym".
+//----------------------------------------------------------------------
+
+void
+Profiler::ExitProcess(int pid)
+{
+    char *fileName;
+    SymbolTable *symbols;
+    FILE *fp;
+
+    if (programs[pid] == NULL)
+	return;
+
+    if (numSamples[pid] > 0) {
+	fileName = new char[strlen(programs[pid]) + 32];
+	sprintf(fileName, "%s.sym", programs[pid]);
+	symbols = new SymbolTable(fileName);
+	sprintf(fileName, "%s.%d.prof", programs[pid], pid);
+	fp = fopen(fileName, "w");
+	if (fp == NULL)
+	    perror(fileName);
+	else {
+	    WriteProfile(fp, pid, symbols);
+	    fclose(fp);
+	    DEBUG('t', "Wrote profile of pid %d to %s\n", pid, fileName);
+	}
+	delete symbols;
+	delete [] fileName;
+    }
+
+    delete [] programs[pid];
+    delete [] counts[pid];
+    programs[pid] = NULL;
+    counts[pid] = NULL;
+    numSlots[pid] = numSamples[pid] = 0;
+}
+
+//----------------------------------------------------------------------
+// Profiler::WriteProfile
+// 	Write the flat profile of "pid" to "fp": the samples in each
+//	function, most sampled first, followed by the NumHotInstructions
+//	most sampled instructions.
+//----------------------------------------------------------------------
+
+void
+Profiler::WriteProfile(FILE *fp, int pid, SymbolTable *symbols)
+{
+    int n = symbols->NumSymbols();
+    int *perFunction = new int[n + 1];	// last one: outside any function
+    int i, j, best, which, total = numSamples[pid];
+
+    fprintf(fp, "Flat profile of %s, pid %d: %d samples, at most one "
+	    "every %d ticks\n\n", programs[pid], pid, total, interval);
+
+    for (i = 0; i <= n; i++)
+	perFunction[i] = 0;
+    for (i = 0; i < numSlots[pid]; i++) {
+	if (counts[pid][i] == 0)
+	    continue;
+	which = symbols->Find(i * 4);
+	perFunction[(which < 0) ? n : which] += counts[pid][i];
+    }
+
+    fprintf(fp, "  %%time   samples  function\n");
+    for (;;) {				// selection sort, most first
+	best = -1;
+	for (i = 0; i <= n; i++)
+	    if (perFunction[i] > 0 && (best < 0 || perFunction[i] > perFunction[best]))
+		best = i;
+	if (best < 0)
+	    break;
+	fprintf(fp, "%7.2f %9d  %s\n", 100.0 * perFunction[best] / total,
+		perFunction[best], (best == n) ? "??" : symbols->Name(best));
+	perFunction[best] = 0;
+    }
+
+    fprintf(fp, "\n  %%time   samples  address     function+offset\n");
+    for (j = 0; j < NumHotInstructions; j++) {
+	best = -1;
+	for (i = 0; i < numSlots[pid]; i++)
+	    if (counts[pid][i] > 0 && (best < 0 || counts[pid][i] > counts[pid][best]))
+		best = i;
+	if (best < 0)
+	    break;
+	which = symbols->Find(best * 4);
+	fprintf(fp, "%7.2f %9d  0x%08x  ", 100.0 * counts[pid][best] / total,
+		counts[pid][best], best * 4);
+	if (which < 0)
+	    fprintf(fp, "??\n");
+	else
+	    fprintf(fp, "%s+0x%x\n", symbols->Name(which),
+		    best * 4 - symbols->Address(which));
+	counts[pid][best] = -counts[pid][best];	// don't pick it again
+    }
+    for (i = 0; i < numSlots[pid]; i++)	// undo the negation
+	if (counts[pid][i] < 0)
+	    counts[pid][i] = -counts[pid][i];
+
+    delete [] perFunction;
+}
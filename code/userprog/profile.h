@@ -0,0 +1,77 @@
+// profile.h
+//	Data structures for a sampling profiler of user programs.
+//
+//	When enabled ("-prof <ticks>"), the timer interrupt handler hands
+//	us the user PC of the running process, at most once every <ticks>
+//	ticks.  We count the samples per process and per instruction, and
+//	when the process exits, write a flat profile to
+//	"<program>.<pid>.prof": the share of samples in each function,
+//	followed by the hottest instructions.
+//
+//	NOFF files carry no symbols, so functions are named from
+//	"<program>.sym", a listing of the COFF file's symbol table in the
+//	format of "nm" ("make sort.sym" in ../test).  Without it, the
+//	profile gives addresses only.
+//
+//	Only the CPU that takes the timer interrupt is sampled, so with
+//	"-ncpu" the profile covers a part of each process's run.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "copyright.h"
+#include <stdio.h>
+
+#define NumHotInstructions	10	// instructions listed in a profile
+
+// The following class defines the symbols of one program: the start
+// address and name of each function, in increasing address order.
+
+class SymbolTable {
+  public:
+    SymbolTable(char *fileName);	// read an "nm" listing, if any
+    ~SymbolTable();
+
+    int Find(int address);	// the function containing "address",
+				// -1 if none
+    int NumSymbols() { return numSymbols; }
+    int Address(int which) { return addresses[which]; }
+    char *Name(int which) { return names[which]; }
+
+  private:
+    int numSymbols;
+    int *addresses;
+    char **names;
+};
+
+// The following class defines the profiler.
+
+class Profiler {
+  public:
+    Profiler(int ticks);	// sample at most once every "ticks"
+    ~Profiler();
+
+    void StartProcess(int pid, char *program);	// "pid" runs "program"
+    void ForkProcess(int child, int parent);	// "child" is a copy of
+						// "parent"
+    void Sample(int pid, int pc);	// called on each timer interrupt
+    void ExitProcess(int pid);		// write the profile of "pid"
+
+  private:
+    int interval;		// ticks between two samples
+    int nextSample;		// time of the next sample
+
+    // Per process, indexed by pid:
+    char **programs;		// file being run
+    int **counts;		// samples per instruction
+    int *numSlots;		// size of counts
+    int *numSamples;		// total samples
+
+    void WriteProfile(FILE *fp, int pid, SymbolTable *symbols);
+};
+
+#endif // PROFILE_H
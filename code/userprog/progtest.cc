@@ -32,11 +32,14 @@ LaunchUserProcess(char *filename)
     }
     space = new ProcessAddressSpace(executable);
     currentThread->space = space;
+    if (profiler != NULL)
+	profiler->StartProcess(currentThread->GetPID(), filename);
 
     delete executable;			// close file
 
     space->InitUserModeCPURegisters();		// set the initial register values
     space->RestoreContextOnSwitch();		// load page table register
+    currentThread->sysCallInProgress = -1;	// an Exec does not return
 
     machine->Run();			// jump to the user progam
     ASSERT(FALSE);			// machine->Run never returns;
@@ -62,6 +65,8 @@ LaunchBatchOfProcesses(char executables[][128], int *priorities, int batchSize)
     	thread = new NachOSThread(executables[i]);
     	space = new ProcessAddressSpace(executable);
     	thread->space = space;
+    	if (profiler != NULL)
+    	    profiler->StartProcess(thread->GetPID(), executables[i]);
     	space->InitUserModeCPURegisters();
     	thread->SaveUserState();
     	thread->CreateThreadStack(ForkStartFunction, 0);
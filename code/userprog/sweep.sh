@@ -0,0 +1,93 @@
+#!/bin/bash
+#
+# sweep.sh
+#	Run "nachos -F" over every combination of batch file, scheduling
+#	algorithm, quantum setting and random seed, several runs at a
+#	time, and collect the statistics of each run into one CSV file.
+#
+#	The algorithm on the first line of each batch file is replaced by
+#	the one being tried.  The quantum of the round-robin and priority
+#	algorithms is set by the algorithm number; a quantum setting here
+#	is either "fixed" (use it as is) or an adaptive quantum goal, as
+#	given to "-aq", e.g. "overhead:0.05" or "response:500".
+#
+# Usage: ./sweep.sh [-b "<batch files>"] [-a "<algorithms>"]
+#		[-q "<quantum settings>"] [-s "<seeds>"] [-j <parallel runs>]
+#		[-o <csv file>]
+#
+# Defaults: all of Batch1..Batch6, algorithms 1..10, a fixed quantum,
+# no random yields (seed 0), one run per host CPU, CSV on stdout.
+
+batches="Batch1 Batch2 Batch3 Batch4 Batch5 Batch6"
+algos="1 2 3 4 5 6 7 8 9 10"
+quanta="fixed"
+seeds="0"
+jobs=$(nproc 2>/dev/null || echo 4)
+out=/dev/stdout
+
+while getopts "b:a:q:s:j:o:" opt; do
+    case $opt in
+	b) batches=$OPTARG ;;
+	a) algos=$OPTARG ;;
+	q) quanta=$OPTARG ;;
+	s) seeds=$OPTARG ;;
+	j) jobs=$OPTARG ;;
+	o) out=$OPTARG ;;
+	*) sed -n '/^# Usage/,/^$/p' "$0" >&2; exit 1 ;;
+    esac
+done
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+# Run one configuration, leaving its CSV row in $work/<n>.csv.
+
+run() {
+    local n=$1 batch=$2 algo=$3 quantum=$4 seed=$5
+    local flags="" status
+
+    { echo "$algo"; tail -n +2 "$batch"; } > "$work/$n.batch"
+    [ "$seed" != 0 ] && flags="$flags -rs $seed"
+    [ "$quantum" != fixed ] && flags="$flags -aq ${quantum%%:*} ${quantum#*:}"
+
+    ./nachos $flags -F "$work/$n.batch" > "$work/$n.out" 2>&1
+    status=$?
+
+    awk -v batch="$batch" -v algo="$algo" -v quantum="$quantum" \
+	-v seed="$seed" -v status=$status -v jobs=$(($(grep -c . "$batch") - 1)) '
+	/^Total execution time:/			{ total = $NF }
+	/^CPU utilization:/				{ util = $NF }
+	/^Average waiting time in ready queue:/		{ wait = $NF }
+	/^Number of context switches:/			{ switches = $NF }
+	/^Average thread completion time:/		{ finish = $NF }
+	/^Variance of thread completion times:/		{ variance = $NF }
+	END {
+	    printf "%s,%s,%s,%s,%d,%s,%s,%s,%s,%s,%s,%s,%s\n",
+		batch, algo, quantum, seed, status, jobs, total,
+		(total > 0) ? jobs / total : "", util, wait, switches,
+		finish, variance
+	}' "$work/$n.out" > "$work/$n.csv"
+}
+
+n=0
+for batch in $batches; do
+    for algo in $algos; do
+	for quantum in $quanta; do
+	    for seed in $seeds; do
+		while [ "$(jobs -rp | wc -l)" -ge "$jobs" ]; do
+		    wait -n
+		done
+		run $n "$batch" "$algo" "$quantum" "$seed" &
+		n=$((n + 1))
+	    done
+	done
+    done
+done
+wait
+
+{
+    echo "batch,algorithm,quantum,seed,exit_status,jobs,total_ticks,throughput,cpu_utilization,avg_wait,context_switches,avg_completion,completion_variance"
+    for ((i = 0; i < n; i++)); do
+	cat "$work/$i.csv"
+    done
+} > "$out"
@@ -47,8 +47,12 @@
 
 #define SysCall_PrintIntHex  	20
 
+#define SysCall_SetRealTime	21
+
 #define SysCall_NumInstr	50
 
+#define NumSysCalls		51	/* one more than the largest code */
+
 #ifndef IN_ASM
 
 /* The system call interface.  These are the operations the Nachos
@@ -166,6 +170,16 @@ int syscall_wrapper_GetTime (void);
 
 int syscall_wrapper_GetNumInstr (void);
 
+/* Make the calling thread real-time: it needs "budget" ticks of CPU in
+ * every "period" ticks, and is scheduled earliest-deadline-first ahead
+ * of all other threads.  Each period's work (a "job") ends when the
+ * thread blocks, e.g. in syscall_wrapper_Sleep.  A period of 0 makes
+ * the thread an ordinary one again.
+ * Returns 0 if the reservation was admitted, -1 if the CPU cannot
+ * guarantee it.
+ */
+int syscall_wrapper_SetRealTime (int period, int budget);
+
 #endif /* IN_ASM */
 
 #endif /* SYSCALL_H */
@@ -18,3 +18,9 @@ echo -e "\n===============================\n"
 echo "~~~~VectorSum~~~~"
 ./nachos -x ../test/vectorsum
 echo -e "\n===============================\n"
+echo "~~~~TestDeadline~~~~"
+./nachos -x ../test/testdeadline
+echo -e "\n===============================\n"
+echo "~~~~TestThrottle~~~~"
+./nachos -x ../test/testthrottle
+echo -e "\n===============================\n"